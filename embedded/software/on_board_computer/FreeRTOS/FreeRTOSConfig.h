@@ -64,6 +64,8 @@
 #define configUSE_COUNTING_SEMAPHORES	1
 #define configCHECK_FOR_STACK_OVERFLOW	0
 #define configQUEUE_REGISTRY_SIZE		0
+#define configUSE_QUEUE_SETS			1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES	3 // index 0 free for app use, index 1 for UART TX completion, index 2 for UART RX
 
 
 /* Set the following definitions to 1 to include the API function, or zero
@@ -25,6 +25,9 @@
 /* Lib includes */
 #include "lib_uart.h"
 #include "lib_VC0706.h"
+#include "lib_pool.h"
+#include "lib_jpeg.h"
+#include "lib_aimd.h"
 
 /* app includes */
 #include "app_camera.h"
@@ -33,48 +36,126 @@
 
 #define APP_CAMERA_DEBUG_MSG 0
 
-#define APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE 48
-#define APP_CAMERA_DEFAULT_STREAM_OUT_QUEUE_SIZE 64
-#define APP_CAMERA_DEFAULT_REQUEST_QUEUE_SIZE 10
+#define APP_CAMERA_FRAME_STORE_SIZE (128*1024) // largest JPEG the camera can hand us
+#define APP_CAMERA_FRAME_BUFFERS 3 // one frame being captured while another is still being drained + burst scratch
+#define APP_CAMERA_BURST_SCRATCH (APP_CAMERA_FRAME_BUFFERS - 1) // initial burst scratch buffer, never handed out
+#define APP_CAMERA_MAX_BURST 5
+#define APP_CAMERA_BURST_INTERVAL_MS 100 // time for the camera to grab a fresh frame after resuming
+#define APP_CAMERA_SEGMENT_MIN 512 // smallest READ_FBUF request, one command/header/trailer per segment
+#define APP_CAMERA_SEGMENT_STEP 512 // segment growth after every clean read
+#define APP_CAMERA_SEGMENT_INITIAL 4096
+#define APP_CAMERA_STREAM_IDLE_TIMEOUT_MS 500 // longest the camera may go quiet in the middle of a segment
+#define APP_CAMERA_MAX_STREAMS 6 // queued + capturing + being drained
 #define APP_CAMERA_RESET_DELAY_MS 1000
 #define APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS 100
 #define APP_CAMERA_MUTEX_BLOCKTIME_MS pdMS_TO_TICKS(12)
-#define APP_CAMERA_STREAM_TIMEOUT pdMS_TO_TICKS(120000) // 2 minute timeout per stream
-#define APP_CAMERA_RUN_DELAY_MS 15
+#define APP_CAMERA_STREAM_TIMEOUT pdMS_TO_TICKS(120000) // 2 minute timeout per stream, from capture to last release
+#define APP_CAMERA_SPECULATIVE_MAX_AGE_MS 5000 // default age after which a pre-captured frame is considered stale
+#define APP_CAMERA_PROFILE_NONE 0xFF // camera settings unknown, e.g. after a reset
+#define APP_CAMERA_DEFAULT_PROFILE 1 // used until an upload has been measured
+#define APP_CAMERA_UPLOAD_BUDGET_MS 6000 // longest a frame upload should take on the current link
+#define APP_CAMERA_THROUGHPUT_WEIGHT 4 // new throughput samples count 1/n towards the average
+#define APP_CAMERA_EVENT_SET_SIZE (APP_CAMERA_MAX_STREAMS + 1) // every request slot + the release semaphore
+#define APP_CAMERA_STRIP_METADATA 1 // drop APPn/COM segments before upload, the server only needs the image itself
+#define APP_CAMERA_MAX_RECAPTURES 2 // corrupt frames retaken per stream before giving up
 
 /* private data types */
 
-/* camera image datastream*/
+/* camera image datastream, the image itself lives in one of the frame buffers */
 typedef struct {
-    /* queue containing camera stream datachunks */
-    QueueHandle_t out_q;
     /* datastream id for external apps to claim data */
     alt_u32 id;
     /* stream status */
     app_camera_stream_status_E status;
-    /* number of datachunks that have been received from camera */
-    alt_u32 completed_chunks;
-    /* total chunks in photo */
+    /* number of bytes read from the camera and verified, only these are handed to readers */
+    alt_u32 committed;
+    /* total bytes in photo */
     alt_u32 total_size;
+    /* frame buffer the image is captured into, NULL while queued or once reclaimed */
+    alt_u8* frame;
+    /* references held by the camera task and consumers, the stream is freed when the last one is released */
+    alt_u32 refs;
+    /* tick count when the capture started */
+    TickType_t start_timestamp;
+    /* frames to take, only the best one is kept */
+    alt_u32 shots;
 
 } app_camera_datastream_S;
 
+/* camera settings for one link quality level */
+typedef struct {
+    /* image size */
+    lib_VC0706_size_E size;
+    /* JPEG compression ratio */
+    alt_u8 compression;
+    /* weakest +CSQ RSSI this profile is used at */
+    alt_u8 min_rssi;
+    /* average frame size in bytes, seeded with typical values and tracked from real frames */
+    alt_u32 expected_size;
+} app_camera_profile_S;
+
+/* outcome of reading one segment of a frame */
+typedef enum {
+    APP_CAMERA_SEGMENT_MORE,
+    APP_CAMERA_SEGMENT_READ_ERROR, // camera link trouble, the segment is read again
+    APP_CAMERA_SEGMENT_END, // EOI seen, the frame is complete
+    APP_CAMERA_SEGMENT_CORRUPT // bad JPEG structure or no EOI in the whole frame
+} app_camera_segment_E;
+
 /* application state structure */
 typedef struct {
-    /* request queue */
+    /* request queue, carries stream descriptors already entered in the stream table */
     QueueHandle_t in_q;
-    /* currently running datastream */
-    app_camera_datastream_S* running;
+    /* given whenever a stream is freed, lets the task see frame buffers come back without polling */
+    SemaphoreHandle_t released;
+    /* everything the camera task blocks on */
+    QueueSetHandle_t events;
+    /* requests announced by the queue set but not yet received, owned by the camera task */
+    alt_u32 requests_pending;
+    /* every live stream, queued, capturing or being drained */
+    app_camera_datastream_S* streams[APP_CAMERA_MAX_STREAMS];
+    /* stream being read out of the camera, owned by the camera task */
+    app_camera_datastream_S* capturing;
+    /* frame buffers in use */
+    bool frame_busy[APP_CAMERA_FRAME_BUFFERS];
+    /* burst shots land here and trade places with the stream's frame buffer when they score better */
+    alt_u8* burst_frame;
+    /* burst shots left after the current one */
+    alt_u32 shots_left;
+    /* bytes of the frame in the camera read so far */
+    alt_u32 frame_read;
+    /* size of the frame in the camera as reported by FBUF_LEN, includes the padding past EOI */
+    alt_u32 frame_size;
+    /* parsed bytes in the buffer the frame is landing in */
+    alt_u32 frame_fill;
+    /* checks the frame structure as it comes in */
+    lib_jpeg_parser_S parser;
+    /* corrupt frames retaken for the capturing stream */
+    alt_u32 recaptures;
+    /* best burst shot so far, it sits in the stream's frame buffer */
+    lib_jpeg_score_S best;
+    /* profile the camera is currently set to */
+    alt_u32 profile;
+    /* READ_FBUF segment size, backs off when the camera link drops bytes */
+    lib_aimd_S segment_window;
+    /* last reported modem RSSI */
+    alt_u8 link_rssi;
+    /* average upload throughput in image bytes per second, 0 until measured */
+    alt_u32 link_throughput;
+    /* pre-captured frame waiting for a request, the table holds an extra reference on it for the camera task */
+    app_camera_datastream_S* speculative;
+    /* keep a pre-captured frame ready while idle */
+    bool speculative_enabled;
+    /* age after which the pre-captured frame is replaced */
+    TickType_t speculative_max_age;
+    /* burst length of every pre-capture */
+    alt_u32 speculative_shots;
     /* next assigned stream id */
     alt_u32 next_gen;
-    /* last stream that was finished */
-    alt_u32 last_finished;
-    /* keep track if there is a current stream running */
-    bool stream_running;
-    /* starting timestamp of the current stream */
-    alt_u32 start_timestamp;
-    /* mutex to enable other threads to queue commands */
+    /* mutex protecting the stream table */
     SemaphoreHandle_t mutex;
+    /* optional client progress callback */
+    app_camera_progress_cb progress_cb;
 
 } app_camera_S;
 
@@ -82,10 +163,33 @@ typedef struct {
 /* private data */
 
 static app_camera_S app_camera_state = {
-    .running = 0,
+    .capturing = NULL,
+    .speculative = NULL,
+    .speculative_enabled = false,
+    .speculative_max_age = pdMS_TO_TICKS(APP_CAMERA_SPECULATIVE_MAX_AGE_MS),
+    .speculative_shots = 1,
+    .profile = APP_CAMERA_PROFILE_NONE,
+    .link_rssi = APP_CAMERA_RSSI_UNKNOWN,
+    .link_throughput = 0,
     .next_gen = 0,
-    .last_finished = 0
+    .progress_cb = NULL
+};
+
+/* largest first, the server upscales to 720x480 anyway and 160x120 is too small to recognize a face reliably */
+static app_camera_profile_S app_camera_profiles[] = {
+    {.size = VC0706_SIZE_640x480, .compression = LIB_VC0706_DEFAULT_COMPRESSION, .min_rssi = 15, .expected_size = 48*1024},
+    {.size = VC0706_SIZE_320x240, .compression = LIB_VC0706_DEFAULT_COMPRESSION, .min_rssi = 0, .expected_size = 14*1024},
+    {.size = VC0706_SIZE_320x240, .compression = 0x80, .min_rssi = 0, .expected_size = 8*1024}
 };
+#define APP_CAMERA_PROFILE_COUNT (sizeof(app_camera_profiles) / sizeof(app_camera_profiles[0]))
+
+/* stream descriptors, allocated from a fixed pool to keep the small FreeRTOS heap from fragmenting */
+static lib_pool_S app_camera_stream_pool;
+static alt_u32 app_camera_stream_pool_storage[LIB_POOL_STORAGE_WORDS(sizeof(app_camera_datastream_S),
+                                                                                        APP_CAMERA_MAX_STREAMS)];
+
+/* frame buffers, .bss is linked into the 64MB SDRAM so whole frames fit without touching the heap */
+static alt_u8 app_camera_frame_store[APP_CAMERA_FRAME_BUFFERS][APP_CAMERA_FRAME_STORE_SIZE];
 
 /* private functions */
 
@@ -129,55 +233,364 @@ app_camera_result_E app_camera_reset_due_to_error(void) {
     }
     vTaskDelay(pdMS_TO_TICKS(1000));
 
+    /* camera is back at its power on rate and settings, climb back up */
+    lib_VC0706_increase_baud(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS);
+    app_camera_state.profile = APP_CAMERA_PROFILE_NONE;
+
     return res;
 }
 
 /**
- * @brief deallocated all heap memory associated with camera data stream
+ * @brief pick the largest frame that uploads within budget on the current link
  *
- * @param stream camera stream to vPortFree
+ * @return alt_u32 profile index
  */
-void app_camera_output_stream_free(app_camera_datastream_S* stream) {
+static alt_u32 app_camera_pick_profile(void) {
+    alt_u32 throughput = app_camera_state.link_throughput;
+    alt_u8 rssi = app_camera_state.link_rssi;
 
-    if (pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS)) {
-        /* must vPortFree induvidual dataptrs in queue object since FreeRTOS will only vPortFree direct data */
-        while (uxQueueMessagesWaiting(stream->out_q) > 0) {
-            app_camera_photo_chunk_T* chunk = (app_camera_photo_chunk_T*)pvPortMalloc(sizeof(app_camera_photo_chunk_T));
-            xQueueReceive(stream->out_q, &chunk, APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS);
-            alt_u8* dataptr = chunk->dataptr;
-            vPortFree(dataptr);
+    if (throughput == 0) {
+        return APP_CAMERA_DEFAULT_PROFILE;
+    }
+
+    for (alt_u32 i = 0; i < APP_CAMERA_PROFILE_COUNT; i++) {
+        /* unknown signal is treated as weak */
+        if ((app_camera_profiles[i].min_rssi != 0) &&
+            ((rssi == APP_CAMERA_RSSI_UNKNOWN) || (rssi < app_camera_profiles[i].min_rssi))) {
+            continue;
+        }
+        if (((app_camera_profiles[i].expected_size * 1000) / throughput) <= APP_CAMERA_UPLOAD_BUDGET_MS) {
+            return i;
         }
+    }
+    return APP_CAMERA_PROFILE_COUNT - 1;
+}
 
-        /* vPortFree the queue itself */
-        vQueueDelete(stream->out_q);
-        /* vPortFree the output stream data */
-        vPortFree(stream);
-        xSemaphoreGive(app_camera_state.mutex);
+/**
+ * @brief move the camera to the profile the link calls for, only talks to the camera when the profile changes
+ *
+ */
+static void app_camera_apply_profile(void) {
+    alt_u32 profile = app_camera_pick_profile();
+
+    if (profile != app_camera_state.profile) {
+        if ((lib_VC0706_cmd_set_image_size(app_camera_profiles[profile].size, APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) ==
+                                                                                                VC0706_SUCCESS) &&
+            (lib_VC0706_cmd_set_compression(app_camera_profiles[profile].compression,
+                                                            APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) == VC0706_SUCCESS)) {
+            app_camera_state.profile = profile;
+#if (APP_CAMERA_DEBUG_MSG == 1)
+            printf("camera profile %d\n", profile);
+#endif
+            /* let the camera grab a frame with the new settings */
+            vTaskDelay(pdMS_TO_TICKS(APP_CAMERA_BURST_INTERVAL_MS));
+        } else {
+            /* half applied, try again next capture */
+            app_camera_state.profile = APP_CAMERA_PROFILE_NONE;
+        }
+    }
+}
+
+/**
+ * @brief fold a captured frame size into the expected size of the current profile
+ *
+ * @param size frame size in bytes
+ */
+static void app_camera_track_frame_size(alt_u32 size) {
+    if (app_camera_state.profile < APP_CAMERA_PROFILE_COUNT) {
+        app_camera_profile_S* profile = &app_camera_profiles[app_camera_state.profile];
+        profile->expected_size = ((profile->expected_size * 3) + size) / 4;
+    }
+}
+
+/**
+ * @brief find a live stream by id, caller must hold the mutex
+ *
+ * @param id stream id
+ * @return app_camera_datastream_S* stream, NULL if the id is not in the table
+ */
+static app_camera_datastream_S* app_camera_find_stream(alt_u32 id) {
+    for (alt_u32 i = 0; i < APP_CAMERA_MAX_STREAMS; i++) {
+        app_camera_datastream_S* stream = app_camera_state.streams[i];
+        if ((stream != NULL) && (stream->id == id)) {
+            return stream;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief hand a frame buffer back, caller must hold the mutex
+ *
+ * @param stream stream holding the buffer
+ */
+static void app_camera_reclaim_frame(app_camera_datastream_S* stream) {
+    if (stream->frame != NULL) {
+        app_camera_state.frame_busy[(stream->frame - app_camera_frame_store[0]) / APP_CAMERA_FRAME_STORE_SIZE] = false;
+        stream->frame = NULL;
+    }
+}
+
+/**
+ * @brief drop one reference, the last one frees the frame buffer and the descriptor. Caller must hold the mutex.
+ *
+ * @param stream stream to release
+ */
+static void app_camera_put_stream(app_camera_datastream_S* stream) {
+    if (--stream->refs > 0) {
+        return;
+    }
+
+    for (alt_u32 i = 0; i < APP_CAMERA_MAX_STREAMS; i++) {
+        if (app_camera_state.streams[i] == stream) {
+            app_camera_state.streams[i] = NULL;
+        }
+    }
+    app_camera_reclaim_frame(stream);
+    lib_pool_free(&app_camera_stream_pool, stream);
+    xSemaphoreGive(app_camera_state.released);
+}
+
+/**
+ * @brief check if the pre-captured frame is young enough to hand out, caller must hold the mutex
+ *
+ * @param now current tick count
+ * @return true if there is a usable pre-captured frame
+ */
+static bool app_camera_speculative_fresh(TickType_t now) {
+    app_camera_datastream_S* stream = app_camera_state.speculative;
+    return (stream != NULL) && (stream->frame != NULL) &&
+            ((stream->status == CAMERA_STREAM_RUNNING) || (stream->status == CAMERA_STREAM_DONE)) &&
+            ((now - stream->start_timestamp) < app_camera_state.speculative_max_age);
+}
+
+/**
+ * @brief let go of the pre-captured frame, caller must hold the mutex
+ *
+ */
+static void app_camera_drop_speculative(void) {
+    if (app_camera_state.speculative != NULL) {
+        app_camera_datastream_S* stream = app_camera_state.speculative;
+        app_camera_state.speculative = NULL;
+        app_camera_put_stream(stream);
+    }
+}
+
+/**
+ * @brief allocate a stream descriptor and enter it in the table, caller must hold the mutex
+ *
+ * @param refs initial references
+ * @param shots burst length
+ * @return app_camera_datastream_S* new stream, NULL if the table is full
+ */
+static app_camera_datastream_S* app_camera_new_stream(alt_u32 refs, alt_u32 shots) {
+    app_camera_datastream_S* new_stream = (app_camera_datastream_S*)lib_pool_alloc(&app_camera_stream_pool);
+
+    if (new_stream != NULL) {
+        *new_stream = (app_camera_datastream_S){
+            .id = app_camera_state.next_gen,
+            .status = CAMERA_STREAM_IN_QUEUE,
+            .committed = 0,
+            .total_size = 0,
+            .frame = NULL,
+            .refs = refs,
+            .start_timestamp = 0,
+            .shots = (shots == 0) ? 1 : ((shots > APP_CAMERA_MAX_BURST) ? APP_CAMERA_MAX_BURST : shots)
+        };
+        /* the pool holds as many descriptors as the table has slots */
+        for (alt_u32 i = 0; i < APP_CAMERA_MAX_STREAMS; i++) {
+            if (app_camera_state.streams[i] == NULL) {
+                app_camera_state.streams[i] = new_stream;
+                break;
+            }
+        }
+        app_camera_state.next_gen++;
+    }
+
+    return new_stream;
+}
+
+/**
+ * @brief camera task drops its capture reference
+ *
+ * @param stream stream that finished or failed capturing
+ */
+static void app_camera_end_capture(app_camera_datastream_S* stream) {
+    app_camera_state.capturing = NULL;
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    app_camera_put_stream(stream);
+    xSemaphoreGive(app_camera_state.mutex);
+}
+
+/**
+ * @brief start reading a new frame out of the camera
+ *
+ * @param size frame size reported by FBUF_LEN
+ */
+static void app_camera_begin_frame(alt_u32 size) {
+    app_camera_state.frame_read = 0;
+    app_camera_state.frame_size = size;
+    app_camera_state.frame_fill = 0;
+    lib_jpeg_parser_init(&app_camera_state.parser, APP_CAMERA_STRIP_METADATA);
+}
+
+/**
+ * @brief let the camera grab a fresh frame and freeze it for reading, resets the camera if it gets stuck
+ *
+ * @return app_camera_result_E CAMERA_ERROR if there is no new frame, the camera is left running
+ */
+static app_camera_result_E app_camera_retake(void) {
+    /* enable camera frame buffer to update */
+    bool resumed = (lib_VC0706_cmd_start_frame(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) == VC0706_SUCCESS);
+    if (resumed) {
+        vTaskDelay(pdMS_TO_TICKS(APP_CAMERA_BURST_INTERVAL_MS));
+        alt_u32 picturesize = 0;
+        if ((app_camera_take_picture_get_data_size(&picturesize) == CAMERA_SUCCESS) &&
+                                                                (picturesize <= APP_CAMERA_FRAME_STORE_SIZE)) {
+            app_camera_begin_frame(picturesize);
+            return CAMERA_SUCCESS;
+        }
+        /* the frame may still be frozen, let it go */
+        resumed = (lib_VC0706_cmd_start_frame(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) == VC0706_SUCCESS);
+    }
+    if (!resumed) {
+        app_camera_reset_due_to_error();
     }
+    return CAMERA_ERROR;
 }
 
+/**
+ * @brief read the next segment of the frame in the camera and check it. Raw data lands right after the parsed data
+ *        and is compacted in place, so stripped segments never reach readers. Reading stops at EOI, the camera's
+ *        padding past it is never transferred.
+ *
+ * @param frame frame buffer the picture lands in
+ * @return app_camera_segment_E
+ */
+static app_camera_segment_E app_camera_read_segment(alt_u8* frame) {
+    alt_u32 start_addr = app_camera_state.frame_read;
+    alt_u32 number_bytes_left = app_camera_state.frame_size - start_addr;
+    alt_u32 segment_size = lib_aimd_size(&app_camera_state.segment_window);
+    alt_u32 number_bytes = (number_bytes_left > segment_size) ? segment_size : number_bytes_left;
+    alt_u32 fill = app_camera_state.frame_fill;
+
+    /* a failed segment is re-read smaller, the parser never saw it */
+    if (lib_VC0706_cmd_stream_fbuf_data(frame + fill, start_addr, number_bytes, NULL, NULL,
+                                                                APP_CAMERA_STREAM_IDLE_TIMEOUT_MS) != VC0706_SUCCESS) {
+        lib_aimd_failure(&app_camera_state.segment_window);
+        return APP_CAMERA_SEGMENT_READ_ERROR;
+    }
+    lib_aimd_success(&app_camera_state.segment_window);
 
+    app_camera_state.frame_read = start_addr + number_bytes;
+    app_camera_state.frame_fill = lib_jpeg_parse(&app_camera_state.parser, frame, fill, number_bytes);
+
+    if (app_camera_state.parser.status == LIB_JPEG_PARSE_END) {
+        /* upload budgets go by what is actually sent */
+        app_camera_track_frame_size(app_camera_state.frame_fill);
+        return APP_CAMERA_SEGMENT_END;
+    }
+    if ((app_camera_state.parser.status == LIB_JPEG_PARSE_ERROR) ||
+                                                    (app_camera_state.frame_read >= app_camera_state.frame_size)) {
+#if (APP_CAMERA_DEBUG_MSG == 1)
+        printf("corrupt frame at %d of %d\n", app_camera_state.frame_read, app_camera_state.frame_size);
+#endif
+        return APP_CAMERA_SEGMENT_CORRUPT;
+    }
+    return APP_CAMERA_SEGMENT_MORE;
+}
 
 /* public API */
 
 /**
- * @brief schedule a photo
+ * @brief schedule a burst of photos, only the best frame is kept. Frames are scored on sharpness and exposure from
+ *        their JPEG coefficients. The caller holds a reference to the new stream and must hand it back with
+ *        app_camera_release_stream once it is done reading, even if the capture fails. If a fresh pre-captured frame
+ *        from a burst at least as long is available it is handed over instead, so reading can start right away.
+ *
+ * @param camera_stream_id streamid for client to access datastream
+ * @param shots frames to take, clamped to APP_CAMERA_MAX_BURST
+ * @return app_camera_result_E CAMERA_ERROR if the stream table is full
+ */
+app_camera_result_E app_camera_schedule_burst(alt_u32* camera_stream_id, alt_u32 shots) {
+    app_camera_result_E res = CAMERA_ERROR;
+
+    if (pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS)) {
+        if (app_camera_speculative_fresh(xTaskGetTickCount()) && (app_camera_state.speculative->shots >= shots)) {
+            /* the camera task's hold on the frame becomes the caller's reference */
+            *camera_stream_id = app_camera_state.speculative->id;
+            app_camera_state.speculative = NULL;
+            /* wake the camera task to pre-capture the next one */
+            xSemaphoreGive(app_camera_state.released);
+            res = CAMERA_SUCCESS;
+        } else {
+            app_camera_datastream_S* new_stream = app_camera_new_stream(2, shots); // caller + camera task
+            if (new_stream != NULL) {
+                *camera_stream_id = new_stream->id;
+                xQueueSend(app_camera_state.in_q, &new_stream, 0);
+                res = CAMERA_SUCCESS;
+            }
+        }
+        xSemaphoreGive(app_camera_state.mutex);
+    }
+
+    return res;
+}
+
+/**
+ * @brief schedule a photo, see app_camera_schedule_burst
  *
  * @param camera_stream_id streamid for client to access datastream
  * @return app_camera_result_E
  */
 app_camera_result_E app_camera_schedule_picture(alt_u32* camera_stream_id) {
-    app_camera_result_E res = CAMERA_ERROR;
+    return app_camera_schedule_burst(camera_stream_id, 1);
+}
 
-    if ((pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS)) &&
-                                                                    uxQueueSpacesAvailable(app_camera_state.in_q) > 0) {
-        app_camera_datastream_S* new_stream = (app_camera_datastream_S*)pvPortMalloc(sizeof(app_camera_datastream_S));
-        new_stream->id = app_camera_state.next_gen;
-        *camera_stream_id = app_camera_state.next_gen;
-        app_camera_state.next_gen++;
-        xQueueSend(app_camera_state.in_q, new_stream, APP_CAMERA_MUTEX_BLOCKTIME_MS);
-        vPortFree(new_stream);
+/**
+ * @brief keep a pre-captured frame ready while idle so a picture request can start uploading without waiting for the
+ *        camera. Frames older than max_age_ms are replaced, disabling releases the current one.
+ *
+ * @param enable true to keep a frame ready
+ * @param max_age_ms age after which a pre-captured frame is stale, clamped below the stream timeout
+ * @param shots burst length of every pre-capture
+ */
+void app_camera_set_speculative(bool enable, alt_u32 max_age_ms, alt_u32 shots) {
+    TickType_t max_age = pdMS_TO_TICKS(max_age_ms);
+    if (max_age >= APP_CAMERA_STREAM_TIMEOUT) {
+        max_age = APP_CAMERA_STREAM_TIMEOUT - 1;
+    }
 
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    if ((enable != app_camera_state.speculative_enabled) || (max_age != app_camera_state.speculative_max_age) ||
+                                                                    (shots != app_camera_state.speculative_shots)) {
+        app_camera_state.speculative_enabled = enable;
+        app_camera_state.speculative_max_age = max_age;
+        app_camera_state.speculative_shots = shots;
+        if (!enable) {
+            app_camera_drop_speculative();
+        }
+        /* let the camera task pick up the new setting */
+        xSemaphoreGive(app_camera_state.released);
+    }
+    xSemaphoreGive(app_camera_state.mutex);
+}
+
+/**
+ * @brief take an extra reference to a stream so another consumer can read the same frame
+ *
+ * @param id stream id
+ * @return app_camera_result_E CAMERA_ERROR if the stream no longer exists
+ */
+app_camera_result_E app_camera_acquire_stream(alt_u32 id) {
+    app_camera_result_E res = CAMERA_ERROR;
+
+    if (pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS)) {
+        app_camera_datastream_S* stream = app_camera_find_stream(id);
+        if (stream != NULL) {
+            stream->refs++;
+            res = CAMERA_SUCCESS;
+        }
         xSemaphoreGive(app_camera_state.mutex);
     }
 
@@ -185,25 +598,48 @@ app_camera_result_E app_camera_schedule_picture(alt_u32* camera_stream_id) {
 }
 
 /**
- * @brief get camera stream data
+ * @brief hand back a reference taken by app_camera_schedule_picture or app_camera_acquire_stream. Data read from the
+ *        stream must not be touched afterwards.
  *
- * @param outchunk new camera data
- * @param id stream id, must match currently streaming photo
- * @return app_camera_result_E
+ * @param id stream id
+ */
+void app_camera_release_stream(alt_u32 id) {
+    /* a lost release would pin a frame buffer until the stream times out, so wait for the lock */
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    app_camera_datastream_S* stream = app_camera_find_stream(id);
+    if (stream != NULL) {
+        app_camera_put_stream(stream);
+    }
+    xSemaphoreGive(app_camera_state.mutex);
+}
+
+/**
+ * @brief read camera stream data at an offset, every consumer keeps its own offset. The chunk points into the frame
+ *        buffer and stays valid while the consumer holds its reference, it must not be freed.
+ *
+ * @param id stream id
+ * @param offset image offset to read from
+ * @param max largest chunk the consumer can take in bytes
+ * @param data output pointer to the chunk
+ * @param size output chunk size in bytes, at most max
+ * @param last output set if the chunk ends the image, the final size is only known once the camera reaches EOI
+ * @return app_camera_result_E CAMERA_ERROR if no data past offset has been captured yet
  */
-app_camera_result_E app_camera_get_next_stream_chunk(alt_u8** data, alt_u32* size, alt_u32 id) {
+app_camera_result_E app_camera_read_stream(alt_u32 id, alt_u32 offset, alt_u32 max, alt_u8** data, alt_u32* size,
+                                                                                                    bool* last) {
     app_camera_result_E res = CAMERA_ERROR;
 
-    /* only send data out if the client is the correct recipient */
-    if (app_camera_state.stream_running && (pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS))) {
-        if ((id == app_camera_state.running->id) && (uxQueueMessagesWaiting(app_camera_state.running->out_q) > 0)) {
-            app_camera_photo_chunk_T outchunk;
-            xQueueReceive(app_camera_state.running->out_q, &outchunk, APP_CAMERA_MUTEX_BLOCKTIME_MS);
-            *size = outchunk.size;
-            *data = outchunk.dataptr;
+    if (pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS)) {
+        app_camera_datastream_S* stream = app_camera_find_stream(id);
+        if ((stream != NULL) && (stream->frame != NULL) && (stream->status != CAMERA_STREAM_CRITICAL_ERROR) &&
+                                                                                    (stream->committed > offset)) {
+            alt_u32 available = stream->committed - offset;
+            *size = (available > max) ? max : available;
+            *data = stream->frame + offset;
+            *last = (stream->status == CAMERA_STREAM_DONE) && ((offset + *size) == stream->total_size);
             res = CAMERA_SUCCESS;
 #if (APP_CAMERA_DEBUG_MSG == 1)
-            printf("reading chunk id %d, size %d\n", outchunk.id, *size);
+            printf("reading chunk at %d, size %d\n", offset, *size);
 #endif
         }
         xSemaphoreGive(app_camera_state.mutex);
@@ -212,142 +648,481 @@ app_camera_result_E app_camera_get_next_stream_chunk(alt_u8** data, alt_u32* siz
     return res;
 }
 
+/**
+ * @brief report how the upload link is doing, the next capture is sized so it uploads within
+ *        APP_CAMERA_UPLOAD_BUDGET_MS
+ *
+ * @param rssi modem +CSQ RSSI, APP_CAMERA_RSSI_UNKNOWN if not known
+ * @param bytes image bytes uploaded
+ * @param elapsed_ms time the upload took
+ */
+void app_camera_report_link(alt_u8 rssi, alt_u32 bytes, alt_u32 elapsed_ms) {
+    app_camera_state.link_rssi = rssi;
+    if ((bytes != 0) && (elapsed_ms != 0)) {
+        alt_u32 sample = (bytes < (0xFFFFFFFF / 1000)) ? ((bytes * 1000) / elapsed_ms) : ((bytes / elapsed_ms) * 1000);
+        alt_u32 average = app_camera_state.link_throughput;
+        app_camera_state.link_throughput = (average == 0) ? sample :
+                        (((average * (APP_CAMERA_THROUGHPUT_WEIGHT - 1)) + sample) / APP_CAMERA_THROUGHPUT_WEIGHT);
+    }
+}
+
+/**
+ * @brief get occupancy of the stream descriptor pool
+ *
+ * @param stats output pool occupancy
+ */
+void app_camera_get_stream_pool_stats(lib_pool_stats_S* stats) {
+    lib_pool_get_stats(&app_camera_stream_pool, stats);
+}
+
+/**
+ * @brief register a callback for image data landing in a frame buffer, called from the camera task
+ *
+ * @param cb callback, NULL to disable
+ */
+void app_camera_set_progress_callback(app_camera_progress_cb cb) {
+    app_camera_state.progress_cb = cb;
+}
+
 /**
  * @brief get the status of a specific camera stream
  *
  * @param id stream id to check
- * @return app_camera_stream_status_E
+ * @return app_camera_stream_status_E CAMERA_STREAM_UNKNOWN once every reference has been released
  */
 app_camera_stream_status_E app_camera_get_stream_status(alt_u32 id) {
-    app_camera_stream_status_E stream = CAMERA_STREAM_UNKNOWN;
+    app_camera_stream_status_E status = CAMERA_STREAM_UNKNOWN;
 
-    /* if there is a stream currently running we check there first */
-    if ((app_camera_state.stream_running) && (id == app_camera_state.running->id)) {
-        stream = app_camera_state.running->status;
-    } else if ((id > app_camera_state.last_finished) && (id < app_camera_state.next_gen)) {
-        stream = CAMERA_STREAM_IN_QUEUE;
+    if (pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS)) {
+        app_camera_datastream_S* stream = app_camera_find_stream(id);
+        if (stream != NULL) {
+            status = stream->status;
+        }
+        xSemaphoreGive(app_camera_state.mutex);
     }
 
-    return stream;
+    return status;
 }
 
 /**
- * @brief get picture length in bytes for given stream (if known). returns 0 if unknown
+ * @brief get picture length in bytes for given stream (if known). returns 0 if unknown. While the stream is running
+ *        this is the size the camera reported, the finished image can come in shorter once padding and stripped
+ *        segments are left out.
  *
  * @param id stream id to check
  * @return alt_u32
  */
 alt_u32 app_camera_get_image_size(alt_u32 id) {
-    if ((app_camera_state.stream_running) && (id == app_camera_state.running->id)) {
-        return app_camera_state.running->total_size;
+    alt_u32 size = 0;
+
+    if (pdTRUE == xSemaphoreTake(app_camera_state.mutex, APP_CAMERA_MUTEX_BLOCKTIME_MS)) {
+        app_camera_datastream_S* stream = app_camera_find_stream(id);
+        if (stream != NULL) {
+            size = stream->total_size;
+        }
+        xSemaphoreGive(app_camera_state.mutex);
+    }
+
+    return size;
+}
+
+/**
+ * @brief take a picture into a free frame buffer
+ *
+ * @param new_stream queued or speculative stream
+ * @param frame free frame buffer index
+ * @return app_camera_result_E
+ */
+static app_camera_result_E app_camera_start_stream(app_camera_datastream_S* new_stream, alt_u32 frame) {
+    app_camera_result_E res = CAMERA_ERROR;
+    alt_u32 picturesize = 0;
+
+    /* size the frame for the link it will be uploaded over */
+    app_camera_apply_profile();
+
+    /* "take picture", verify we can start stream properly, if not set error status and restart camera */
+    if ((app_camera_take_picture_get_data_size(&picturesize) != CAMERA_ERROR) &&
+                                                            (picturesize <= APP_CAMERA_FRAME_STORE_SIZE)) {
+#if (APP_CAMERA_DEBUG_MSG == 1)
+        printf("picturesize: %d", picturesize);
+#endif
+        app_camera_begin_frame(picturesize);
+        app_camera_state.recaptures = 0;
+        xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+        app_camera_state.frame_busy[frame] = true;
+        new_stream->frame = app_camera_frame_store[frame];
+        new_stream->committed = 0;
+        new_stream->total_size = picturesize;
+        new_stream->start_timestamp = xTaskGetTickCount();
+        new_stream->status = CAMERA_STREAM_RUNNING;
+        if (new_stream->shots > 1) {
+            /* readers only get to see the winning shot */
+            new_stream->total_size = 0;
+            app_camera_state.shots_left = new_stream->shots - 1;
+            app_camera_state.best.size = 0;
+        }
+        xSemaphoreGive(app_camera_state.mutex);
+        app_camera_state.capturing = new_stream;
+        res = CAMERA_SUCCESS;
+        /* TODO: add stream start callback notification */
+    } else {
+        /* TODO: add error callback notification */
+        new_stream->status = CAMERA_STREAM_CRITICAL_ERROR;
+        app_camera_end_capture(new_stream);
+        app_camera_reset_due_to_error();
+    }
+
+    return res;
+}
+
+/**
+ * @brief refresh the pre-captured frame. The old frame is only let go once the new capture is underway, so a request
+ *        arriving in between still gets a frame.
+ *
+ * @param frame free frame buffer index
+ */
+static void app_camera_start_speculative(alt_u32 frame) {
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    app_camera_datastream_S* new_stream = app_camera_new_stream(2, app_camera_state.speculative_shots); // capture + hold
+    xSemaphoreGive(app_camera_state.mutex);
+
+    if ((new_stream != NULL) && (app_camera_start_stream(new_stream, frame) == CAMERA_SUCCESS)) {
+        xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+        app_camera_drop_speculative();
+        if (app_camera_state.speculative_enabled) {
+            app_camera_state.speculative = new_stream;
+        } else {
+            /* disabled while the capture was starting */
+            app_camera_put_stream(new_stream);
+        }
+        xSemaphoreGive(app_camera_state.mutex);
+    } else if (new_stream != NULL) {
+        /* start_stream already dropped the capture reference */
+        xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+        app_camera_put_stream(new_stream);
+        xSemaphoreGive(app_camera_state.mutex);
+    }
+}
+
+/**
+ * @brief work out if a pre-captured frame should be taken now
+ *
+ * @param wait in: current block time, out: shortened to when the current frame goes stale
+ * @return true if a new frame should be pre-captured
+ */
+static bool app_camera_speculative_due(TickType_t* wait) {
+    bool due = false;
+    TickType_t now = xTaskGetTickCount();
+
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    if (app_camera_state.speculative_enabled) {
+        lib_pool_stats_S pool;
+        lib_pool_get_stats(&app_camera_stream_pool, &pool);
+        if (!app_camera_speculative_fresh(now)) {
+            /* no descriptor to spare, a release will wake us */
+            due = (pool.used < pool.block_count);
+        } else {
+            TickType_t left = app_camera_state.speculative_max_age - (now - app_camera_state.speculative->start_timestamp);
+            if (left < *wait) {
+                *wait = left;
+            }
+        }
+    }
+    xSemaphoreGive(app_camera_state.mutex);
+
+    return due;
+}
+
+/**
+ * @brief read the next segment of the capturing stream, restart the frame buffer once the whole picture is in. Nothing
+ *        is handed to readers until the headers have been checked, a frame found corrupt before then is quietly
+ *        retaken. Later corruption fails the stream so the frame is not uploaded to the end.
+ *
+ * @param stream capturing stream
+ */
+static void app_camera_service_stream(app_camera_datastream_S* stream) {
+    alt_u32 published = stream->committed;
+
+    /* stream the next segment straight into the frame buffer */
+    switch (app_camera_read_segment(stream->frame)) {
+        case APP_CAMERA_SEGMENT_READ_ERROR:
+#if (APP_CAMERA_DEBUG_MSG == 1)
+            printf("Segment error at %d\n", app_camera_state.frame_read);
+#endif
+            /* failed segments usually mean a noisy line, fall back to a slower rate if errors spiked */
+            if (lib_VC0706_check_baud(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) != VC0706_SUCCESS) {
+                app_camera_reset_due_to_error();
+            }
+            return;
+
+        case APP_CAMERA_SEGMENT_MORE:
+            if (app_camera_state.parser.scans > 0) {
+                stream->committed = app_camera_state.frame_fill - app_camera_state.parser.held;
+            }
+            break;
+
+        case APP_CAMERA_SEGMENT_END:
+            /* size and status change together so readers can tell the last chunk */
+            xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+            stream->total_size = app_camera_state.frame_fill;
+            stream->committed = app_camera_state.frame_fill;
+            stream->status = CAMERA_STREAM_DONE;
+            xSemaphoreGive(app_camera_state.mutex);
+            break;
+
+        case APP_CAMERA_SEGMENT_CORRUPT:
+            if ((published == 0) && (app_camera_state.recaptures < APP_CAMERA_MAX_RECAPTURES)) {
+                app_camera_state.recaptures++;
+                if (app_camera_retake() == CAMERA_SUCCESS) {
+                    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+                    stream->total_size = app_camera_state.frame_size;
+                    xSemaphoreGive(app_camera_state.mutex);
+                    return;
+                }
+            } else {
+                lib_VC0706_cmd_start_frame(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS);
+            }
+            /* TODO: add error callback notification */
+            stream->status = CAMERA_STREAM_CRITICAL_ERROR;
+            app_camera_end_capture(stream);
+            return;
+    }
+
+#if (APP_CAMERA_DEBUG_MSG == 1)
+    printf("got segment, %d of %d bytes\n", stream->committed, stream->total_size);
+#endif
+    if ((app_camera_state.progress_cb != NULL) && (stream->committed > published)) {
+        app_camera_state.progress_cb(stream->id, published, stream->committed - published, stream->total_size);
+    }
+
+    /* we have read the whole picture */
+    if (stream->status == CAMERA_STREAM_DONE) {
+        /* the frame stays with its readers, the camera is free for the next capture */
+        app_camera_end_capture(stream);
+        /* enable camera frame buffer to update, if operation fails then reset camera */
+        if (lib_VC0706_cmd_start_frame(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) != VC0706_SUCCESS) {
+            app_camera_reset_due_to_error();
+        }
+    }
+}
+
+/**
+ * @brief compare two burst shots, unscored shots lose to scored ones and are otherwise compared on size
+ *
+ * @param a candidate shot
+ * @param b best shot so far
+ * @return true if a is better
+ */
+static bool app_camera_better_shot(const lib_jpeg_score_S* a, const lib_jpeg_score_S* b) {
+    if (a->score != b->score) {
+        return a->score > b->score;
+    }
+    return a->size > b->size;
+}
+
+/**
+ * @brief make the best burst shot visible to readers and hand the camera back
+ *
+ * @param stream capturing stream
+ */
+static void app_camera_publish_burst(app_camera_datastream_S* stream) {
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    if (app_camera_state.best.size != 0) {
+        stream->total_size = app_camera_state.best.size;
+        stream->committed = app_camera_state.best.size;
+        stream->status = CAMERA_STREAM_DONE;
     } else {
-        return 0;
+        stream->status = CAMERA_STREAM_CRITICAL_ERROR;
     }
+    xSemaphoreGive(app_camera_state.mutex);
+
+    if (app_camera_state.progress_cb != NULL) {
+        app_camera_state.progress_cb(stream->id, 0, stream->committed, stream->total_size);
+    }
+    app_camera_end_capture(stream);
 }
 
+/**
+ * @brief read the next segment of a burst shot into the scratch buffer. A finished shot is scored and kept if it beats
+ *        the best so far, a corrupt one is retaken. Then the camera is resumed for the next shot.
+ *
+ * @param stream capturing stream
+ */
+static void app_camera_service_burst(app_camera_datastream_S* stream) {
+    app_camera_segment_E segment = app_camera_read_segment(app_camera_state.burst_frame);
 
+    if (segment == APP_CAMERA_SEGMENT_READ_ERROR) {
+        /* failed segments usually mean a noisy line, fall back to a slower rate if errors spiked */
+        if (lib_VC0706_check_baud(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) != VC0706_SUCCESS) {
+            app_camera_reset_due_to_error();
+        }
+        return;
+    }
+    if (segment == APP_CAMERA_SEGMENT_MORE) {
+        return;
+    }
+
+    if (segment == APP_CAMERA_SEGMENT_END) {
+        lib_jpeg_score_S score;
+        lib_jpeg_score(app_camera_state.burst_frame, app_camera_state.frame_fill, &score);
+#if (APP_CAMERA_DEBUG_MSG == 1)
+        printf("shot %d: size %d luma %d sharpness %d score %d\n", stream->shots - app_camera_state.shots_left,
+                                                        score.size, score.mean_luma, score.sharpness, score.score);
+#endif
+        if ((app_camera_state.best.size == 0) || app_camera_better_shot(&score, &app_camera_state.best)) {
+            /* trade buffers instead of copying, the old best becomes the scratch */
+            xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+            alt_u8* frame = stream->frame;
+            stream->frame = app_camera_state.burst_frame;
+            app_camera_state.burst_frame = frame;
+            xSemaphoreGive(app_camera_state.mutex);
+            app_camera_state.best = score;
+        }
+    } else if (app_camera_state.recaptures < APP_CAMERA_MAX_RECAPTURES) {
+        /* corrupt shots don't count towards the burst */
+        app_camera_state.recaptures++;
+        app_camera_state.shots_left++;
+    }
+
+    if (app_camera_state.shots_left > 0) {
+        app_camera_state.shots_left--;
+        if (app_camera_retake() == CAMERA_SUCCESS) {
+            return;
+        }
+        /* settle for what we have */
+    } else if (lib_VC0706_cmd_start_frame(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) != VC0706_SUCCESS) {
+        /* enable camera frame buffer to update, if operation fails then reset camera */
+        app_camera_reset_due_to_error();
+    }
+
+    app_camera_publish_burst(stream);
+}
+
+/**
+ * @brief time out streams that have held a frame buffer for too long. They are only marked as failed so further reads
+ *        fail, the frame stays allocated until app_camera_put_stream drops the last reference.
+ *
+ * @return TickType_t ticks until the next stream times out, portMAX_DELAY if none hold a frame
+ */
+static TickType_t app_camera_expire_streams(void) {
+    TickType_t wait = portMAX_DELAY;
+    TickType_t now = xTaskGetTickCount();
+
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    for (alt_u32 i = 0; i < APP_CAMERA_MAX_STREAMS; i++) {
+        app_camera_datastream_S* stream = app_camera_state.streams[i];
+        if ((stream == NULL) || (stream->frame == NULL) || (stream->status == CAMERA_STREAM_CRITICAL_ERROR)) {
+            continue;
+        }
+        TickType_t elapsed = now - stream->start_timestamp;
+        if (elapsed >= APP_CAMERA_STREAM_TIMEOUT) {
+            /* TODO: add error callback notification */
+            stream->status = CAMERA_STREAM_CRITICAL_ERROR;
+        } else if ((APP_CAMERA_STREAM_TIMEOUT - elapsed) < wait) {
+            wait = APP_CAMERA_STREAM_TIMEOUT - elapsed;
+        }
+    }
+    xSemaphoreGive(app_camera_state.mutex);
+
+    return wait;
+}
+
+/**
+ * @brief find a frame buffer no stream is using
+ *
+ * @param frame output frame buffer index
+ * @return true if one is free
+ */
+static bool app_camera_free_frame(alt_u32* frame) {
+    bool found = false;
+
+    xSemaphoreTake(app_camera_state.mutex, portMAX_DELAY);
+    for (alt_u32 i = 0; i < APP_CAMERA_FRAME_BUFFERS; i++) {
+        if (!app_camera_state.frame_busy[i]) {
+            *frame = i;
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(app_camera_state.mutex);
+
+    return found;
+}
+
+/**
+ * @brief camera task, a blocking state machine woken by new requests, streams being released and stream timeouts.
+ *        Segments are read back to back while a picture is coming in, each read blocks on UART RX notifications so
+ *        the CPU is free for other tasks in between. With two frame buffers a new capture starts while readers are
+ *        still draining the previous frame, and while idle one of them can hold a pre-captured frame.
+ *
+ * @param p unused
+ */
 void app_camera_run(void *p) {
 
     /* init camera and app data */
     lib_VC0706_init(CAMERA_BASE, CAMERA_IRQ);
-    app_camera_state.in_q = xQueueCreate(APP_CAMERA_DEFAULT_REQUEST_QUEUE_SIZE, sizeof(app_camera_datastream_S));
+    lib_pool_init(&app_camera_stream_pool, app_camera_stream_pool_storage, sizeof(app_camera_datastream_S),
+                                                                                        APP_CAMERA_MAX_STREAMS);
+    app_camera_state.in_q = xQueueCreate(APP_CAMERA_MAX_STREAMS, sizeof(app_camera_datastream_S*));
+    app_camera_state.released = xSemaphoreCreateBinary();
+    app_camera_state.events = xQueueCreateSet(APP_CAMERA_EVENT_SET_SIZE);
+    xQueueAddToSet(app_camera_state.in_q, app_camera_state.events);
+    xQueueAddToSet(app_camera_state.released, app_camera_state.events);
     app_camera_state.mutex = xSemaphoreCreateMutex();
+    app_camera_state.frame_busy[APP_CAMERA_BURST_SCRATCH] = true;
+    app_camera_state.burst_frame = app_camera_frame_store[APP_CAMERA_BURST_SCRATCH];
+    lib_aimd_init(&app_camera_state.segment_window, APP_CAMERA_SEGMENT_MIN, APP_CAMERA_STREAM_SEGMENT_MAX,
+                                                            APP_CAMERA_SEGMENT_STEP, 1, APP_CAMERA_SEGMENT_INITIAL);
 
     /* reset camera for use */
     lib_VC0706_cmd_reset_camera(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS);
     vTaskDelay(pdMS_TO_TICKS(APP_CAMERA_RESET_DELAY_MS));
-    //lib_VC0706_increase_baud(pdMS_TO_TICKS(APP_CAMERA_RESET_DELAY_MS)); // set baud rate to 115200 baud
+    lib_VC0706_increase_baud(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS); // negotiate up to 115200 baud
 
-    /* task idle */
     while (1) {
 
-        /* start running new stream */
-        if ((!app_camera_state.stream_running) && (uxQueueMessagesWaiting(app_camera_state.in_q) > 0)) {
-            app_camera_datastream_S* new_stream = (app_camera_datastream_S*) pvPortMalloc(sizeof(app_camera_datastream_S));
-            xQueueReceive(app_camera_state.in_q, new_stream, portMAX_DELAY);
-            alt_u32 picturesize = 0;
-            /* "take picture", verify we can start stream properly, if not set error status and restart camera */
-            if (app_camera_take_picture_get_data_size(&picturesize) != CAMERA_ERROR) {
-#if (APP_CAMERA_DEBUG_MSG == 1)
-                printf("picturesize: %d", picturesize);
-#endif
-                app_camera_state.running = new_stream;
-                new_stream->status = CAMERA_STREAM_RUNNING;
-                app_camera_state.stream_running = true;
-                app_camera_state.start_timestamp = xTaskGetTickCount();
-                new_stream->completed_chunks = 0;
-                new_stream->total_size = picturesize;
-                new_stream->out_q = xQueueCreate(APP_CAMERA_DEFAULT_STREAM_OUT_QUEUE_SIZE, sizeof(app_camera_photo_chunk_T));
-                /* TODO: add stream start callback notification */
-            } else {
-                /* TODO: add error callback notification */
-                vPortFree(new_stream);
-                app_camera_reset_due_to_error();
-            }
-        } else if (app_camera_state.stream_running) {
-            /* see if we need to timeout stream */
-            if ((xTaskGetTickCount() - app_camera_state.start_timestamp) > APP_CAMERA_STREAM_TIMEOUT) {
-                app_camera_state.stream_running = false;
-                app_camera_output_stream_free(app_camera_state.running);
-                /* TODO: add error callback notification */
+        /* timeouts first, they may free up a frame buffer for a waiting request */
+        TickType_t wait = app_camera_expire_streams();
+        alt_u32 frame;
+        bool startable = (app_camera_state.capturing == NULL) && (app_camera_state.requests_pending > 0) &&
+                                                                                    app_camera_free_frame(&frame);
+        /* requests always win over pre-capturing */
+        bool speculate = (app_camera_state.capturing == NULL) && (app_camera_state.requests_pending == 0) &&
+                                                        app_camera_speculative_due(&wait) && app_camera_free_frame(&frame);
+        if ((app_camera_state.capturing != NULL) || startable || speculate) {
+            wait = 0;
+        }
+
+        /* sleep until something happens, or just collect events if there is work to do */
+        QueueSetMemberHandle_t event = xQueueSelectFromSet(app_camera_state.events, wait);
+        if (event == app_camera_state.in_q) {
+            /* set events are 1:1 with queued requests, the request itself is received once the camera is free */
+            app_camera_state.requests_pending++;
+        } else if (event == app_camera_state.released) {
+            xSemaphoreTake(app_camera_state.released, 0);
+        }
+
+        if (startable) {
+            /* start running new stream */
+            app_camera_datastream_S* new_stream;
+            xQueueReceive(app_camera_state.in_q, &new_stream, 0);
+            app_camera_state.requests_pending--;
+            app_camera_start_stream(new_stream, frame);
+        } else if (speculate && (event != app_camera_state.in_q)) {
+            app_camera_start_speculative(frame);
+        } else if (app_camera_state.capturing != NULL) {
+            if (app_camera_state.capturing->status == CAMERA_STREAM_CRITICAL_ERROR) {
+                /* timed out mid capture, let the camera refresh its frame buffer again */
+                app_camera_end_capture(app_camera_state.capturing);
                 lib_VC0706_cmd_start_frame(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS);
-            } else if ((uxQueueMessagesWaiting(app_camera_state.running->out_q) < APP_CAMERA_DEFAULT_STREAM_OUT_QUEUE_SIZE) && (app_camera_state.running->status == CAMERA_STREAM_RUNNING)) {
-                /* get next chunk */
-                alt_u32 start_addr = app_camera_state.running->completed_chunks*APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE;
-                alt_u32 number_bytes_left = (app_camera_state.running->total_size - start_addr);
-                /* although most chunks are default byte size, the last one in any photo might be smaller */
-                alt_u32 number_bytes = (number_bytes_left > APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE) ?
-                                                            APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE : number_bytes_left;
-                alt_u8* new_data = (alt_u8*) pvPortMalloc(number_bytes);
-                if (lib_VC0706_cmd_get_fbuf_data(new_data, APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS, start_addr, number_bytes)
-                                                                                                    == VC0706_SUCCESS) {
-                    app_camera_photo_chunk_T new_chunk = {
-                        .dataptr = new_data,
-                        .size = number_bytes,
-                        .id = app_camera_state.running->completed_chunks
-                    };
-                    xQueueSend(app_camera_state.running->out_q, &new_chunk, APP_CAMERA_MUTEX_BLOCKTIME_MS);
-                    app_camera_state.running->completed_chunks++;
-#if (APP_CAMERA_DEBUG_MSG == 1)
-                    printf("got chunk %d, size %d\n", (app_camera_state.running->completed_chunks), new_chunk.size);
-#endif
-                    /* we have completed all the valid chunks */
-                    alt_u32 data_processed = ((app_camera_state.running->completed_chunks)*APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE);
-                    if (data_processed >= (app_camera_state.running->total_size)) {
-                        app_camera_state.running->status = CAMERA_STREAM_DONE;
-                        /* enable camera frame buffer to update, if operation fails then reset camera */
-                        if (lib_VC0706_cmd_start_frame(APP_CAMERA_CHUNK_REQUEST_TIMEOUT_MS) != VC0706_SUCCESS) {
-                            app_camera_reset_due_to_error();
-                        }
-                        /* although we have finished streaming the data out of the camera, the stream is not finished
-                         * until client pulls all data from queue
-                         */
-                    } else {
-                        app_camera_state.running->status = CAMERA_STREAM_RUNNING;
-                    }
+            } else {
+                if (app_camera_state.capturing->shots > 1) {
+                    app_camera_service_burst(app_camera_state.capturing);
                 } else {
-#if (APP_CAMERA_DEBUG_MSG == 1)
-                    printf("Chunk error, chunk: %d\n", (app_camera_state.running->completed_chunks) + 1);
-#endif
-                    vPortFree(new_data);
+                    app_camera_service_stream(app_camera_state.capturing);
                 }
             }
-            else if ((app_camera_state.running->status == CAMERA_STREAM_DONE) && (uxQueueMessagesWaiting(app_camera_state.running->out_q) == 0)) {
-                /* check if stream should be deallocated */
-                app_camera_state.last_finished = app_camera_state.running->id;
-                app_camera_state.stream_running = false;
-#if (APP_CAMERA_DEBUG_MSG == 1)
-                printf("Streaming done!!!");
-#endif
-                app_camera_output_stream_free(app_camera_state.running);
-            } else if (uxQueueMessagesWaiting(app_camera_state.running->out_q) == APP_CAMERA_DEFAULT_STREAM_OUT_QUEUE_SIZE) {
-                /* no more vPortFree space in output queue */
-#if (APP_CAMERA_DEBUG_MSG == 1)
-                printf("Queue full, chunk: %d\n", (app_camera_state.running->completed_chunks));
-#endif
-            }
         }
-        vTaskDelay(pdMS_TO_TICKS(APP_CAMERA_RUN_DELAY_MS));
     }
 
-}
\ No newline at end of file
+}
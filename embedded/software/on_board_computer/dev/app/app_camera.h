@@ -10,8 +10,15 @@
 #ifndef APP_CAMERA_H_
 #define APP_CAMERA_H_
 
+/* stdlib includes */
+#include "stdbool.h"
+
+/* lib includes */
+#include "lib_pool.h"
+
 /* public defines */
-#define APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE 48
+#define APP_CAMERA_STREAM_SEGMENT_MAX 8192 // largest READ_FBUF request the adaptive segment size grows to
+#define APP_CAMERA_RSSI_UNKNOWN 99 // matches the +CSQ not known value
 
 /* public types */
 
@@ -34,22 +41,22 @@ typedef enum {
 /* identify specific camera datastream */
 typedef alt_u32 app_camera_datastram_id;
 
-/* used by other apps to retrieve single stream objects */
-typedef struct {
-    /* datachunk */
-    alt_u8* dataptr;
-    /* chunk size in bytes */
-    alt_u32 size;
-    /* chunk unique id */
-    alt_u32 id;
-
-} app_camera_photo_chunk_T;
+/* called from the camera task as image data lands in the frame store, offset and size are in bytes */
+typedef void (*app_camera_progress_cb)(alt_u32 id, alt_u32 offset, alt_u32 size, alt_u32 total_size);
 
 /* public API */
 void app_camera_run(void *p);
 app_camera_result_E app_camera_schedule_picture(alt_u32* camera_stream_id);
+app_camera_result_E app_camera_schedule_burst(alt_u32* camera_stream_id, alt_u32 shots);
 app_camera_stream_status_E app_camera_get_stream_status(alt_u32 id);
-app_camera_result_E app_camera_get_next_stream_chunk(alt_u8** data, alt_u32* size, alt_u32 id);
+app_camera_result_E app_camera_acquire_stream(alt_u32 id);
+void app_camera_release_stream(alt_u32 id);
+app_camera_result_E app_camera_read_stream(alt_u32 id, alt_u32 offset, alt_u32 max, alt_u8** data, alt_u32* size,
+                                                                                                    bool* last);
 alt_u32 app_camera_get_image_size(alt_u32 id);
+void app_camera_set_progress_callback(app_camera_progress_cb cb);
+void app_camera_set_speculative(bool enable, alt_u32 max_age_ms, alt_u32 shots);
+void app_camera_get_stream_pool_stats(lib_pool_stats_S* stats);
+void app_camera_report_link(alt_u8 rssi, alt_u32 bytes, alt_u32 elapsed_ms);
 
 #endif /* APP_CAMERA_H_ */
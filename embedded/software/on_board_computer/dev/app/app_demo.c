@@ -23,6 +23,8 @@
 #include "lib_base64.h"
 #include "lib_lte.h"
 #include "lib_gps.h"
+#include "lib_aimd.h"
+#include "lib_upload.h"
 
 /* stdlib includes */
 #include "stdio.h"
@@ -31,7 +33,8 @@
 
 /* private defines */
 #define APP_DEMO_HTTP_OK 200
-#define APP_DEMO_MAX_HTTP_PAYLOAD 2048
+#define APP_DEMO_MAX_HTTP_PAYLOAD 4096 // BODYLEN, every body is built in full and sent with one AT+SHBOD
+#define APP_DEMO_MAX_HTTP_HEADER 350
 #define APP_DEMO_DEFAULT_ALLOWABLE_RETRIES 5
 #define APP_DEMO_GPS_PERIOD_S 10
 #define APP_DEMO_WAIT_TIME_AFTER_IMAGE_SEND_S 4
@@ -41,6 +44,32 @@
 #define APP_DEMO_DEVICE_UUID 0
 #define APP_DEMO_DEBUG_MSG 0
 #define APP_DEMO_UNLOCKED_ERROR_RETRIES 10
+#define APP_DEMO_SPECULATIVE_FRAME_AGE_MS 5000 // pre-captured frames older than this are retaken while locked
+#define APP_DEMO_BURST_FRAMES 3 // frames per photo, only the sharpest, best exposed one is uploaded
+#define APP_DEMO_BINARY_UPLOAD 1 // post raw JPEG bytes with AT+SHBOD instead of base64 body fields
+#define APP_DEMO_SOCKET_UPLOAD 0 // send framed raw JPEG bytes to the upload receiver over TCP instead of HTTP
+#define APP_DEMO_UPLOAD_SOCKET 0 // connection id of the upload socket
+#define APP_DEMO_UPLOAD_PORT 12000
+#define APP_DEMO_UPLOAD_ACK_TIMEOUT_MS 10000 // receiver answers the last frame once the image is checked
+#if (APP_DEMO_SOCKET_UPLOAD == 1)
+#define APP_DEMO_UPLOAD_TRANSPORT "tcp"
+#define APP_DEMO_UPLOAD_CHUNK_MIN 512 // image bytes per frame, one AT+CASEND each
+#define APP_DEMO_UPLOAD_CHUNK_MAX (LIB_LTE_SOCKET_SEND_MAX - LIB_UPLOAD_HEADER_SIZE)
+#define APP_DEMO_UPLOAD_CHUNK_STEP 256
+#define APP_DEMO_UPLOAD_CHUNK_INITIAL APP_DEMO_UPLOAD_CHUNK_MAX
+#elif (APP_DEMO_BINARY_UPLOAD == 1)
+#define APP_DEMO_UPLOAD_TRANSPORT "http-binary"
+#define APP_DEMO_UPLOAD_CHUNK_MIN 2048 // image bytes per binary body, one request each
+#define APP_DEMO_UPLOAD_CHUNK_MAX APP_DEMO_MAX_HTTP_PAYLOAD
+#define APP_DEMO_UPLOAD_CHUNK_STEP 512
+#define APP_DEMO_UPLOAD_CHUNK_INITIAL 3072
+#else
+#define APP_DEMO_UPLOAD_TRANSPORT "http-base64"
+#define APP_DEMO_UPLOAD_CHUNK_MIN 1536 // image bytes per JSON body, 2-4KB once encoded, one request each
+#define APP_DEMO_UPLOAD_CHUNK_MAX 2976 // leaves room for the keys and the scooter id
+#define APP_DEMO_UPLOAD_CHUNK_STEP 288 // whole base64 groups, only the last body carries a partial one
+#define APP_DEMO_UPLOAD_CHUNK_INITIAL 2304
+#endif
 
 /* private types */
 typedef enum {
@@ -52,11 +81,21 @@ typedef enum {
 
 /* private data - needed to contact server */
 static app_demo_state_E current_state = APP_DEMO_STATE_IDLE_LOCKED;
-static alt_u8* data_transfer_ptr = NULL; // save time uploading photo by pre-allocating static databuffer
-static alt_u8* data_transfer_outptr = NULL; // save time uploading photo by pre-allocating static databuffer
-const char APP_DEMO_IMAGE_SIZE[] = {"\"size\",%d"};
+static lib_aimd_S upload_window; // image bytes per request body, backs off when the modem rejects writes
+#if (APP_DEMO_SOCKET_UPLOAD == 1)
+static alt_u32 upload_image_id = 0; // every image gets a new id, the receiver reassembles frames by device and image
+#elif (APP_DEMO_BINARY_UPLOAD == 0)
+static alt_u8 upload_body_buf[APP_DEMO_MAX_HTTP_PAYLOAD];
+static lib_http_body_S upload_body; // {"scooterId":<id>,"data_<n>":<data>}, built here and sent in one transfer
+#endif
 const char APP_DEMO_UUID[] = {"\"scooterId\",%d"};
-const char APP_DEMO_IMAGE_DATA[] = {"\"data_%d\",%s"};
+const char APP_DEMO_IMAGE_SIZE_KEY[] = {"size"};
+const char APP_DEMO_UUID_KEY[] = {"scooterId"};
+const char APP_DEMO_IMAGE_DATA_KEY[] = {"data_%u"};
+const char APP_DEMO_BINARY_CONTENT_TYPE[] = {"\"Content-Type\",\"application/octet-stream\""};
+const char APP_DEMO_BINARY_UUID[] = {"\"X-Scooter-Id\",\"%d\""};
+const char APP_DEMO_BINARY_SIZE[] = {"\"X-Image-Size\",\"%u\""};
+const char APP_DEMO_BINARY_OFFSET[] = {"\"X-Image-Offset\",\"%u\""};
 const char APP_DEMO_LAT_DATA[] = {"\"lat\",%s"};
 const char APP_DEMO_LONG_DATA[] = {"\"lon\",%s"};
 const char APP_DEMO_GPS_VALID[] = {"\"valid\",\"true\""};
@@ -67,6 +106,7 @@ const char APP_DEMO_SERVER_RESP_UNLOCK[] = {"unlock"};
 const char APP_DEMO_SERVER_RESP_TAKE_PHOTO[] = {"photo"};
 
 const char APP_DEMO_SERVER_URL[] = {"http://20.238.80.71:8081"};
+const char APP_DEMO_UPLOAD_HOST[] = {"20.238.80.71"};
 const char APP_DEMO_IMAGE_ENDPOINT[] = {"/checkFace"};
 const char APP_DEMO_GPS_ENDPOINT[] = {"/gps"};
 
@@ -130,16 +170,18 @@ static lib_lte_result_E app_demo_connect_to_server(alt_u16 num_tries, alt_u32 im
     alt_u16 tries = 0;
 
     do {
-        /* setup module side connection metadata */
-        while (lib_lte_setup_http_connection(APP_DEMO_SERVER_URL, 350, 4096) != LTE_SUCCESS) {
+#if (APP_DEMO_SOCKET_UPLOAD == 1)
+        /* frames carry their own metadata, only the socket has to be up. It stays open from one image to the next */
+        while (!lib_lte_socket_connected(APP_DEMO_UPLOAD_SOCKET) &&
+                    (lib_lte_socket_open(APP_DEMO_UPLOAD_SOCKET, APP_DEMO_UPLOAD_HOST, APP_DEMO_UPLOAD_PORT) != LTE_SUCCESS)) {
             tries++;
             if (tries >= num_tries) {
                 break;
             }
         }
-
-        /* start http connection on module side */
-        while (lib_lte_start_http_connection() != LTE_SUCCESS) {
+#else
+        /* reuse the connection left open by the last request, it is only set up again if it dropped */
+        while (lib_lte_http_session_open(APP_DEMO_SERVER_URL, APP_DEMO_MAX_HTTP_HEADER, APP_DEMO_MAX_HTTP_PAYLOAD) != LTE_SUCCESS) {
             tries++;
             if (tries >= num_tries) {
                 break;
@@ -154,100 +196,243 @@ static lib_lte_result_E app_demo_connect_to_server(alt_u16 num_tries, alt_u32 im
             }
         }
 
-        /* write image size */
-        char size_str[sizeof(APP_DEMO_IMAGE_SIZE)+10];
-        sprintf(size_str, APP_DEMO_IMAGE_SIZE, image_size);
-        while (lib_lte_write_to_http_body(size_str) != LTE_SUCCESS) {
+#if (APP_DEMO_BINARY_UPLOAD == 0)
+        /* image size and uuid go in one body, the Content-Type header holds for every chunk that follows */
+        char size_str[12];
+        char uuid_str[12];
+        lib_http_body_init(&upload_body, upload_body_buf, sizeof(upload_body_buf), LIB_HTTP_BODY_JSON, NULL);
+        lib_http_body_add_field(&upload_body, APP_DEMO_IMAGE_SIZE_KEY, size_str, sprintf(size_str, "%u", (unsigned int)image_size));
+        lib_http_body_add_field(&upload_body, APP_DEMO_UUID_KEY, uuid_str, sprintf(uuid_str, "%d", uuid));
+        while ((lib_lte_write_http_content_type(&upload_body) != LTE_SUCCESS) ||
+                                                        (lib_lte_write_http_body(&upload_body) != LTE_SUCCESS)) {
             tries++;
             if (tries >= num_tries) {
                 break;
             }
         }
 
-        /* write uuid */
-        char uuid_str[sizeof(APP_DEMO_UUID)+10];
-        sprintf(uuid_str, APP_DEMO_UUID, uuid);
-        while (lib_lte_write_to_http_body(uuid_str) != LTE_SUCCESS) {
+        /* post command */
+        alt_u16 status = 0;
+        alt_u16 resp_size = 0;
+        while ((lib_lte_post_http_request(APP_DEMO_IMAGE_ENDPOINT, &status, &resp_size) != LTE_SUCCESS) || (status != APP_DEMO_HTTP_OK)) {
             tries++;
             if (tries >= num_tries) {
                 break;
             }
         }
+#endif
+#endif
 
-        /* post command */
-        alt_u16 status = 0;
+        /* only successful if we send request using less than allocated retries */
+        if (tries <= num_tries) {
+            ret = LTE_SUCCESS;
+        }
+    } while (0);
+
+    return ret;
+}
+
+#if (APP_DEMO_SOCKET_UPLOAD == 1)
+/**
+ * @brief attempt to send camera chunk to the upload receiver as one frame, the header and the image data go out back
+ *        to back in a single AT+CASEND. Frames say where their bytes go, so a repeated frame is harmless.
+ *
+ * @param num_tries number of retries in case where module command fails
+ * @param data image data to send
+ * @param size size of image data to send, at most APP_DEMO_UPLOAD_CHUNK_MAX
+ * @param offset image offset of the first byte
+ * @param last true for the final chunk of the image
+ * @param image image id
+ * @param uuid device uuid to send in each frame
+ * @param window upload chunk window, shrunk on every failed send and grown on a clean one
+ * @return lib_lte_result_E
+ */
+static lib_lte_result_E app_demo_send_camera_frame(alt_u16 num_tries, alt_u8* data, alt_u32 size, alt_u32 offset, bool last, alt_u32 image, alt_u32 uuid, lib_aimd_S* window) {
+    lib_lte_result_E ret = LTE_ERROR;
+    alt_u16 tries = 0;
+
+    do {
+        alt_u8 header[LIB_UPLOAD_HEADER_SIZE];
+        lib_upload_encode_header(header, uuid, image, offset, data, size, last);
+        lib_uart_iovec_S frame[] = {
+            {header, sizeof(header)},
+            {data, size}
+        };
+
+        /* a dropped socket is opened again, the receiver keeps the image across connections and asks for whatever went
+         * missing */
+        while (lib_lte_socket_send_v(APP_DEMO_UPLOAD_SOCKET, frame, 2) != LTE_SUCCESS) {
+            tries++;
+            lib_aimd_failure(window);
+            if (tries >= num_tries) {
+                break;
+            }
+            if (!lib_lte_socket_connected(APP_DEMO_UPLOAD_SOCKET)) {
+                lib_lte_socket_open(APP_DEMO_UPLOAD_SOCKET, APP_DEMO_UPLOAD_HOST, APP_DEMO_UPLOAD_PORT);
+            }
+        }
+        if (tries == 0) {
+            lib_aimd_success(window);
+        }
+
+        /* only successful if we send request using less than allocated retries */
+        if (tries < num_tries) {
+            ret = LTE_SUCCESS;
+        }
+    } while (0);
+    return ret;
+}
+
+/**
+ * @brief read the receiver's ack for an image, acks left over from earlier images are skipped
+ *
+ * @param image image id
+ * @param timeout_ms how long to wait for the ack, 0 to only take one that is already waiting
+ * @param ack output ack
+ * @return lib_lte_result_E LTE_TIMEOUT if no ack for the image arrived in time
+ */
+static lib_lte_result_E app_demo_read_upload_ack(alt_u32 image, alt_u32 timeout_ms, lib_upload_ack_S* ack) {
+    lib_lte_result_E ret = LTE_TIMEOUT;
+    alt_u8 buf[LIB_UPLOAD_ACK_SIZE];
+    alt_u32 have = 0;
+    TickType_t start = xTaskGetTickCount();
+
+    do {
+        alt_u32 got = 0;
+        if (lib_lte_socket_readable(APP_DEMO_UPLOAD_SOCKET) &&
+                        (lib_lte_socket_recv(APP_DEMO_UPLOAD_SOCKET, buf + have, sizeof(buf) - have, &got) == LTE_SUCCESS)) {
+            have += got;
+        }
+        if (have == sizeof(buf)) {
+            have = 0;
+            if ((lib_upload_decode_ack(buf, sizeof(buf), ack) == LIB_UPLOAD_SUCCESS) && (ack->image == image)) {
+                ret = LTE_SUCCESS;
+                break;
+            }
+        } else if (got == 0) {
+            vTaskDelay(pdMS_TO_TICKS(APP_DEMO_RUN_PERIOD_MS));
+        }
+    } while ((xTaskGetTickCount() - start) < pdMS_TO_TICKS(timeout_ms));
+
+    return ret;
+}
+#elif (APP_DEMO_BINARY_UPLOAD == 1)
+/**
+ * @brief attempt to send camera chunk to server as a raw binary body, every request says where its bytes go so a
+ *        repeated request is harmless
+ *
+ * @param num_tries number of retries in case where module command fails
+ * @param data image data to send
+ * @param size size of image data to send, at most APP_DEMO_MAX_HTTP_PAYLOAD
+ * @param offset image offset of the first byte
+ * @param image_size image size, the request that reaches it completes the image
+ * @param uuid device uuid to send with each chunk
+ * @param window upload chunk window, shrunk on every failed request and grown on a clean one
+ * @return lib_lte_result_E
+ */
+static lib_lte_result_E app_demo_send_camera_body(alt_u16 num_tries, alt_u8* data, alt_u32 size, alt_u32 offset, alt_u32 image_size, alt_u32 uuid, lib_aimd_S* window) {
+    lib_lte_result_E ret = LTE_ERROR;
+    alt_u16 tries = 0;
+
+    do {
+        /* headers change with every chunk, start from a clean set */
+        char uuid_str[sizeof(APP_DEMO_BINARY_UUID)+10];
+        char size_str[sizeof(APP_DEMO_BINARY_SIZE)+10];
+        char offset_str[sizeof(APP_DEMO_BINARY_OFFSET)+10];
+        sprintf(uuid_str, APP_DEMO_BINARY_UUID, uuid);
+        sprintf(size_str, APP_DEMO_BINARY_SIZE, (unsigned int)image_size);
+        sprintf(offset_str, APP_DEMO_BINARY_OFFSET, (unsigned int)offset);
+        while ((lib_lte_clear_http_header() != LTE_SUCCESS) ||
+                (lib_lte_write_to_http_header((alt_u8*)APP_DEMO_BINARY_CONTENT_TYPE) != LTE_SUCCESS) ||
+                (lib_lte_write_to_http_header(uuid_str) != LTE_SUCCESS) ||
+                (lib_lte_write_to_http_header(size_str) != LTE_SUCCESS) ||
+                (lib_lte_write_to_http_header(offset_str) != LTE_SUCCESS)) {
+            tries++;
+            if (tries >= num_tries) {
+                break;
+            }
+        }
+
+        /* body goes out as raw bytes, a failed write leaves the whole body to be written again */
+        while (lib_lte_write_to_http_body_binary(data, size) != LTE_SUCCESS) {
+            tries++;
+            lib_aimd_failure(window);
+            if (tries >= num_tries) {
+                break;
+            }
+        }
+
+        alt_u16 status = 400;
         alt_u16 resp_size = 0;
         while ((lib_lte_post_http_request(APP_DEMO_IMAGE_ENDPOINT, &status, &resp_size) != LTE_SUCCESS) || (status != APP_DEMO_HTTP_OK)) {
             tries++;
+            lib_aimd_failure(window);
             if (tries >= num_tries) {
                 break;
             }
         }
+        if (tries == 0) {
+            lib_aimd_success(window);
+        }
 
         /* only successful if we send request using less than allocated retries */
         if (tries <= num_tries) {
             ret = LTE_SUCCESS;
         }
     } while (0);
-
     return ret;
 }
-
+#else
 /**
- * @brief attempt to send camera chunk to server
+ * @brief attempt to send camera chunk to server, the whole JSON body is built locally and goes to the module in one
+ *        transfer
  *
  * @param num_tries number of retries in case where module command fails
- * @param encoded_data encoded data to send
- * @param encoded_data_size size of encoded data to send
- * @param total_sent total sent data of original image size including this chunk
- * @param current_payload size of current payload (will be modified by method)
- * @param image_size total size of image (non-encoded)
+ * @param data image data to send, base64 encoded on the way into the body
+ * @param size size of image data to send, at most APP_DEMO_UPLOAD_CHUNK_MAX
+ * @param encoder image encoder, carries partial groups from one chunk to the next
+ * @param total_sent field index, total sent data of original image size including this chunk
+ * @param last true for the final chunk of the image, the encoding is padded
  * @param uuid device uuid to send in each chunk
+ * @param window upload chunk window, shrunk on every failed request and grown on a clean one
  * @return lib_lte_result_E
  */
-static lib_lte_result_E app_demo_send_camera_chunk(alt_u16 num_tries, alt_u8* encoded_data, alt_u32 encoded_data_size, alt_u32 total_sent, alt_u32 *current_payload, alt_u32 image_size, alt_u32 uuid) {
+static lib_lte_result_E app_demo_send_camera_chunk(alt_u16 num_tries, alt_u8* data, alt_u32 size, lib_base64_ctx_S* encoder, alt_u32 total_sent, bool last, alt_u32 uuid, lib_aimd_S* window) {
     lib_lte_result_E ret = LTE_ERROR;
     alt_u16 tries = 0;
 
     do {
-        sprintf(data_transfer_outptr, APP_DEMO_IMAGE_DATA, total_sent, encoded_data);
+        /* one data field per body, the upload window sizes the whole request */
+        char key[sizeof(APP_DEMO_IMAGE_DATA_KEY)+10];
+        char uuid_str[12];
+        sprintf(key, APP_DEMO_IMAGE_DATA_KEY, (unsigned int)total_sent);
+        lib_http_body_reset(&upload_body);
+        if ((lib_http_body_add_field(&upload_body, APP_DEMO_UUID_KEY, uuid_str, sprintf(uuid_str, "%d", uuid)) != LIB_HTTP_BODY_SUCCESS) ||
+                (lib_http_body_add_field_base64(&upload_body, key, encoder, data, size, last) != LIB_HTTP_BODY_SUCCESS)) {
+            break;
+        }
 
-        /* try and write data to module field, if we get an error, incrememnt the current payload to be safe*/
-        while (lib_lte_write_to_http_body(data_transfer_outptr) != LTE_SUCCESS) {
+        /* a failed transfer leaves the whole body to be written again */
+        while (lib_lte_write_http_body(&upload_body) != LTE_SUCCESS) {
             tries++;
-            *current_payload += encoded_data_size;
+            lib_aimd_failure(window);
             if (tries >= num_tries) {
                 break;
             }
         }
 
-        *current_payload += encoded_data_size;
-        if ((*current_payload >= APP_DEMO_MAX_HTTP_PAYLOAD) || (total_sent == image_size)) {
-            /* write uuid */
-            char uuid_str[sizeof(APP_DEMO_UUID)+10];
-            sprintf(uuid_str, APP_DEMO_UUID, uuid);
-            while (lib_lte_write_to_http_body(uuid_str) != LTE_SUCCESS) {
-                tries++;
-                if (tries >= num_tries) {
-                    break;
-                }
-            }
-            alt_u16 status = 400;
-            alt_u16 resp_size = 0;
-            while ((lib_lte_post_http_request(APP_DEMO_IMAGE_ENDPOINT, &status, &resp_size) != LTE_SUCCESS) || (status != APP_DEMO_HTTP_OK)) {
-                tries++;
-                if (tries >= num_tries) {
-                    break;
-                }
-            }
-            *current_payload = 0;
-            while (lib_lte_clear_http_body() != LTE_SUCCESS) {
-                tries++;
-                if (tries >= num_tries) {
-                    break;
-                }
+        alt_u16 status = 400;
+        alt_u16 resp_size = 0;
+        while ((lib_lte_post_http_request(APP_DEMO_IMAGE_ENDPOINT, &status, &resp_size) != LTE_SUCCESS) || (status != APP_DEMO_HTTP_OK)) {
+            tries++;
+            lib_aimd_failure(window);
+            if (tries >= num_tries) {
+                break;
             }
         }
+        if (tries == 0) {
+            lib_aimd_success(window);
+        }
 
         /* only successful if we send request using less than allocated retries */
         if (tries <= num_tries) {
@@ -256,6 +441,7 @@ static lib_lte_result_E app_demo_send_camera_chunk(alt_u16 num_tries, alt_u8* en
     } while (0);
     return ret;
 }
+#endif
 
 /**
  * @brief Connect to sever and send lat/long data
@@ -272,24 +458,16 @@ static app_demo_server_resp_E app_demo_check_in_to_server(alt_u16 num_tries, alt
     alt_u16 tries = 0;
 
     do {
-        /* setup module side connection metadata */
-        while (lib_lte_setup_http_connection(APP_DEMO_SERVER_URL, 350, 4096) != LTE_SUCCESS) {
+        /* reuse the connection left open by the last request, it is only set up again if it dropped */
+        while (lib_lte_http_session_open(APP_DEMO_SERVER_URL, APP_DEMO_MAX_HTTP_HEADER, APP_DEMO_MAX_HTTP_PAYLOAD) != LTE_SUCCESS) {
             tries++;
             if (tries >= num_tries) {
                 break;
             }
         }
 
-        /* start http connection on module side */
-        while (lib_lte_start_http_connection() != LTE_SUCCESS) {
-            tries++;
-            if (tries >= num_tries) {
-                break;
-            }
-        }
-
-        /* clear both http head and body */
-        while ((lib_lte_clear_http_header() != LTE_SUCCESS) && (lib_lte_clear_http_body() != LTE_SUCCESS)) {
+        /* clear both http head and body, the session still holds whatever the last request left behind */
+        while ((lib_lte_clear_http_header() != LTE_SUCCESS) || (lib_lte_clear_http_body() != LTE_SUCCESS)) {
             tries++;
             if (tries >= num_tries) {
                 break;
@@ -390,11 +568,24 @@ static app_demo_server_resp_E app_demo_check_in_to_server(alt_u16 num_tries, alt
  *
  */
 static bool app_demo_take_picture(alt_u32 uuid) {
-    /* schedule picture */
+    /* schedule picture, we hold a reference to the stream until the upload is over */
     app_camera_datastram_id id;
-    app_camera_schedule_picture(&id);
-    vTaskDelay(pdMS_TO_TICKS(200)); // wait to allow scheduling
-    alt_u32 image_size = app_camera_get_image_size(id);
+    if (app_camera_schedule_burst(&id, APP_DEMO_BURST_FRAMES) != CAMERA_SUCCESS) {
+        printf("FAILURE\n");
+        return false;
+    }
+    /* a pre-captured frame already has its size, otherwise wait for the capture to start */
+    alt_u32 image_size;
+    app_camera_stream_status_E status;
+    while (((image_size = app_camera_get_image_size(id)) == 0) &&
+                        (((status = app_camera_get_stream_status(id)) == CAMERA_STREAM_IN_QUEUE) || (status == CAMERA_STREAM_RUNNING))) {
+        vTaskDelay(pdMS_TO_TICKS(APP_DEMO_RUN_PERIOD_MS));
+    }
+    if (image_size == 0) {
+        printf("FAILURE\n");
+        app_camera_release_stream(id);
+        return false;
+    }
     /**
      * Here we do the following:
      * 1) Turn off GPS
@@ -402,37 +593,103 @@ static bool app_demo_take_picture(alt_u32 uuid) {
      * 3) Send image size header
      * 4) Make sure the image size header was received
      */
-    vTaskDelay(pdMS_TO_TICKS(500));
     alt_u32 total_sent = 0;
-    alt_u32 current_payload = 0;
+    TickType_t upload_start = xTaskGetTickCount();
     if (app_demo_connect_to_server(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES, image_size, uuid) != LTE_SUCCESS) {
         printf("FAILURE\n");
+        app_camera_release_stream(id);
         return false;
     }
-    while (app_camera_get_stream_status(id) != CAMERA_STREAM_UNKNOWN) {
-        alt_u8** data;
-        alt_u32 size;
-        if (app_camera_get_next_stream_chunk(data, &size, id) == CAMERA_SUCCESS) {
-            alt_u8* dataptr = *data;
-            alt_u32 outsize;
-            lib_base64_encode_static(dataptr, size, &outsize, data_transfer_ptr, LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE + 1);
-            vPortFree(*data);
+#if (APP_DEMO_SOCKET_UPLOAD == 1)
+    alt_u32 image = upload_image_id++;
+    alt_u16 resends = 0;
+#elif (APP_DEMO_BINARY_UPLOAD == 0)
+    lib_base64_ctx_S encoder;
+    lib_base64_init(&encoder, NULL, NULL); // the body builder supplies the sink for every field
+#endif
+    bool last = false;
+    while (!last && (((status = app_camera_get_stream_status(id)) == CAMERA_STREAM_IN_QUEUE) ||
+                                                    (status == CAMERA_STREAM_RUNNING) || (status == CAMERA_STREAM_DONE))) {
+        alt_u8* data;
+        alt_u32 size = 0;
+        alt_u32 chunk = lib_aimd_size(&upload_window);
+        if (app_camera_read_stream(id, total_sent, chunk, &data, &size, &last) == CAMERA_SUCCESS) {
+#if (APP_DEMO_SOCKET_UPLOAD == 1) || (APP_DEMO_BINARY_UPLOAD == 1)
+            /* every request costs at least one command round trip, wait for a full window unless this is the end */
+            if (!last && (size < chunk)) {
+                size = 0;
+            }
+#else
+            /* every field needs at least one whole group, wait for more unless this is the end */
+            if (!last && (size < 3)) {
+                size = 0;
+            }
+#endif
+        }
+        if (size != 0) {
             /**
              * Here we would do the following:
              * 3) Send image data
              * 4) Make sure the image data was received
              */
+#if (APP_DEMO_SOCKET_UPLOAD == 1)
+            lib_lte_result_E sent = app_demo_send_camera_frame(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES, data, size, total_sent, last, image, uuid, &upload_window);
+            total_sent += size;
+
+            /* the receiver only speaks up once the image is complete or a frame went bad, then it says where to resume */
+            lib_upload_ack_S ack;
+            if ((sent == LTE_SUCCESS) && (last || lib_lte_socket_readable(APP_DEMO_UPLOAD_SOCKET))) {
+                if (app_demo_read_upload_ack(image, last ? APP_DEMO_UPLOAD_ACK_TIMEOUT_MS : 0, &ack) != LTE_SUCCESS) {
+                    sent = last ? LTE_TIMEOUT : LTE_SUCCESS;
+                } else if ((ack.status == LIB_UPLOAD_ACK_RESEND) && (ack.next < total_sent)) {
+                    resends++;
+                    sent = (resends > APP_DEMO_DEFAULT_ALLOWABLE_RETRIES) ? LTE_ERROR : LTE_SUCCESS;
+                    total_sent = ack.next;
+                    last = false;
+                }
+            }
+#elif (APP_DEMO_BINARY_UPLOAD == 1)
+            /**
+             * the image can end short of the size we announced once the camera's padding and the metadata segments
+             * are left out, the last request reports the real size so the server knows it is complete
+             */
+            lib_lte_result_E sent = app_demo_send_camera_body(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES, data, size, total_sent, last ? (total_sent + size) : image_size, uuid, &upload_window);
             total_sent += size;
-            if (app_demo_send_camera_chunk(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES, data_transfer_ptr, outsize, total_sent, &current_payload, image_size, uuid) != LTE_SUCCESS) {
+#else
+            total_sent += size;
+            /**
+             * the image can end short of the size we announced once the camera's padding and the metadata segments
+             * are left out, the server finishes on the field keyed with the announced size so the last one gets it
+             */
+            lib_lte_result_E sent = app_demo_send_camera_chunk(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES, data, size, &encoder, last ? image_size : total_sent, last, uuid, &upload_window);
+#endif
+            if (sent != LTE_SUCCESS) {
                 printf("FAILURE\n");
+                app_camera_release_stream(id);
                 return false;
-                break;
             }
         }
         vTaskDelay(pdMS_TO_TICKS(APP_DEMO_RUN_PERIOD_MS));
     }
-    /* kill http connection on finish */
-    lib_lte_end_http_connection();
+    app_camera_release_stream(id);
+    /* corrupt frame or the capture timed out, don't report a partial upload as done */
+    if (!last) {
+        printf("FAILURE\n");
+#if (APP_DEMO_SOCKET_UPLOAD == 1)
+        lib_lte_socket_close(APP_DEMO_UPLOAD_SOCKET);
+#else
+        lib_lte_end_http_connection();
+#endif
+        return false;
+    }
+    /* connection stays up for the next check in */
+
+    /* let the camera size the next frame for the link we just measured, the line compares transports on the bench */
+    alt_u32 upload_ms = (xTaskGetTickCount() - upload_start) * portTICK_PERIOD_MS;
+    printf("UPLOAD %s %u B %u ms\n", APP_DEMO_UPLOAD_TRANSPORT, (unsigned int)total_sent, (unsigned int)upload_ms);
+    alt_u8 rssi = LIB_LTE_RSSI_INVALID;
+    lib_lte_get_signal_strength(&rssi);
+    app_camera_report_link(rssi, total_sent, upload_ms);
     return true;
 }
 
@@ -495,6 +752,16 @@ static app_demo_server_resp_E app_demo_contact_server(alt_u32 uuid) {
     alt_u8 lat[10] = {0};
     alt_u8 longi[12] = {0};
     do {
+        /* drop the AT port to a slower rate if line errors spiked since the last check in */
+        if (lib_lte_check_baud() != LTE_SUCCESS) {
+            break;
+        }
+
+        /* the network dropped the PDP context since the last check in, re-attach rather than timing out the post */
+        if (!lib_lte_network_attached() && (app_demo_attach_to_network(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES) != LTE_SUCCESS)) {
+            break;
+        }
+
         /* read gps data, try and send result to server and get server action */
         if (lib_gps_read_gps(lat, longi) != LTE_SUCCESS) {
             ret = app_demo_check_in_to_server(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES, "0" , "0", uuid, false);
@@ -502,9 +769,9 @@ static app_demo_server_resp_E app_demo_contact_server(alt_u32 uuid) {
             ret = app_demo_check_in_to_server(APP_DEMO_DEFAULT_ALLOWABLE_RETRIES, lat , longi, uuid, true);
         }
 
-        if (lib_lte_end_http_connection() != LTE_SUCCESS) {
-            ret = APP_DEMO_SERVER_RESPONSE_ERROR;
-            break;
+        /* start the next check in from a clean connection */
+        if (ret == APP_DEMO_SERVER_RESPONSE_ERROR) {
+            lib_lte_end_http_connection();
         }
 
     } while(0);
@@ -556,13 +823,14 @@ void app_demo_run(void*p) {
 
     alt_u32 server_contact_count = 0;
     alt_u32 unlocked_error_count = 0; /* in the case a server check-in fails when unlocked, do not immediately re-lock*/
-    data_transfer_ptr = (alt_u8*)pvPortMalloc(LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE + 1);
-    memset(data_transfer_ptr, 0, LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE + 1);
-
-    data_transfer_outptr = (alt_u8*)pvPortMalloc(sizeof(APP_DEMO_IMAGE_DATA) + 1 + LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE);
-    memset(data_transfer_outptr, 0, sizeof(APP_DEMO_IMAGE_DATA) + 1 + LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE);
+    lib_aimd_init(&upload_window, APP_DEMO_UPLOAD_CHUNK_MIN, APP_DEMO_UPLOAD_CHUNK_MAX, APP_DEMO_UPLOAD_CHUNK_STEP, 1,
+                                                                                        APP_DEMO_UPLOAD_CHUNK_INITIAL);
 
     while (1) {
+        /* keep a frame ready while locked, a photo request then uploads without waiting on the camera */
+        app_camera_set_speculative(current_state == APP_DEMO_STATE_IDLE_LOCKED, APP_DEMO_SPECULATIVE_FRAME_AGE_MS,
+                                                                                                APP_DEMO_BURST_FRAMES);
+
         switch(current_state) {
             case APP_DEMO_STATE_IDLE_LOCKED:
             {
@@ -25,6 +25,7 @@
 
 /* Lib includes */
 #include "lib_uart.h"
+#include "lib_baud.h"
 #include "lib_VC0706.h"
 
 /* defines */
@@ -36,12 +37,28 @@
 #define lib_VC0706_SERIAL_NUM 0x00
 
 #define lib_VC0706_RESET_CMD 0x26
+#define lib_VC0706_GET_VERSION_CMD 0x11
+#define lib_VC0706_GET_VERSION_RESPONSE_SIZE 16 // 0x76+serial number+0x11+0x00+0x0B+"VC0703 1.00"
+
+#define lib_VC0706_SET_PORT_CMD 0x24
+#define lib_VC0706_SET_PORT_LEN 0x03
+#define lib_VC0706_SET_PORT_UART 0x01
 
 #define lib_VC0706_CAMERA_FBUF_CTRL_CMD 0x36
 #define lib_VC0706_CAMERA_FBUF_CTRL_CMD_2 0x01
 #define lib_VC0706_CAMERA_FBUF_CTR_STOP 0x00
 #define lib_VC0706_CAMERA_FBUF_CTR_RESUME 0x03
 
+#define lib_VC0706_DOWNSIZE_CTRL_CMD 0x54
+#define lib_VC0706_DOWNSIZE_CTRL_LEN 0x01
+
+#define lib_VC0706_WRITE_DATA_CMD 0x31
+#define lib_VC0706_WRITE_DATA_LEN 0x05
+#define lib_VC0706_WRITE_DATA_CHIP_REG 0x01
+#define lib_VC0706_WRITE_DATA_BYTES 0x01
+#define lib_VC0706_COMPRESSION_REG_H 0x12
+#define lib_VC0706_COMPRESSION_REG_L 0x04
+
 #define lib_VC0706_CAMERA_FBUF_LEN_CMD 0x34
 #define lib_VC0706_CAMERA_FBUF_LEN_CMD_2 0x01
 #define lib_VC0706_CAMERA_FBUF_LEN_FBUF_TYPE 0x00
@@ -52,30 +69,17 @@
 #define lib_VC0706_CAMERA_READ_FBUF_CMD_4 0x0A
 #define lib_VC0706_CAMERA_DELAY_B1 0x00
 #define lib_VC0706_CAMERA_DELAY_B2 0x0A
+#define lib_VC0706_RESPONSE_SIZE 5 // 0x76+serial number+cmd+status+0x00, also used as the READ_FBUF trailer
+#define lib_VC0706_STREAM_NOTIFY_BYTES 256 // wake up to drain a streaming read this often, well under the RX ring size
 
 /* Private data definitions */
 
-typedef enum {
-    RX_RECEIVING,
-    RX_ERROR,
-    RX_DONE
-} lib_VC0706_rxstate_E;
-
-/* camera rx buffer used to collect data from uart callback */
+/* UART divisor bytes the camera expects for each supported rate */
 typedef struct {
-    /* rx buffer */
-    volatile alt_u8* rx_buf;
-
-    /* rx buffer current index */
-    alt_u32 idx;
-
-    /* rx buffer target size */
-    alt_u32 targ_size;
-
-    /* Current RX state */
-    lib_VC0706_rxstate_E rx_state;
-
-} lib_VC0706_rx_buffer_S;
+    alt_u32 rate;
+    alt_u8 divisor_1;
+    alt_u8 divisor_2;
+} lib_VC0706_baud_S;
 
 /* state struct */
 typedef struct {
@@ -83,79 +87,59 @@ typedef struct {
     /* UART settings */
     lib_uart_config_S* config;
 
-    /* RX buffer */
-    volatile lib_VC0706_rx_buffer_S* rxbuf;
-
     /* mutex for handling multiple requests */
     SemaphoreHandle_t mutex;
 
-    /* flag for if we are expecting a response from UART */
-    bool bus_busy;
-
 } lib_VC0706_state_S;
 
-/* private function definitions */
-
-/* UART driver */
-static void lib_VC0706_rx_error_callback(void);
-static void lib_VC0706_rx_callback(alt_u8 rxdata);
-
 /* Private data */
 
-/* uart configuration */
+/* uart configuration, responses are collected by lib_uart and read in bulk from task context */
 static lib_uart_config_S VC0706_config = {
-    .uart_rx_irq = (lib_uart_generic_rx_irq*)lib_VC0706_rx_callback,
-    .uart_rx_error = (lib_uart_rx_error*)lib_VC0706_rx_error_callback
+    .name = "camera",
+    .uart_rx_irq = NULL,
+    .uart_rx_error = NULL,
+    .uart_freq = CAMERA_FREQ,
+    .fixed_baud = CAMERA_FIXED_BAUD,
+    .baud = CAMERA_BAUD
 };
 
-/* state configuration, initially no rxbuffer set up */
-static lib_VC0706_state_S VC0706_state = {
-    .config = &VC0706_config,
-    .rxbuf = NULL,
-    .bus_busy = false
+/* READ_FBUF header and trailer land here while the payload goes straight to the caller, guarded by the driver mutex */
+static alt_u8 VC0706_fbuf_header[lib_VC0706_RESPONSE_SIZE];
+static alt_u8 VC0706_fbuf_trailer[lib_VC0706_RESPONSE_SIZE];
+
+/* camera rate table, see VC0706 protocol section 11.8 */
+static const lib_VC0706_baud_S VC0706_baud_table[] = {
+    {.rate = 9600, .divisor_1 = 0xAE, .divisor_2 = 0xC8},
+    {.rate = 19200, .divisor_1 = 0x56, .divisor_2 = 0xE4},
+    {.rate = 38400, .divisor_1 = 0x2A, .divisor_2 = 0xF2},
+    {.rate = 57600, .divisor_1 = 0x1C, .divisor_2 = 0x1C},
+    {.rate = 115200, .divisor_1 = 0x0D, .divisor_2 = 0xA6}
 };
 
+static bool lib_VC0706_request_baud(alt_u32 rate, alt_u32 timeout_ms);
+static bool lib_VC0706_verify_link(alt_u32 timeout_ms);
 
-/* Private functions */
+/* camera powers on at the system.h rate, then climbs to its 115200 maximum */
+static lib_baud_link_S VC0706_baud = {
+    .config = &VC0706_config,
+    .rates = {CAMERA_BAUD, 57600, 115200},
+    .stage_count = 3,
+    .stage = 0,
+    .ceiling = 2,
+    .request = lib_VC0706_request_baud,
+    .verify = lib_VC0706_verify_link,
+    .cmd_timeout_ms = 100,
+    .error_limit = LIB_BAUD_DEFAULT_ERROR_LIMIT
+};
 
-/**
- * @brief UART rxdata callback, writes new data into rxbuffer if rxbuffer is in a good state,
- *
- * @param rxdata incomming UART data
- */
-static void lib_VC0706_rx_callback(alt_u8 rxdata) {
-    volatile lib_VC0706_rx_buffer_S* buffer = VC0706_state.rxbuf;
-    if (VC0706_state.bus_busy == false) {
-        return;
-    }
+/* state configuration */
+static lib_VC0706_state_S VC0706_state = {
+    .config = &VC0706_config,
+};
 
-    /* set rxbuffer error for currently incomming data only if we are expecting a response */
-    if (buffer->rx_state == RX_RECEIVING) {
-        buffer->rx_buf[buffer->idx] = rxdata;
-        (buffer->idx)++;
-        if (buffer->idx >= buffer->targ_size) {
-            buffer->rx_state = RX_DONE;
-        }
-    }
-}
 
-/**
- * @brief UART rx error callback, sets rxbuffer error to notify lib that incomming data chunk is garbage
- *
- */
-static void lib_VC0706_rx_error_callback(void) {
-    volatile lib_VC0706_rx_buffer_S* buffer = VC0706_state.rxbuf;
-    if (VC0706_state.bus_busy == false) {
-        return;
-    }
-    /* set rxbuffer error for currently incomming data only if we are expecting a response */
-    if (buffer->rx_state == RX_RECEIVING) {
-        //printf("RX ERROR for expected data");
-        buffer->rx_state = RX_ERROR;
-    } else {
-        //printf("RX ERROR for unexpected data");
-    }
-}
+/* Private functions */
 
 /**
  * @brief Send a command sequence to the camera
@@ -163,16 +147,11 @@ static void lib_VC0706_rx_error_callback(void) {
  * @param cmd command sequence to sent
  * @param cmd_len size of command sequence
  * @param cmd_tx_timeout timeout of transmission window in ms
- * @param rxbuf receivebuffer for response data
  * @return lib_VC0706_result_E
  */
-static lib_VC0706_result_E lib_VC0706_send_cmd(alt_u8* cmd, alt_u32 cmd_len, alt_u32 cmd_tx_timeout,
-                                                                                        volatile lib_VC0706_rx_buffer_S* rxbuf) {
+static lib_VC0706_result_E lib_VC0706_send_cmd(alt_u8* cmd, alt_u32 cmd_len, alt_u32 cmd_tx_timeout) {
 
     lib_VC0706_result_E result = VC0706_ERROR;
-    VC0706_state.rxbuf = rxbuf;
-    VC0706_state.bus_busy = true;
-    /* set up rx buffer before sending command */
     if (lib_uart_tx(VC0706_state.config, cmd, cmd_len, cmd_tx_timeout) == LIB_UART_SUCCESS) {
         result = VC0706_SUCCESS;
     }
@@ -183,23 +162,19 @@ static lib_VC0706_result_E lib_VC0706_send_cmd(alt_u8* cmd, alt_u32 cmd_len, alt
 /**
  * @brief Verify command response data has proper header
  *
- * @param rxbuf received response data
+ * @param rxdata received response data
  * @param cmd command executed (hex)
  * @return lib_VC0706_result_E
  */
-static lib_VC0706_result_E lib_VC0706_verify_response(lib_VC0706_rx_buffer_S* rxbuf, alt_u8 cmd) {
+static lib_VC0706_result_E lib_VC0706_verify_response(volatile alt_u8* rxdata, alt_u8 cmd) {
     lib_VC0706_result_E result = VC0706_ERROR;
-    alt_u8* rxdata = rxbuf->rx_buf;
-
-    /* first check that we received all the data */
-    if (rxbuf->idx == rxbuf->targ_size) {
-        if ((rxdata[0] == lib_VC0706_RESPONSE_HEADER) &&
-            (rxdata[1] == lib_VC0706_SERIAL_NUM) &&
-            (rxdata[2] == cmd) &&
-            (rxdata[3] == lib_VC0706_RESPONSE_HEADER_B3)) {
-                result = VC0706_SUCCESS;
-            }
-    }
+
+    if ((rxdata[0] == lib_VC0706_RESPONSE_HEADER) &&
+        (rxdata[1] == lib_VC0706_SERIAL_NUM) &&
+        (rxdata[2] == cmd) &&
+        (rxdata[3] == lib_VC0706_RESPONSE_HEADER_B3)) {
+            result = VC0706_SUCCESS;
+        }
 
     return result;
 }
@@ -217,41 +192,195 @@ static lib_VC0706_result_E lib_VC0706_verify_response(lib_VC0706_rx_buffer_S* rx
 static lib_VC0706_result_E lib_VC0706_execute_cmd(alt_u8* txbuf, alt_u32 tx_size, volatile alt_u8* rxbuf, alt_u32 rxsize,
                                                                                                 alt_u32 timeout_ms) {
     lib_VC0706_result_E res = VC0706_ERROR;
+    alt_u32 idx = 0;
 
-    /* construct rx packet */
-    volatile lib_VC0706_rx_buffer_S new_rx_buf = {
-        .rx_buf = rxbuf,
-        .idx = 0,
-        .targ_size = rxsize,
-        .rx_state = RX_RECEIVING
-    };
+    /* only the response to this command should land in rxbuf, the RX irq wakes us once all of it is waiting or a
+     * line error is flagged, we block until then so lower priority tasks keep running while the bytes trickle in */
+    lib_uart_rx_flush(VC0706_state.config);
+    lib_uart_rx_take_error(VC0706_state.config);
+    lib_uart_rx_listen(VC0706_state.config, xTaskGetCurrentTaskHandle(), rxsize, LIB_UART_RX_NO_TERMINATOR);
     do {
         /* first send the command */
-        res = lib_VC0706_send_cmd(txbuf, tx_size, timeout_ms/3, &new_rx_buf);
+        res = lib_VC0706_send_cmd(txbuf, tx_size, timeout_ms/3);
         alt_u32 start_time = xTaskGetTickCount();
         if (res != VC0706_SUCCESS) {
             break;
         }
         /* wait for command response */
-        while (((xTaskGetTickCount() - start_time)) <= pdMS_TO_TICKS(timeout_ms)) {
-            if (new_rx_buf.rx_state == RX_DONE) {
+        TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+        TickType_t elapsed;
+        while ((idx < rxsize) && ((elapsed = (xTaskGetTickCount() - start_time)) <= timeout)) {
+            /* the remainder may have landed before the threshold was re-armed */
+            if ((lib_uart_rx_pending(VC0706_state.config) < (rxsize - idx)) &&
+                !lib_uart_rx_wait(VC0706_state.config, timeout - elapsed)) {
+                continue;
+            }
+
+            /* the rest of the response is corrupt, no point waiting for it */
+            if (lib_uart_rx_take_error(VC0706_state.config)) {
+                break;
+            }
+
+            idx += lib_uart_rx_read(VC0706_state.config, (alt_u8*)rxbuf + idx, rxsize - idx);
+
+            /* only wake again once the remainder has arrived */
+            if (idx < rxsize) {
+                lib_uart_rx_listen(VC0706_state.config, xTaskGetCurrentTaskHandle(), rxsize - idx,
+                                                                                        LIB_UART_RX_NO_TERMINATOR);
+            }
+        }
+
+        /* verify we did not hit command response timeout or a line error */
+        if (idx != rxsize) {
+            res = ((xTaskGetTickCount() - start_time) > timeout) ? VC0706_TIMEOUT : VC0706_ERROR;
+            break;
+        }
+
+        res = lib_VC0706_verify_response(rxbuf, txbuf[2]);
+    } while (0);
+    lib_uart_rx_listen(VC0706_state.config, NULL, LIB_UART_RX_RING_SIZE, LIB_UART_RX_NO_TERMINATOR);
+
+    return res;
+}
+
+/**
+ * @brief read exactly len bytes of a response straight out of the RX ring, waking every
+ *        lib_VC0706_STREAM_NOTIFY_BYTES so the ring never fills. Caller must have flushed the ring before sending.
+ *
+ * @param dest output buffer
+ * @param len number of bytes to read
+ * @param offset offset of dest[0] reported to the progress callback
+ * @param progress optional -> called after every drain with the offset and size of the new data
+ * @param ctx passed through to the progress callback
+ * @param idle_timeout_ms maximum gap between two drains
+ * @return lib_VC0706_result_E
+ */
+static lib_VC0706_result_E lib_VC0706_stream_response(alt_u8* dest, alt_u32 len, alt_u32 offset,
+                                    lib_VC0706_progress_cb progress, void* ctx, alt_u32 idle_timeout_ms) {
+    lib_VC0706_result_E res = VC0706_SUCCESS;
+    TickType_t idle_timeout = pdMS_TO_TICKS(idle_timeout_ms);
+    TickType_t last_data = xTaskGetTickCount();
+    alt_u32 idx = 0;
+
+    while (idx < len) {
+        alt_u32 remaining = len - idx;
+        alt_u32 threshold = (remaining < lib_VC0706_STREAM_NOTIFY_BYTES) ? remaining : lib_VC0706_STREAM_NOTIFY_BYTES;
+        lib_uart_rx_listen(VC0706_state.config, xTaskGetCurrentTaskHandle(), threshold, LIB_UART_RX_NO_TERMINATOR);
+
+        /* block until the next block is waiting, unless it already is */
+        if (lib_uart_rx_pending(VC0706_state.config) < threshold) {
+            TickType_t elapsed = xTaskGetTickCount() - last_data;
+            if (elapsed > idle_timeout) {
+                res = VC0706_TIMEOUT;
                 break;
             }
+            lib_uart_rx_wait(VC0706_state.config, idle_timeout - elapsed);
+        }
+
+        /* a dropped byte shifts everything after it, abandon the read */
+        if (lib_uart_rx_take_error(VC0706_state.config)) {
+            res = VC0706_ERROR;
+            break;
+        }
+
+        alt_u32 count = lib_uart_rx_read(VC0706_state.config, dest + idx, remaining);
+        if (count != 0) {
+            if (progress != NULL) {
+                progress(offset + idx, count, ctx);
+            }
+            idx += count;
+            last_data = xTaskGetTickCount();
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief run a READ_FBUF request, receiving the header and trailer into the static scratch area and the payload
+ *        directly into dataptr. Caller must hold the driver mutex.
+ *
+ * @param dataptr output camera data, must hold data_len bytes
+ * @param image_start_addr starting address of data to retrieve from camera
+ * @param data_len number of bytes to retrieve from camera
+ * @param progress optional -> called as data lands with the image offset and size of the new data
+ * @param ctx passed through to the progress callback
+ * @param idle_timeout_ms maximum time without any data from the camera
+ * @return lib_VC0706_result_E
+ */
+static lib_VC0706_result_E lib_VC0706_read_fbuf(alt_u8* dataptr, alt_u32 image_start_addr, alt_u32 data_len,
+                                        lib_VC0706_progress_cb progress, void* ctx, alt_u32 idle_timeout_ms) {
+    lib_VC0706_result_E res = VC0706_ERROR;
+    alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, lib_VC0706_CAMERA_READ_FBUF_CMD,
+    lib_VC0706_CAMERA_READ_FBUF_CMD_2, lib_VC0706_CAMERA_READ_FBUF_CMD_3, lib_VC0706_CAMERA_READ_FBUF_CMD_4,
+    (alt_u8)(image_start_addr >> 24), (alt_u8)(image_start_addr >> 16), (alt_u8)(image_start_addr >> 8),
+    (alt_u8)image_start_addr, (alt_u8)(data_len >> 24), (alt_u8)(data_len >> 16), (alt_u8)(data_len >> 8),
+    (alt_u8)data_len, lib_VC0706_CAMERA_DELAY_B1, lib_VC0706_CAMERA_DELAY_B2};
+
+    lib_uart_rx_flush(VC0706_state.config);
+    lib_uart_rx_take_error(VC0706_state.config);
+    do {
+        /* 0x76+serial+0x32+0x00+0x00 + data + 0x76+serial+0x32+0x00+0x00 */
+        res = lib_VC0706_send_cmd(tx, sizeof(tx), idle_timeout_ms);
+        if (res != VC0706_SUCCESS) {
+            break;
+        }
+
+        res = lib_VC0706_stream_response(VC0706_fbuf_header, lib_VC0706_RESPONSE_SIZE, 0, NULL, NULL, idle_timeout_ms);
+        if ((res != VC0706_SUCCESS) ||
+            ((res = lib_VC0706_verify_response(VC0706_fbuf_header, tx[2])) != VC0706_SUCCESS)) {
+            break;
         }
-        VC0706_state.bus_busy = false;
 
-        /* verify we did not hit command response timeout */
-        if ((((xTaskGetTickCount() - start_time)) > pdMS_TO_TICKS(timeout_ms)) || (new_rx_buf.rx_state != RX_DONE)) {
-            res = VC0706_TIMEOUT;
+        res = lib_VC0706_stream_response(dataptr, data_len, image_start_addr, progress, ctx, idle_timeout_ms);
+        if (res != VC0706_SUCCESS) {
             break;
         }
 
-        res = lib_VC0706_verify_response(&new_rx_buf, txbuf[2]);
+        /* trailer is validated in place */
+        res = lib_VC0706_stream_response(VC0706_fbuf_trailer, lib_VC0706_RESPONSE_SIZE, 0, NULL, NULL, idle_timeout_ms);
+        if (res != VC0706_SUCCESS) {
+            break;
+        }
+        res = lib_VC0706_verify_response(VC0706_fbuf_trailer, tx[2]);
     } while (0);
+    lib_uart_rx_listen(VC0706_state.config, NULL, LIB_UART_RX_RING_SIZE, LIB_UART_RX_NO_TERMINATOR);
 
     return res;
 }
 
+/**
+ * @brief ask the camera to change its UART rate, the response comes back at the old rate
+ *
+ * @param rate new baud rate
+ * @param timeout_ms command timeout
+ * @return true if the camera acknowledged
+ */
+static bool lib_VC0706_request_baud(alt_u32 rate, alt_u32 timeout_ms) {
+    for (alt_u32 i = 0; i < (sizeof(VC0706_baud_table) / sizeof(VC0706_baud_table[0])); i++) {
+        if (VC0706_baud_table[i].rate == rate) {
+            alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, lib_VC0706_SET_PORT_CMD,
+                            lib_VC0706_SET_PORT_LEN, lib_VC0706_SET_PORT_UART, VC0706_baud_table[i].divisor_1,
+                            VC0706_baud_table[i].divisor_2};
+            volatile alt_u8 rx[5] = {0}; // 0x76+Serial number+0x24+0x00+0x00
+            return (lib_VC0706_execute_cmd(tx, sizeof(tx), rx, sizeof(rx), timeout_ms) == VC0706_SUCCESS);
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief handshake with the camera by reading its version string
+ *
+ * @param timeout_ms command timeout
+ * @return true if the camera answered correctly at the current rate
+ */
+static bool lib_VC0706_verify_link(alt_u32 timeout_ms) {
+    alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, lib_VC0706_GET_VERSION_CMD, 0x00};
+    volatile alt_u8 rx[lib_VC0706_GET_VERSION_RESPONSE_SIZE] = {0};
+    return (lib_VC0706_execute_cmd(tx, sizeof(tx), rx, sizeof(rx), timeout_ms) == VC0706_SUCCESS);
+}
+
 /* Public API */
 
 /**
@@ -291,13 +420,15 @@ lib_VC0706_result_E lib_VC0706_cmd_reset_camera(alt_u32 timeout_ms) {
         alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, lib_VC0706_RESET_CMD, 0x00};
         volatile alt_u8 rx[5] = {0}; // 0x76+Serial number+0x26+0x00+0x00
         res = lib_VC0706_execute_cmd(tx, sizeof(tx), rx, sizeof(rx), timeout_ms);
+        /* camera comes back up at its power on rate */
+        lib_baud_module_reset(&VC0706_baud);
         xSemaphoreGive(VC0706_state.mutex);
     }
     return res;
 }
 
 /**
- * @brief Set camera baud rate to 115200 baud (max baud)
+ * @brief Negotiate the camera up to 115200 baud (max baud), verifying every step. Also call after a camera reset.
  *
  * @param timeout_ms number of ms before command timeout
  * @return lib_VC0706_result_E
@@ -307,11 +438,30 @@ lib_VC0706_result_E lib_VC0706_increase_baud(alt_u32 timeout_ms) {
 
     /* grab mutex before running command */
     if (xSemaphoreTake(VC0706_state.mutex, lib_VC0706_MUTEX_WAIT_TIME_TICKS) == pdTRUE) {
-        alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, 0x24, 0x03, 0x01, 0x0d, 0xa6};
-        volatile alt_u8 rx[5] = {0}; // 0x76+Serial number+0x24+0x00+0x00
-        res = lib_VC0706_execute_cmd(tx, sizeof(tx), rx, sizeof(rx), timeout_ms);
-        /* set system uart to 115200 */
-        lib_uart_set_baud(VC0706_state.config->uart_base, 115200);
+        VC0706_baud.cmd_timeout_ms = timeout_ms;
+        if (lib_baud_negotiate(&VC0706_baud) != LIB_BAUD_ERROR) {
+            res = VC0706_SUCCESS;
+        }
+        xSemaphoreGive(VC0706_state.mutex);
+    }
+    return res;
+}
+
+/**
+ * @brief check the camera link for a spike in line errors, drops to a slower rate if needed
+ *
+ * @param timeout_ms number of ms before command timeout
+ * @return lib_VC0706_result_E VC0706_ERROR if the camera stopped answering and should be reset
+ */
+lib_VC0706_result_E lib_VC0706_check_baud(alt_u32 timeout_ms) {
+    lib_VC0706_result_E res = VC0706_ERROR;
+
+    /* grab mutex before running command */
+    if (xSemaphoreTake(VC0706_state.mutex, lib_VC0706_MUTEX_WAIT_TIME_TICKS) == pdTRUE) {
+        VC0706_baud.cmd_timeout_ms = timeout_ms;
+        if (lib_baud_check(&VC0706_baud) != LIB_BAUD_ERROR) {
+            res = VC0706_SUCCESS;
+        }
         xSemaphoreGive(VC0706_state.mutex);
     }
     return res;
@@ -357,6 +507,50 @@ lib_VC0706_result_E lib_VC0706_cmd_start_frame(alt_u32 timeout_ms) {
     return res;
 }
 
+/**
+ * @brief scale the captured image down, takes effect from the next frame the camera grabs
+ *
+ * @param size new image size
+ * @param timeout_ms number of ms before command timeout
+ * @return lib_VC0706_result_E
+ */
+lib_VC0706_result_E lib_VC0706_cmd_set_image_size(lib_VC0706_size_E size, alt_u32 timeout_ms) {
+    lib_VC0706_result_E res = VC0706_ERROR;
+
+    /* grab mutex before running command */
+    if (xSemaphoreTake(VC0706_state.mutex, lib_VC0706_MUTEX_WAIT_TIME_TICKS) == pdTRUE) {
+        alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, lib_VC0706_DOWNSIZE_CTRL_CMD,
+                        lib_VC0706_DOWNSIZE_CTRL_LEN, (alt_u8)size};
+        volatile alt_u8 rx[5] = {0}; // 0x76+serial number+0x54+0x00+0x00
+        res = lib_VC0706_execute_cmd(tx, sizeof(tx), rx, sizeof(rx), timeout_ms);
+        xSemaphoreGive(VC0706_state.mutex);
+    }
+    return res;
+}
+
+/**
+ * @brief set the JPEG compression ratio register, takes effect from the next frame the camera grabs. Reverts to
+ *        LIB_VC0706_DEFAULT_COMPRESSION on reset.
+ *
+ * @param ratio compression ratio 0x00-0xFF, higher gives smaller frames
+ * @param timeout_ms number of ms before command timeout
+ * @return lib_VC0706_result_E
+ */
+lib_VC0706_result_E lib_VC0706_cmd_set_compression(alt_u8 ratio, alt_u32 timeout_ms) {
+    lib_VC0706_result_E res = VC0706_ERROR;
+
+    /* grab mutex before running command */
+    if (xSemaphoreTake(VC0706_state.mutex, lib_VC0706_MUTEX_WAIT_TIME_TICKS) == pdTRUE) {
+        alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, lib_VC0706_WRITE_DATA_CMD,
+                        lib_VC0706_WRITE_DATA_LEN, lib_VC0706_WRITE_DATA_CHIP_REG, lib_VC0706_WRITE_DATA_BYTES,
+                        lib_VC0706_COMPRESSION_REG_H, lib_VC0706_COMPRESSION_REG_L, ratio};
+        volatile alt_u8 rx[5] = {0}; // 0x76+serial number+0x31+0x00+0x00
+        res = lib_VC0706_execute_cmd(tx, sizeof(tx), rx, sizeof(rx), timeout_ms);
+        xSemaphoreGive(VC0706_state.mutex);
+    }
+    return res;
+}
+
 
 lib_VC0706_result_E lib_VC0706_cmd_get_fbuf_len(alt_u32* data, alt_u32 timeout_ms) {
     lib_VC0706_result_E res = VC0706_ERROR;
@@ -378,10 +572,11 @@ lib_VC0706_result_E lib_VC0706_cmd_get_fbuf_len(alt_u32* data, alt_u32 timeout_m
 }
 
 /**
- * @brief Retrieve a single chunk of camera image data
+ * @brief Retrieve a single chunk of camera image data, the payload is received directly into dataptr without any
+ *        intermediate buffer. dataptr contents are undefined if the command fails.
  *
  * @param dataptr output camera data
- * @param timeout_ms operation timeout in ms
+ * @param timeout_ms maximum time without any data from the camera in ms
  * @param image_start_addr starting address of data to retrieve from camera
  * @param data_len number of bytes to retrieve from camera
  * @return lib_VC0706_result_E
@@ -393,24 +588,32 @@ lib_VC0706_result_E lib_VC0706_cmd_get_fbuf_data(alt_u8* dataptr, alt_u32 timeou
 
     /* grab mutex before running command */
     if (xSemaphoreTake(VC0706_state.mutex, lib_VC0706_MUTEX_WAIT_TIME_TICKS) == pdTRUE) {
-        /* partition starting address */
-        alt_u8 addr_1 = (alt_u8)(image_start_addr >> 24);
-        alt_u8 addr_2 = (alt_u8)(image_start_addr >> 16);
-        alt_u8 addr_3 = (alt_u8)(image_start_addr >> 8);
-        alt_u8 addr_4 = (alt_u8)image_start_addr;
-        /* partition length */
-        alt_u8 len_1 = (alt_u8)(data_len >> 24);
-        alt_u8 len_2 = (alt_u8)(data_len >> 16);
-        alt_u8 len_3 = (alt_u8)(data_len >> 8);
-        alt_u8 len_4 = (alt_u8)data_len;
-        alt_u8 tx[] = {lib_VC0706_REQUEST_HEADER, lib_VC0706_SERIAL_NUM, lib_VC0706_CAMERA_READ_FBUF_CMD,
-        lib_VC0706_CAMERA_READ_FBUF_CMD_2, lib_VC0706_CAMERA_READ_FBUF_CMD_3, lib_VC0706_CAMERA_READ_FBUF_CMD_4,
-        addr_1, addr_2, addr_3, addr_4, len_1, len_2, len_3, len_4, lib_VC0706_CAMERA_DELAY_B1,
-        lib_VC0706_CAMERA_DELAY_B2};
-        volatile alt_u8* rx = (alt_u8*)pvPortMalloc(data_len+10); //  0x76+serial+0x32+0x00+0x00 + data + 0x76+serial+0x32+0x00+0x00
-        res = lib_VC0706_execute_cmd(tx, sizeof(tx), rx, data_len+10, timeout_ms);
-        memcpy(dataptr, rx+5, data_len); // copy to output
-        vPortFree(rx);
+        res = lib_VC0706_read_fbuf(dataptr, image_start_addr, data_len, NULL, NULL, timeout_ms);
+        xSemaphoreGive(VC0706_state.mutex);
+    }
+    return res;
+}
+
+/**
+ * @brief Stream a large block of camera image data with a single READ_FBUF request. Data is drained from the RX ring
+ *        straight into dataptr as it arrives, so one command, header and trailer are paid for the whole block.
+ *
+ * @param dataptr output camera data, must hold data_len bytes
+ * @param image_start_addr starting address of data to retrieve from camera
+ * @param data_len number of bytes to retrieve from camera
+ * @param progress optional -> called as data lands with the image offset and size of the new data
+ * @param ctx passed through to the progress callback
+ * @param idle_timeout_ms maximum time without any data from the camera
+ * @return lib_VC0706_result_E
+ */
+lib_VC0706_result_E lib_VC0706_cmd_stream_fbuf_data(alt_u8* dataptr, alt_u32 image_start_addr, alt_u32 data_len,
+                                        lib_VC0706_progress_cb progress, void* ctx, alt_u32 idle_timeout_ms) {
+
+    lib_VC0706_result_E res = VC0706_ERROR;
+
+    /* grab mutex before running command */
+    if (xSemaphoreTake(VC0706_state.mutex, lib_VC0706_MUTEX_WAIT_TIME_TICKS) == pdTRUE) {
+        res = lib_VC0706_read_fbuf(dataptr, image_start_addr, data_len, progress, ctx, idle_timeout_ms);
         xSemaphoreGive(VC0706_state.mutex);
     }
     return res;
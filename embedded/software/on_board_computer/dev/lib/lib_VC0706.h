@@ -13,8 +13,18 @@
 /* HAL includes */
 #include "system.h"
 
+/* Public defines */
+#define LIB_VC0706_DEFAULT_COMPRESSION 0x36 // power on compression ratio, higher is smaller and blockier
+
 /* Public types */
 
+/* image size, DOWNSIZE_CTRL scales the 640x480 sensor output and applies without a reset */
+typedef enum {
+    VC0706_SIZE_640x480 = 0x00,
+    VC0706_SIZE_320x240 = 0x11,
+    VC0706_SIZE_160x120 = 0x22
+} lib_VC0706_size_E;
+
 /* result enum */
 typedef enum {
     VC0706_SUCCESS,
@@ -22,15 +32,26 @@ typedef enum {
     VC0706_ERROR
 } lib_VC0706_result_E;
 
+/**
+ * @brief streaming read progress callback, called from the reading task as data lands
+ *
+ */
+typedef void (*lib_VC0706_progress_cb)(alt_u32 offset, alt_u32 size, void* ctx);
+
 /* Public API */
 
 lib_VC0706_result_E lib_VC0706_init(alt_u32 UART_BASE, alt_u32 UART_IRQ);
 lib_VC0706_result_E lib_VC0706_increase_baud(alt_u32 timeout_ms);
+lib_VC0706_result_E lib_VC0706_check_baud(alt_u32 timeout_ms);
 lib_VC0706_result_E lib_VC0706_cmd_reset_camera(alt_u32 timeout_ms);
 lib_VC0706_result_E lib_VC0706_cmd_stop_frame(alt_u32 timeout_ms);
 lib_VC0706_result_E lib_VC0706_cmd_start_frame(alt_u32 timeout_ms);
+lib_VC0706_result_E lib_VC0706_cmd_set_image_size(lib_VC0706_size_E size, alt_u32 timeout_ms);
+lib_VC0706_result_E lib_VC0706_cmd_set_compression(alt_u8 ratio, alt_u32 timeout_ms);
 lib_VC0706_result_E lib_VC0706_cmd_get_fbuf_len(alt_u32* data, alt_u32 timeout_ms);
 lib_VC0706_result_E lib_VC0706_cmd_get_fbuf_data(alt_u8* dataptr, alt_u32 timeout_ms,
                                                     alt_u32 image_start_addr, alt_u32 data_len);
+lib_VC0706_result_E lib_VC0706_cmd_stream_fbuf_data(alt_u8* dataptr, alt_u32 image_start_addr, alt_u32 data_len,
+                                        lib_VC0706_progress_cb progress, void* ctx, alt_u32 idle_timeout_ms);
 
 #endif /* LIB_VC0706_H_ */
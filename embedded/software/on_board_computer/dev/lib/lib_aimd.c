@@ -0,0 +1,85 @@
+/**
+ * @file lib_aimd.c
+ * @author Emery Nagy
+ * @brief Additive increase, multiplicative decrease transfer window
+ * @version 0.1
+ * @date 2023-03-12
+ *
+ */
+
+/* lib includes */
+#include "lib_aimd.h"
+
+
+/* Private API */
+
+/**
+ * @brief round a size down to the window granularity and clamp it to the window limits
+ *
+ * @param window window the size is for
+ * @param size requested size
+ * @return alt_u32 usable size
+ */
+static alt_u32 lib_aimd_clamp(lib_aimd_S* window, alt_u32 size) {
+    size -= size % window->granularity;
+    if (size < window->min) {
+        size = window->min;
+    }
+    if (size > window->max) {
+        size = window->max;
+    }
+    return size;
+}
+
+
+/* Public API */
+
+/**
+ * @brief set up a window, min and max should already be multiples of the granularity
+ *
+ * @param window window to initialize
+ * @param min smallest window
+ * @param max largest window
+ * @param step additive increase per success
+ * @param granularity every window is a multiple of this, 1 for none
+ * @param initial starting window
+ */
+void lib_aimd_init(lib_aimd_S* window, alt_u32 min, alt_u32 max, alt_u32 step, alt_u32 granularity, alt_u32 initial) {
+    window->min = min;
+    window->max = max;
+    window->step = step;
+    window->granularity = (granularity == 0) ? 1 : granularity;
+    window->successes = 0;
+    window->failures = 0;
+    window->size = lib_aimd_clamp(window, initial);
+}
+
+/**
+ * @brief get the size of the next transfer
+ *
+ * @param window window to read
+ * @return alt_u32
+ */
+alt_u32 lib_aimd_size(lib_aimd_S* window) {
+    return window->size;
+}
+
+/**
+ * @brief transfer went through, probe a little bigger
+ *
+ * @param window window to grow
+ */
+void lib_aimd_success(lib_aimd_S* window) {
+    window->successes++;
+    window->size = lib_aimd_clamp(window, window->size + window->step);
+}
+
+/**
+ * @brief transfer failed, back off hard
+ *
+ * @param window window to shrink
+ */
+void lib_aimd_failure(lib_aimd_S* window) {
+    window->failures++;
+    window->size = lib_aimd_clamp(window, window->size / 2);
+}
@@ -0,0 +1,46 @@
+/**
+ * @file lib_aimd.h
+ * @author Emery Nagy
+ * @brief Additive increase, multiplicative decrease transfer window
+ * @version 0.1
+ * @date 2023-03-12
+ *
+ */
+
+#ifndef LIB_AIMD_H_
+#define LIB_AIMD_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* Public types */
+
+/**
+ * @brief transfer size window, grows by step on every success and halves on every failure. Sizes are kept a multiple
+ *        of the granularity.
+ *
+ */
+typedef struct {
+    /* current window in bytes */
+    alt_u32 size;
+    /* smallest window */
+    alt_u32 min;
+    /* largest window, buffers are sized from this */
+    alt_u32 max;
+    /* additive increase per success */
+    alt_u32 step;
+    /* every window is a multiple of this */
+    alt_u32 granularity;
+    /* successful transfers */
+    alt_u32 successes;
+    /* failed transfers */
+    alt_u32 failures;
+} lib_aimd_S;
+
+/* Public API */
+void lib_aimd_init(lib_aimd_S* window, alt_u32 min, alt_u32 max, alt_u32 step, alt_u32 granularity, alt_u32 initial);
+alt_u32 lib_aimd_size(lib_aimd_S* window);
+void lib_aimd_success(lib_aimd_S* window);
+void lib_aimd_failure(lib_aimd_S* window);
+
+#endif /* LIB_AIMD_H_ */
@@ -0,0 +1,223 @@
+/**
+ * @file lib_at_matcher.c
+ * @author Emery Nagy
+ * @brief Streaming multi-pattern matcher for AT command responses
+ * @version 0.1
+ * @date 2023-03-02
+ *
+ */
+
+/* lib includes */
+#include "lib_at_matcher.h"
+
+
+/* Private API */
+
+/**
+ * @brief find the child of a node reached by a character
+ *
+ * @param matcher matcher to search
+ * @param node parent node
+ * @param c character to follow
+ * @return alt_u8 child node, LIB_AT_MATCHER_NO_NODE if there is none
+ */
+static alt_u8 lib_at_matcher_find_child(lib_at_matcher_S* matcher, alt_u8 node, alt_u8 c) {
+    alt_u8 child = matcher->nodes[node].child;
+    while ((child != LIB_AT_MATCHER_NO_NODE) && (matcher->nodes[child].c != c)) {
+        child = matcher->nodes[child].sibling;
+    }
+    return child;
+}
+
+
+/* Public API */
+
+/**
+ * @brief clear all patterns, leaves only the root node
+ *
+ * @param matcher matcher to initialize
+ */
+void lib_at_matcher_init(lib_at_matcher_S* matcher) {
+    matcher->nodes[LIB_AT_MATCHER_ROOT] = (lib_at_matcher_node_S){
+        .c = 0,
+        .child = LIB_AT_MATCHER_NO_NODE,
+        .sibling = LIB_AT_MATCHER_NO_NODE,
+        .fail = LIB_AT_MATCHER_ROOT,
+        .output = 0
+    };
+    matcher->node_count = 1;
+    matcher->pattern_count = 0;
+    matcher->required_mask = 0;
+    matcher->final_mask = 0;
+    lib_at_matcher_reset(matcher);
+}
+
+/**
+ * @brief add a pattern to the trie, must be followed by lib_at_matcher_compile before stepping
+ *
+ * @param matcher matcher to add to
+ * @param pattern pattern bytes, does not need to be null terminated
+ * @param len pattern length in bytes
+ * @param kind how the pattern affects response completion
+ * @return lib_at_matcher_result_E LIB_AT_MATCHER_ERROR if the pattern or node table is full
+ */
+lib_at_matcher_result_E lib_at_matcher_add(lib_at_matcher_S* matcher, const char* pattern, alt_u32 len, lib_at_matcher_kind_E kind) {
+    lib_at_matcher_result_E res = LIB_AT_MATCHER_ERROR;
+
+    do {
+        if ((len == 0) || (matcher->pattern_count >= LIB_AT_MATCHER_MAX_PATTERNS)) {
+            break;
+        }
+
+        alt_u8 node = LIB_AT_MATCHER_ROOT;
+        alt_u32 i;
+        for (i = 0; i < len; i++) {
+            alt_u8 c = (alt_u8)pattern[i];
+            alt_u8 child = lib_at_matcher_find_child(matcher, node, c);
+            if (child == LIB_AT_MATCHER_NO_NODE) {
+                if (matcher->node_count >= LIB_AT_MATCHER_MAX_NODES) {
+                    break;
+                }
+                child = matcher->node_count++;
+                matcher->nodes[child] = (lib_at_matcher_node_S){
+                    .c = c,
+                    .child = LIB_AT_MATCHER_NO_NODE,
+                    .sibling = matcher->nodes[node].child,
+                    .fail = LIB_AT_MATCHER_ROOT,
+                    .output = 0
+                };
+                matcher->nodes[node].child = child;
+            }
+            node = child;
+        }
+
+        /* out of nodes, the partial branch is harmless since it has no output */
+        if (i != len) {
+            break;
+        }
+
+        alt_u8 bit = 1 << matcher->pattern_count++;
+        matcher->nodes[node].output |= bit;
+        if (kind == LIB_AT_MATCHER_FINAL) {
+            matcher->final_mask |= bit;
+        } else {
+            matcher->required_mask |= bit;
+        }
+        res = LIB_AT_MATCHER_SUCCESS;
+    } while (0);
+
+    return res;
+}
+
+/**
+ * @brief compute fail links breadth first and fold outputs along them, then reset the automaton
+ *
+ * @param matcher matcher to compile
+ */
+void lib_at_matcher_compile(lib_at_matcher_S* matcher) {
+    alt_u8 queue[LIB_AT_MATCHER_MAX_NODES];
+    alt_u32 head = 0;
+    alt_u32 tail = 0;
+
+    /* depth 1 nodes always fail back to the root */
+    for (alt_u8 child = matcher->nodes[LIB_AT_MATCHER_ROOT].child; child != LIB_AT_MATCHER_NO_NODE;
+                                                                        child = matcher->nodes[child].sibling) {
+        matcher->nodes[child].fail = LIB_AT_MATCHER_ROOT;
+        queue[tail++] = child;
+    }
+
+    while (head != tail) {
+        alt_u8 node = queue[head++];
+        for (alt_u8 child = matcher->nodes[node].child; child != LIB_AT_MATCHER_NO_NODE;
+                                                                        child = matcher->nodes[child].sibling) {
+            alt_u8 c = matcher->nodes[child].c;
+            alt_u8 fail = matcher->nodes[node].fail;
+            alt_u8 next;
+            while (((next = lib_at_matcher_find_child(matcher, fail, c)) == LIB_AT_MATCHER_NO_NODE) &&
+                    (fail != LIB_AT_MATCHER_ROOT)) {
+                fail = matcher->nodes[fail].fail;
+            }
+            matcher->nodes[child].fail = (next != LIB_AT_MATCHER_NO_NODE) ? next : LIB_AT_MATCHER_ROOT;
+            matcher->nodes[child].output |= matcher->nodes[matcher->nodes[child].fail].output;
+            queue[tail++] = child;
+        }
+    }
+
+    lib_at_matcher_reset(matcher);
+}
+
+/**
+ * @brief restart matching from the root, keeps the compiled patterns
+ *
+ * @param matcher matcher to reset
+ */
+void lib_at_matcher_reset(lib_at_matcher_S* matcher) {
+    matcher->state = LIB_AT_MATCHER_ROOT;
+    matcher->seen = 0;
+    matcher->done = false;
+}
+
+/**
+ * @brief feed one received byte through the automaton, safe to call from the UART RX irq. Completion is only
+ *        evaluated at the end of a line so the whole result or URC line is available to the caller.
+ *
+ * @param matcher matcher to step
+ * @param c received byte
+ * @return true if this byte completed the response
+ */
+bool lib_at_matcher_step(lib_at_matcher_S* matcher, alt_u8 c) {
+    if (matcher->done) {
+        return false;
+    }
+
+    alt_u8 node = matcher->state;
+    alt_u8 next;
+    while (((next = lib_at_matcher_find_child(matcher, node, c)) == LIB_AT_MATCHER_NO_NODE) &&
+            (node != LIB_AT_MATCHER_ROOT)) {
+        node = matcher->nodes[node].fail;
+    }
+    node = (next != LIB_AT_MATCHER_NO_NODE) ? next : LIB_AT_MATCHER_ROOT;
+
+    matcher->state = node;
+    matcher->seen |= matcher->nodes[node].output;
+
+    if (c == '\n') {
+        if (((matcher->seen & matcher->required_mask) == matcher->required_mask) ||
+            ((matcher->seen & matcher->final_mask) != 0)) {
+            matcher->done = true;
+        }
+    }
+
+    return matcher->done;
+}
+
+/**
+ * @brief check if the response has finished, either successfully or on a final pattern
+ *
+ * @param matcher matcher to check
+ * @return bool
+ */
+bool lib_at_matcher_done(lib_at_matcher_S* matcher) {
+    return matcher->done;
+}
+
+/**
+ * @brief check if every required pattern has been seen
+ *
+ * @param matcher matcher to check
+ * @return bool
+ */
+bool lib_at_matcher_complete(lib_at_matcher_S* matcher) {
+    return (matcher->seen & matcher->required_mask) == matcher->required_mask;
+}
+
+/**
+ * @brief check if a single pattern has been seen
+ *
+ * @param matcher matcher to check
+ * @param pattern_id id of the pattern, assigned in the order patterns were added
+ * @return bool
+ */
+bool lib_at_matcher_seen(lib_at_matcher_S* matcher, alt_u8 pattern_id) {
+    return (matcher->seen & (1 << pattern_id)) != 0;
+}
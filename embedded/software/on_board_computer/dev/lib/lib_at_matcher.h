@@ -0,0 +1,95 @@
+/**
+ * @file lib_at_matcher.h
+ * @author Emery Nagy
+ * @brief Streaming multi-pattern matcher for AT command responses
+ * @version 0.1
+ * @date 2023-03-02
+ *
+ */
+
+#ifndef LIB_AT_MATCHER_H_
+#define LIB_AT_MATCHER_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* stdlib includes */
+#include "stdbool.h"
+
+/* Public defines */
+#define LIB_AT_MATCHER_MAX_PATTERNS 8 // one bit per pattern in the seen mask
+#define LIB_AT_MATCHER_MAX_NODES 96 // total trie nodes, root + sum of pattern lengths worst case
+#define LIB_AT_MATCHER_ROOT 0
+#define LIB_AT_MATCHER_NO_NODE 0xFF
+
+/* Public types */
+
+/**
+ * @brief how a pattern affects completion of the response
+ *
+ */
+typedef enum {
+    LIB_AT_MATCHER_REQUIRED, // response is complete once every required pattern has been seen (ie OK and the URC)
+    LIB_AT_MATCHER_FINAL // response is complete as soon as this pattern has been seen (ie ERROR)
+} lib_at_matcher_kind_E;
+
+/**
+ * @brief matcher result enum
+ *
+ */
+typedef enum {
+    LIB_AT_MATCHER_SUCCESS,
+    LIB_AT_MATCHER_ERROR
+} lib_at_matcher_result_E;
+
+/**
+ * @brief one trie node, children are kept as a sibling list since responses only use a handful of characters
+ *
+ */
+typedef struct {
+    /* character leading into this node */
+    alt_u8 c;
+    /* first child node */
+    alt_u8 child;
+    /* next node with the same parent */
+    alt_u8 sibling;
+    /* longest proper suffix of this node that is also a trie prefix */
+    alt_u8 fail;
+    /* mask of patterns ending at this node or any node on its fail chain */
+    alt_u8 output;
+} lib_at_matcher_node_S;
+
+/**
+ * @brief Aho-Corasick automaton, built in task context and stepped one byte at a time from the UART RX irq
+ *
+ */
+typedef struct {
+    /* trie storage, node 0 is the root */
+    lib_at_matcher_node_S nodes[LIB_AT_MATCHER_MAX_NODES];
+    /* number of nodes in use */
+    alt_u8 node_count;
+    /* number of patterns added, pattern ids are assigned in order */
+    alt_u8 pattern_count;
+    /* patterns that must all be seen */
+    alt_u8 required_mask;
+    /* patterns that end the response on their own */
+    alt_u8 final_mask;
+    /* current automaton node */
+    volatile alt_u8 state;
+    /* mask of patterns seen since the last reset */
+    volatile alt_u8 seen;
+    /* set once the response is complete, the automaton stops consuming bytes */
+    volatile bool done;
+} lib_at_matcher_S;
+
+/* Public API */
+void lib_at_matcher_init(lib_at_matcher_S* matcher);
+lib_at_matcher_result_E lib_at_matcher_add(lib_at_matcher_S* matcher, const char* pattern, alt_u32 len, lib_at_matcher_kind_E kind);
+void lib_at_matcher_compile(lib_at_matcher_S* matcher);
+void lib_at_matcher_reset(lib_at_matcher_S* matcher);
+bool lib_at_matcher_step(lib_at_matcher_S* matcher, alt_u8 c);
+bool lib_at_matcher_done(lib_at_matcher_S* matcher);
+bool lib_at_matcher_complete(lib_at_matcher_S* matcher);
+bool lib_at_matcher_seen(lib_at_matcher_S* matcher, alt_u8 pattern_id);
+
+#endif /* LIB_AT_MATCHER_H_ */
@@ -10,6 +10,9 @@
 /* HAL includes */
 #include "system.h"
 
+/* FreeRTOS includes */
+#include "FreeRTOS.h"
+
 /* lib includes */
 #include "lib_base64.h"
 
@@ -18,16 +21,135 @@
 #include "stdio.h"
 
 /* macros */
-#define LIB_BASE64_FIRST_ITEM(buf) (alt_u8)((buf[0] & 0b11111100) >> 2)
-#define LIB_BASE64_SECOND_ITEM(buf) (alt_u8)(((buf[0] & 0b00000011) << 4) | ((buf[1] & 0b11110000) >> 4))
-#define LIB_BASE64_THIRD_ITEM(buf) (alt_u8)(((buf[1] & 0b00001111) << 2) | ((buf[2] & 0b11000000) >> 6))
-#define LIB_BASE64_FOURTH_ITEM(buf) (alt_u8)(buf[2] & 0b00111111)
+#define LIB_BASE64_CHAR(v) ((alt_u8)(((v) < 26) ? ('A' + (v)) : ((v) < 52) ? ('a' + (v) - 26) : \
+                                     ((v) < 62) ? ('0' + (v) - 52) : ((v) == 62) ? '+' : '/'))
+#define LIB_BASE64_PAIR(i) {LIB_BASE64_CHAR(((i) >> 6) & 0x3F), LIB_BASE64_CHAR((i) & 0x3F)}
+#define LIB_BASE64_PAIR4(i) LIB_BASE64_PAIR(i), LIB_BASE64_PAIR((i) + 1), LIB_BASE64_PAIR((i) + 2), \
+                            LIB_BASE64_PAIR((i) + 3)
+#define LIB_BASE64_PAIR16(i) LIB_BASE64_PAIR4(i), LIB_BASE64_PAIR4((i) + 4), LIB_BASE64_PAIR4((i) + 8), \
+                             LIB_BASE64_PAIR4((i) + 12)
+#define LIB_BASE64_PAIR64(i) LIB_BASE64_PAIR16(i), LIB_BASE64_PAIR16((i) + 16), LIB_BASE64_PAIR16((i) + 32), \
+                             LIB_BASE64_PAIR16((i) + 48)
+#define LIB_BASE64_PAIR256(i) LIB_BASE64_PAIR64(i), LIB_BASE64_PAIR64((i) + 64), LIB_BASE64_PAIR64((i) + 128), \
+                              LIB_BASE64_PAIR64((i) + 192)
+#define LIB_BASE64_PAIR1024(i) LIB_BASE64_PAIR256(i), LIB_BASE64_PAIR256((i) + 256), LIB_BASE64_PAIR256((i) + 512), \
+                               LIB_BASE64_PAIR256((i) + 768)
+
+/* offline tools build this file for the host, use SSSE3 there when the compiler allows it */
+#if !defined(__nios2__) && defined(__SSSE3__)
+#define LIB_BASE64_HOST_SSSE3 1
+#include <tmmintrin.h>
+#else
+#define LIB_BASE64_HOST_SSSE3 0
+#endif
 
 /* private data */
-static alt_u8 encoding[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R',
-                            'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j',
-                            'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '0', '1',
-                            '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+
+/* 12 input bits to both of their output characters, two lookups per 3 byte group. 8KB of rodata, generated at
+   compile time so nothing runs at boot */
+static const alt_u8 pairs[4096][2] = {LIB_BASE64_PAIR1024(0), LIB_BASE64_PAIR1024(1024), LIB_BASE64_PAIR1024(2048),
+                                      LIB_BASE64_PAIR1024(3072)};
+
+/* private functions */
+
+#if LIB_BASE64_HOST_SSSE3
+/**
+ * @brief encode 4 groups per iteration with SSSE3, leaves the rest to the table. Loads are 16 bytes wide, so it
+ *        stops while at least 6 groups remain to stay inside the input.
+ *
+ * @param in input groups
+ * @param groups number of 3 byte groups
+ * @param out 4 output characters per group
+ * @return alt_u32 groups encoded
+ */
+static alt_u32 lib_base64_encode_groups_ssse3(const alt_u8* in, alt_u32 groups, alt_u8* out) {
+    const __m128i spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    alt_u32 done = 0;
+
+    for (; (done + 6) <= groups; done += 4) {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + (done * 3))), spread);
+
+        /* split every 24 bits into four 6 bit indices, one per output byte */
+        __m128i hi = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        __m128i idx = _mm_or_si128(hi, lo);
+
+        /* map each index range to the offset that turns it into its character */
+        __m128i range = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+        _mm_storeu_si128((__m128i*)(out + (done * 4)), _mm_add_epi8(_mm_shuffle_epi8(offsets, range), idx));
+    }
+
+    return done;
+}
+#endif
+
+/**
+ * @brief encode full 3 byte groups
+ *
+ * @param in input groups
+ * @param groups number of 3 byte groups
+ * @param out 4 output characters per group
+ */
+static void lib_base64_encode_groups(const alt_u8* in, alt_u32 groups, alt_u8* out) {
+    alt_u32 i = 0;
+
+#if LIB_BASE64_HOST_SSSE3
+    i = lib_base64_encode_groups_ssse3(in, groups, out);
+    in += i * 3;
+    out += i * 4;
+#endif
+
+    for (; i < groups; i++) {
+        alt_u32 bits = ((alt_u32)in[0] << 16) | ((alt_u32)in[1] << 8) | in[2];
+        const alt_u8* first = pairs[bits >> 12];
+        const alt_u8* second = pairs[bits & 0xFFF];
+        out[0] = first[0];
+        out[1] = first[1];
+        out[2] = second[0];
+        out[3] = second[1];
+        in += 3;
+        out += 4;
+    }
+}
+
+/**
+ * @brief encode the 1 or 2 bytes after the last full group with padding
+ *
+ * @param in trailing bytes
+ * @param len 1 or 2
+ * @param out 4 output characters
+ */
+static void lib_base64_encode_tail(const alt_u8* in, alt_u32 len, alt_u8* out) {
+    alt_u32 bits = (alt_u32)in[0] << 16;
+    if (len == 2) {
+        bits |= (alt_u32)in[1] << 8;
+    }
+
+    const alt_u8* first = pairs[bits >> 12];
+    out[0] = first[0];
+    out[1] = first[1];
+    out[2] = (len == 2) ? pairs[bits & 0xFFF][0] : '=';
+    out[3] = '=';
+}
+
+/**
+ * @brief hand encoded text to the sink
+ *
+ * @param ctx encoder
+ * @param data encoded text
+ * @param len number of characters
+ * @return true if the sink took it
+ */
+static bool lib_base64_emit(lib_base64_ctx_S* ctx, const alt_u8* data, alt_u32 len) {
+    if (!ctx->sink(data, len, ctx->sink_ctx)) {
+        return false;
+    }
+    ctx->encoded += len;
+    return true;
+}
 
 /* public API */
 
@@ -40,57 +162,15 @@ static alt_u8 encoding[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K
  * @return unsigned* with pointer to encoded string
  */
 unsigned char* lib_base64_encode(alt_u8* data, alt_u32 size, alt_u32* outsize) {
-
-    alt_u8 pad = 0;
-
-    if (size == APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE) {
-        *outsize = LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE;
-    }
-    else if (size % 3 == 0) {
-        *outsize = (size/3)*4;
-    } else if (size % 3 == 1) {
-        *outsize = ((size - 1)/3)*4 + 4; // double the main part + trailing byte and 2 pad
-        pad = 2;
-    } else {
-        /* size % 3 == 2 */
-        *outsize = ((size - 2)/3)*4 + 4; // double the main part + 2 trailing byte and pad
-        pad = 1;
-    }
+    *outsize = LIB_BASE64_ENCODED_SIZE(size);
 
     unsigned char* outmem = (unsigned char*) pvPortMalloc(*outsize + 1);
 
-    /* process all except for the last 3 bytes */
-    int outindex = 0;
-    for (int i = 0; i <= (size - 3); i+=3) {
-        alt_u8* curr_chunk = data + i;
-        outmem[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        outmem[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        outmem[outindex + 2] = encoding[LIB_BASE64_THIRD_ITEM(curr_chunk)];
-        outmem[outindex + 3] = encoding[LIB_BASE64_FOURTH_ITEM(curr_chunk)];
-        outindex += 4;
-    }
-
-    /* apply pad to last 3 bytes */
-    if (pad == 2) {
-        //printf("\nhere 2, outsize %d, realsize %d\n", *outsize, size);
-        alt_u8 curr_chunk[] = {data[size - 1], 0x00, 0x00};
-        outmem[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        outmem[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        outmem[outindex + 2] = '=';
-        outmem[outindex + 3] = '=';
-    } else if (pad == 1) {
-        //printf("\nhere outsize %d, realsize %d\n", *outsize, size);
-        alt_u8 curr_chunk[] = {data[size - 2], data[size - 1], 0x00};
-        outmem[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        outmem[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        outmem[outindex + 2] = encoding[LIB_BASE64_THIRD_ITEM(curr_chunk)];
-        outmem[outindex + 3] = '=';
-    } else {
-        alt_u8 curr_chunk[] = {data[size - 3], data[size - 2], data[size - 1]};
-        outmem[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        outmem[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        outmem[outindex + 2] = encoding[LIB_BASE64_THIRD_ITEM(curr_chunk)];
-        outmem[outindex + 3] = encoding[LIB_BASE64_FOURTH_ITEM(curr_chunk)];
+    /* full groups through the kernel, a partial last group is padded once */
+    alt_u32 groups = size / 3;
+    lib_base64_encode_groups(data, groups, outmem);
+    if ((size % 3) != 0) {
+        lib_base64_encode_tail(data + (groups * 3), size % 3, outmem + (groups * 4));
     }
 
     outmem[*outsize] = '\0'; /* increase speed later in pipeline*/
@@ -110,62 +190,104 @@ unsigned char* lib_base64_encode(alt_u8* data, alt_u32 size, alt_u32* outsize) {
  * @return false
  */
 bool lib_base64_encode_static(alt_u8* data_in, alt_u32 size_in, alt_u32* size_out, alt_u8* data_out, alt_u32 static_buf_maxsize) {
-    alt_u8 pad = 0;
-
-    if (size_in == APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE) {
-        *size_out = LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE;
-    }
-    else if (size_in % 3 == 0) {
-        *size_out = (size_in/3)*4;
-    } else if (size_in % 3 == 1) {
-        *size_out = ((size_in - 1)/3)*4 + 4; // double the main part + trailing byte and 2 pad
-        pad = 2;
-    } else {
-        /* size % 3 == 2 */
-        *size_out = ((size_in - 2)/3)*4 + 4; // double the main part + 2 trailing byte and pad
-        pad = 1;
-    }
+    *size_out = LIB_BASE64_ENCODED_SIZE(size_in);
 
     /* check that databuffer provided will fit encoded data */
     if (*size_out + 1 > static_buf_maxsize) {
         return false;
     }
 
-    /* process all except for the last 3 bytes */
-    int outindex = 0;
-    for (int i = 0; i <= (size_in - 3); i+=3) {
-        alt_u8* curr_chunk = data_in + i;
-        data_out[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        data_out[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        data_out[outindex + 2] = encoding[LIB_BASE64_THIRD_ITEM(curr_chunk)];
-        data_out[outindex + 3] = encoding[LIB_BASE64_FOURTH_ITEM(curr_chunk)];
-        outindex += 4;
-    }
-
-    /* apply pad to last 3 bytes */
-    if (pad == 2) {
-        //printf("\nhere 2, outsize %d, realsize %d\n", *outsize, size);
-        alt_u8 curr_chunk[] = {data_in[size_in - 1], 0x00, 0x00};
-        data_out[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        data_out[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        data_out[outindex + 2] = '=';
-        data_out[outindex + 3] = '=';
-    } else if (pad == 1) {
-        //printf("\nhere outsize %d, realsize %d\n", *outsize, size);
-        alt_u8 curr_chunk[] = {data_in[size_in - 2], data_in[size_in - 1], 0x00};
-        data_out[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        data_out[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        data_out[outindex + 2] = encoding[LIB_BASE64_THIRD_ITEM(curr_chunk)];
-        data_out[outindex + 3] = '=';
-    } else {
-        alt_u8 curr_chunk[] = {data_in[size_in - 3], data_in[size_in - 2], data_in[size_in - 1]};
-        data_out[outindex] = encoding[LIB_BASE64_FIRST_ITEM(curr_chunk)];
-        data_out[outindex + 1] = encoding[LIB_BASE64_SECOND_ITEM(curr_chunk)];
-        data_out[outindex + 2] = encoding[LIB_BASE64_THIRD_ITEM(curr_chunk)];
-        data_out[outindex + 3] = encoding[LIB_BASE64_FOURTH_ITEM(curr_chunk)];
+    /* full groups through the kernel, a partial last group is padded once */
+    alt_u32 groups = size_in / 3;
+    lib_base64_encode_groups(data_in, groups, data_out);
+    if ((size_in % 3) != 0) {
+        lib_base64_encode_tail(data_in + (groups * 3), size_in % 3, data_out + (groups * 4));
     }
 
     data_out[*size_out] = '\0'; /* increase speed later in pipeline*/
 
     return true;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief start a new encoding
+ *
+ * @param ctx encoder to reset
+ * @param sink where encoded text goes
+ * @param sink_ctx passed through to the sink
+ */
+void lib_base64_init(lib_base64_ctx_S* ctx, lib_base64_sink sink, void* sink_ctx) {
+    ctx->carry_len = 0;
+    ctx->sink = sink;
+    ctx->sink_ctx = sink_ctx;
+    ctx->encoded = 0;
+}
+
+/**
+ * @brief encode the next piece of input, any size. Whole groups go to the sink in blocks of at most
+ *        LIB_BASE64_STREAM_BLOCK characters, a partial group at the end is carried into the next call.
+ *
+ * @param ctx encoder
+ * @param data input bytes
+ * @param len number of input bytes
+ * @return true unless the sink aborted
+ */
+bool lib_base64_update(lib_base64_ctx_S* ctx, const alt_u8* data, alt_u32 len) {
+    alt_u8 block[LIB_BASE64_STREAM_BLOCK];
+    alt_u32 out = 0;
+    alt_u32 i = 0;
+
+    /* finish the group left over from the last call first */
+    if (ctx->carry_len > 0) {
+        while ((ctx->carry_len < 3) && (i < len)) {
+            ctx->carry[ctx->carry_len++] = data[i++];
+        }
+        if (ctx->carry_len < 3) {
+            return true;
+        }
+        lib_base64_encode_groups(ctx->carry, 1, block);
+        ctx->carry_len = 0;
+        out = 4;
+    }
+
+    /* fill the block as far as the input goes, emit it whenever it is full */
+    while ((i + 3) <= len) {
+        if (out == LIB_BASE64_STREAM_BLOCK) {
+            if (!lib_base64_emit(ctx, block, out)) {
+                return false;
+            }
+            out = 0;
+        }
+        alt_u32 groups = (len - i) / 3;
+        if (groups > ((LIB_BASE64_STREAM_BLOCK - out) / 4)) {
+            groups = (LIB_BASE64_STREAM_BLOCK - out) / 4;
+        }
+        lib_base64_encode_groups(data + i, groups, block + out);
+        i += groups * 3;
+        out += groups * 4;
+    }
+
+    while (i < len) {
+        ctx->carry[ctx->carry_len++] = data[i++];
+    }
+
+    return (out == 0) || lib_base64_emit(ctx, block, out);
+}
+
+/**
+ * @brief end the encoding, pads the carried partial group if there is one
+ *
+ * @param ctx encoder
+ * @return true unless the sink aborted
+ */
+bool lib_base64_final(lib_base64_ctx_S* ctx) {
+    if (ctx->carry_len == 0) {
+        return true;
+    }
+
+    alt_u8 block[4];
+    lib_base64_encode_tail(ctx->carry, ctx->carry_len, block);
+    ctx->carry_len = 0;
+
+    return lib_base64_emit(ctx, block, sizeof(block));
+}
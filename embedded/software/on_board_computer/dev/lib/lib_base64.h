@@ -12,16 +12,43 @@
 
 #include "system.h"
 #include "alt_types.h"
-#include "app_camera.h" // note this is for optimization - not good practice
 #include "stdbool.h"
 
 
 /* public defines */
-#define LIB_BASE64_DEFAULT_CAMERA_ENCODE_SIZE (APP_CAMERA_DEFAULT_STREAM_CHUNK_SIZE/3)*(4)
+#define LIB_BASE64_ENCODED_SIZE(size) ((((size) + 2) / 3) * 4) // encoded length of size bytes, not counting the NULL
+#define LIB_BASE64_STREAM_BLOCK 64 // encoded bytes handed to a sink at a time, multiple of 4
+
+/* public types */
+
+/**
+ * @brief streaming encoder output, called with encoded text as it is produced. Return false to abort the stream.
+ *
+ */
+typedef bool (*lib_base64_sink)(const alt_u8* data, alt_u32 len, void* sink_ctx);
+
+/**
+ * @brief incremental encoder, input of any size can be fed in pieces and only the final call pads. Small enough to
+ *        copy, so a caller can snapshot it and retry a piece.
+ *
+ */
+typedef struct {
+    /* 0-2 bytes left over from the last update, waiting for the rest of their group */
+    alt_u8 carry[3];
+    alt_u32 carry_len;
+    /* where encoded text goes */
+    lib_base64_sink sink;
+    void* sink_ctx;
+    /* encoded bytes handed to the sink so far */
+    alt_u32 encoded;
+} lib_base64_ctx_S;
 
 /* public API */
 unsigned char* lib_base64_encode(alt_u8* data, alt_u32 size, alt_u32* outsize);
 bool lib_base64_encode_static(alt_u8* data_in, alt_u32 size_in, alt_u32* size_out, alt_u8* data_out, alt_u32 static_buf_maxsize);
+void lib_base64_init(lib_base64_ctx_S* ctx, lib_base64_sink sink, void* sink_ctx);
+bool lib_base64_update(lib_base64_ctx_S* ctx, const alt_u8* data, alt_u32 len);
+bool lib_base64_final(lib_base64_ctx_S* ctx);
 
 
 #endif /* LIB_BASE64_H_ */
\ No newline at end of file
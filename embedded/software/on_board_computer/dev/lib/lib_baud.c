@@ -0,0 +1,152 @@
+/**
+ * @file lib_baud.c
+ * @author Emery Nagy
+ * @brief Staged baud rate negotiation between a UART port and the module behind it
+ * @version 0.1
+ * @date 2023-03-04
+ *
+ */
+
+/* FreeRTOS includes */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* lib includes */
+#include "lib_uart.h"
+#include "lib_baud.h"
+
+
+/* Private API */
+
+/**
+ * @brief move the local side of the link to a stage and give the module time to settle
+ *
+ * @param link link to change
+ * @param stage new stage
+ */
+static void lib_baud_set_stage(lib_baud_link_S* link, alt_u32 stage) {
+    lib_uart_set_baud(link->config, link->rates[stage]);
+    link->stage = stage;
+    vTaskDelay(pdMS_TO_TICKS(LIB_BAUD_SETTLE_MS));
+}
+
+/**
+ * @brief find the rate the module is actually at by trying every stage, power on rate first
+ *
+ * @param link link to resync
+ * @return lib_baud_result_E
+ */
+static lib_baud_result_E lib_baud_resync(lib_baud_link_S* link) {
+    for (alt_u32 stage = 0; stage < link->stage_count; stage++) {
+        lib_baud_set_stage(link, stage);
+        if (link->verify(link->cmd_timeout_ms)) {
+            return LIB_BAUD_SUCCESS;
+        }
+    }
+
+    /* nobody answered, park at the power on rate for the reset that should follow */
+    lib_baud_set_stage(link, 0);
+    return LIB_BAUD_ERROR;
+}
+
+
+/* Public API */
+
+/**
+ * @brief climb the rate ladder one stage at a time: request the next rate, switch locally, then verify. A stage that
+ *        fails verification becomes the new ceiling and the link drops back to the last good rate.
+ *
+ * @param link link to negotiate
+ * @return lib_baud_result_E
+ */
+lib_baud_result_E lib_baud_negotiate(lib_baud_link_S* link) {
+    lib_baud_result_E res = LIB_BAUD_FIXED;
+
+    do {
+        if (link->config->fixed_baud) {
+            break;
+        }
+
+        /* make sure we agree with the module on where we start from */
+        res = LIB_BAUD_SUCCESS;
+        if (!link->verify(link->cmd_timeout_ms)) {
+            res = lib_baud_resync(link);
+            if (res != LIB_BAUD_SUCCESS) {
+                break;
+            }
+        }
+
+        while (link->stage < link->ceiling) {
+            alt_u32 good = link->stage;
+
+            /* module refused the rate, no harm done */
+            if (!link->request(link->rates[good + 1], link->cmd_timeout_ms)) {
+                link->ceiling = good;
+                break;
+            }
+
+            lib_baud_set_stage(link, good + 1);
+            if (!link->verify(link->cmd_timeout_ms)) {
+                link->ceiling = good;
+                res = lib_baud_resync(link);
+                break;
+            }
+        }
+
+        link->error_mark = lib_uart_rx_error_count(link->config);
+    } while (0);
+
+    return res;
+}
+
+/**
+ * @brief periodic link health check, steps the link down a stage if line errors spiked since the last check
+ *
+ * @param link link to check
+ * @return lib_baud_result_E
+ */
+lib_baud_result_E lib_baud_check(lib_baud_link_S* link) {
+    lib_baud_result_E res = LIB_BAUD_FIXED;
+
+    do {
+        if (link->config->fixed_baud) {
+            break;
+        }
+
+        alt_u32 count = lib_uart_rx_error_count(link->config);
+        alt_u32 errors = count - link->error_mark;
+        link->error_mark = count;
+
+        res = LIB_BAUD_SUCCESS;
+        if ((errors <= link->error_limit) || (link->stage == 0)) {
+            break;
+        }
+
+        /* the request goes out over the noisy link, so confirm the new rate rather than trusting the ack */
+        alt_u32 lower = link->stage - 1;
+        link->ceiling = lower;
+        link->request(link->rates[lower], link->cmd_timeout_ms);
+        lib_baud_set_stage(link, lower);
+        if (!link->verify(link->cmd_timeout_ms)) {
+            res = lib_baud_resync(link);
+        }
+
+        link->error_mark = lib_uart_rx_error_count(link->config);
+    } while (0);
+
+    return res;
+}
+
+/**
+ * @brief the module was reset and is back at its power on rate, follow it. Call lib_baud_negotiate once the module is
+ *        responsive again to climb back up.
+ *
+ * @param link link to reset
+ */
+void lib_baud_module_reset(lib_baud_link_S* link) {
+    if (!link->config->fixed_baud) {
+        lib_uart_set_baud(link->config, link->rates[0]);
+        link->stage = 0;
+    }
+    link->error_mark = lib_uart_rx_error_count(link->config);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file lib_baud.h
+ * @author Emery Nagy
+ * @brief Staged baud rate negotiation between a UART port and the module behind it
+ * @version 0.1
+ * @date 2023-03-04
+ *
+ */
+
+#ifndef LIB_BAUD_H_
+#define LIB_BAUD_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* stdlib includes */
+#include "stdbool.h"
+
+/* lib includes */
+#include "lib_uart.h"
+
+/* Public defines */
+#define LIB_BAUD_MAX_STAGES 4
+#define LIB_BAUD_SETTLE_MS 20 // time for the module to switch rates after acknowledging
+#define LIB_BAUD_DEFAULT_ERROR_LIMIT 8 // line errors tolerated between two checks before stepping down
+
+/* Public types */
+
+/**
+ * @brief ask the module to move to a new rate, sent at the current rate. Called with the driver lock held.
+ *
+ */
+typedef bool (*lib_baud_request_cb)(alt_u32 rate, alt_u32 timeout_ms);
+
+/**
+ * @brief handshake with the module at the current rate. Called with the driver lock held.
+ *
+ */
+typedef bool (*lib_baud_verify_cb)(alt_u32 timeout_ms);
+
+/**
+ * @brief negotiation result enum
+ *
+ */
+typedef enum {
+    LIB_BAUD_SUCCESS,
+    LIB_BAUD_FIXED, // port has no divisor register, link stays at its system.h rate
+    LIB_BAUD_ERROR // module stopped answering, caller should reset it
+} lib_baud_result_E;
+
+/**
+ * @brief one negotiated UART link, owned by the driver of the module on the other end
+ *
+ */
+typedef struct {
+    /* UART port */
+    lib_uart_config_S* config;
+    /* rate ladder, rates[0] is the module power on rate */
+    alt_u32 rates[LIB_BAUD_MAX_STAGES];
+    /* number of rates in the ladder */
+    alt_u32 stage_count;
+    /* index of the rate in use */
+    alt_u32 stage;
+    /* highest stage negotiation may climb to, lowered when a rate proves unreliable */
+    alt_u32 ceiling;
+    /* module rate change command */
+    lib_baud_request_cb request;
+    /* module handshake */
+    lib_baud_verify_cb verify;
+    /* timeout for every request and handshake */
+    alt_u32 cmd_timeout_ms;
+    /* line errors tolerated between two checks */
+    alt_u32 error_limit;
+    /* UART error count at the last check */
+    alt_u32 error_mark;
+} lib_baud_link_S;
+
+/* Public API */
+lib_baud_result_E lib_baud_negotiate(lib_baud_link_S* link);
+lib_baud_result_E lib_baud_check(lib_baud_link_S* link);
+void lib_baud_module_reset(lib_baud_link_S* link);
+
+#endif /* LIB_BAUD_H_ */
@@ -24,6 +24,7 @@
 
 /* lib includes */
 #include "lib_uart.h"
+#include "lib_at_matcher.h"
 #include "lib_gps.h"
 
 /* defines */
@@ -36,111 +37,79 @@
 
 /* private types */
 
-typedef enum {
-    RX_RECEIVING,
-    RX_ERROR,
-    RX_DONE
-} lib_gps_rxstate_E;
-
-/* gps module rx buffer used to collect data from uart callback */
-typedef struct {
-    /* rx buffer */
-    volatile alt_u8* rx_buf;
-
-    /* rx buffer current index */
-    alt_u32 idx;
-
-    /* rx buffer size */
-    alt_u32 buffersize;
-
-    /* Current RX state */
-    lib_gps_rxstate_E rx_state;
-
-} lib_gps_rx_buffer_S;
-
 /* state struct */
 typedef struct {
 
     /* UART settings */
     lib_uart_config_S* config;
 
-    /* RX buffer */
-    volatile lib_gps_rx_buffer_S* rxbuf;
-
     /* mutex for handling multiple requests */
     SemaphoreHandle_t mutex;
 
 } lib_gps_state_S;
 
-/* UART driver */
-static void lib_gps_rx_error_callback(void);
-static void lib_gps_rx_callback(alt_u8 rxdata);
-
 
 /* Private data */
 
-/* uart configuration */
+/* uart configuration, responses are collected by lib_uart and read in bulk from task context */
 static lib_uart_config_S gps_config = {
-    .uart_rx_irq = (lib_uart_generic_rx_irq*)lib_gps_rx_callback,
-    .uart_rx_error = (lib_uart_rx_error*)lib_gps_rx_error_callback
+    .name = "gps",
+    .uart_rx_irq = NULL,
+    .uart_rx_error = NULL,
+    .uart_freq = GPS_FREQ,
+    .fixed_baud = GPS_FIXED_BAUD,
+    .baud = GPS_BAUD
 };
 
-/* state configuration, initially no rxbuffer set up */
+/* response matcher, rebuilt for every command and stepped from the UART RX irq */
+static lib_at_matcher_S gps_matcher;
+
+/* state configuration */
 volatile static lib_gps_state_S gps_state = {
     .config = &gps_config,
-    .rxbuf = NULL,
 };
 
 /**
- * @brief UART rx error callback, sets rxbuffer error to notify lib that incoming data chunk is garbage
+ * @brief UART RX irq hook, runs the response matcher over every received byte
  *
+ * @param rxdata received byte
+ * @return true once the command response is complete to wake the waiting task
  */
-static void lib_gps_rx_error_callback(void) {
-    volatile lib_gps_rx_buffer_S* buffer = gps_state.rxbuf;
-    if (buffer == NULL) {
-        return;
-    }
-    /* set rxbuffer error for currently incoming data only if we are expecting a response */
-    if (buffer->rx_state == RX_RECEIVING) {
-        //buffer->rx_state = RX_ERROR;
-    }
+static bool lib_gps_rx_match(alt_u8 rxdata) {
+    return lib_at_matcher_step(&gps_matcher, rxdata);
 }
 
 /**
- * @brief UART rxdata callback, writes new data into rxbuffer if rxbuffer is in a good state,
+ * @brief build the response matcher for a command: OK and ERROR result codes plus the <cmd>: response line or the
+ *        async response string the command waits on
  *
- * @param rxdata incoming UART data
+ * @param cmd command datastructure
  */
-static void lib_gps_rx_callback(alt_u8 rxdata) {
-    volatile lib_gps_rx_buffer_S* buffer = gps_state.rxbuf;
-    if (buffer == NULL) {
-        return;
-    }
-
-    /* set rxbuffer error for currently incoming data only if we are expecting a response */
-    if (buffer->rx_state == RX_RECEIVING) {
-        buffer->rx_buf[buffer->idx] = rxdata;
-        (buffer->idx)++;
-        if (buffer->idx >= buffer->buffersize) {
-            buffer->rx_state = RX_DONE;
-        }
+static void lib_gps_build_matcher(const lib_gps_cmd_type_E* cmd) {
+    lib_at_matcher_init(&gps_matcher);
+    lib_at_matcher_add(&gps_matcher, LIB_GPS_CMD_RESP_OK, sizeof(LIB_GPS_CMD_RESP_OK) - 1, LIB_AT_MATCHER_REQUIRED);
+    lib_at_matcher_add(&gps_matcher, LIB_GPS_CMD_RESP_ERROR, sizeof(LIB_GPS_CMD_RESP_ERROR) - 1, LIB_AT_MATCHER_FINAL);
+    if (cmd->resp_type == LIB_GPS_RESP_TYPE_STRING) {
+        /* response line is in the format <cmd>: <data> */
+        lib_at_matcher_add(&gps_matcher, cmd->resp_prefix, cmd->resp_prefix_len, LIB_AT_MATCHER_REQUIRED);
+    } else if (cmd->resp_type == LIB_GPS_RESP_TYPE_ASYNC) {
+        lib_at_matcher_add(&gps_matcher, cmd->response_str, cmd->resp_len - 1, LIB_AT_MATCHER_REQUIRED);
     }
+    lib_at_matcher_compile(&gps_matcher);
 }
 
 /**
  * @brief Send a command sequence to the gps module
  *
- * @param cmd command sequence to sent
- * @param cmd_len size of command sequence
+ * @param iov command fragments to send
+ * @param count number of command fragments
  * @param cmd_tx_timeout timeout of transmission window in ms
- * @param rxbuf receivebuffer for response data
  * @return lib_gps_result_E
  */
-static lib_gps_result_E lib_gps_send_cmd(alt_u8* cmd, alt_u32 cmd_len, alt_u32 cmd_tx_timeout) {
+static lib_gps_result_E lib_gps_send_cmd(const lib_uart_iovec_S* iov, alt_u32 count, alt_u32 cmd_tx_timeout) {
 
     lib_gps_result_E result = GPS_ERROR;
-    /* set up rx buffer before sending command */
-    if (lib_uart_tx(gps_state.config, cmd, cmd_len, cmd_tx_timeout) == LIB_UART_SUCCESS) {
+    if (lib_uart_txv(gps_state.config, iov, count, cmd_tx_timeout) == LIB_UART_SUCCESS) {
         result = GPS_SUCCESS;
     }
 
@@ -148,42 +117,26 @@ static lib_gps_result_E lib_gps_send_cmd(alt_u8* cmd, alt_u32 cmd_len, alt_u32 c
 }
 
 /**
- * @brief construct command string from command datatypes
+ * @brief describe the AT command string as a list of fragments without copying anything. The request is rendered at
+ *        compile time, so only commands with formatted args need more than one fragment: AT<cmd>=, <args>, \r
  *
  * @param cmd command datastructure
- * @param cmd_data command data string
- * @param cmd_len command size
- * @return lib_gps_result_E
+ * @param preformatted_args formatted args (only used if the command takes formatted args)
+ * @param iov output fragment list, must hold LIB_GPS_CMD_MAX_FRAGMENTS entries
+ * @return alt_u32 number of fragments used
  */
-static lib_gps_result_E lib_gps_construct_cmd_strings(lib_gps_cmd_type_E cmd, alt_u8** cmd_data, alt_u32* cmd_len, alt_u8* preformatted_args) {
+static alt_u32 lib_gps_construct_cmd_iov(const lib_gps_cmd_type_E* cmd, alt_u8* preformatted_args, lib_uart_iovec_S* iov) {
+    alt_u32 count = 0;
 
-    /* first calculate the length of command and response */
-    *cmd_len = (cmd.cmd_len + LIB_GPS_CMD_SIZE_OVERHEAD + cmd.args_len);
-    if (cmd.formatted_args == true) {
-        *cmd_len = *cmd_len + strlen(preformatted_args);
-    }
-    /* generate AT command string */
-    alt_u8* cmd_string = (alt_u8*)pvPortMalloc(*cmd_len);
-    memset(cmd_string, 0, *cmd_len);
-    strcat(cmd_string, LIB_GPS_CMD_HEADER);
-    strcat(cmd_string, cmd.cmd);
-    if (cmd.is_query) {
-        strcat(cmd_string, LIB_GPS_CMD_QUERY);
-    } else if (cmd.formatted_args == true) {
-        strcat(cmd_string, LIB_GPS_CMD_ARGS_ASSIGNMENT);
-        strcat(cmd_string, preformatted_args);
-    }
-    else if (cmd.args_len != 0) {
-        strcat(cmd_string, LIB_GPS_CMD_ARGS_ASSIGNMENT);
-        strcat(cmd_string, cmd.cmd_args);
+    iov[count++] = (lib_uart_iovec_S){cmd->request, cmd->request_len};
+    if ((cmd->formatted_args == true) && (preformatted_args != NULL)) {
+        iov[count++] = (lib_uart_iovec_S){preformatted_args, strlen(preformatted_args)};
+        iov[count++] = (lib_uart_iovec_S){LIB_GPS_CMD_FOOTER, sizeof(LIB_GPS_CMD_FOOTER) - 1};
     }
-    strcat(cmd_string, LIB_GPS_CMD_FOOTER);
 
-    *cmd_data = cmd_string;
-    return GPS_SUCCESS;
+    return count;
 }
 
-
 /**
  * @brief execute AT command and parse reponse
  *
@@ -198,78 +151,61 @@ static lib_gps_result_E lib_gps_execute_cmd(lib_gps_cmd_type_E cmd, alt_u8* pref
     lib_gps_result_E res = GPS_TIMEOUT;
 
     /* make rx buf */
-    alt_u8* rx = (alt_u8*)pvPortMalloc(LIB_gps_RX_BUF_SIZE);
-    memset(rx, 0, LIB_gps_RX_BUF_SIZE);
-    volatile lib_gps_rx_buffer_S new_rx_buf = {
-        .buffersize = LIB_gps_RX_BUF_SIZE,
-        .idx = 0,
-        .rx_buf = rx,
-        .rx_state = RX_RECEIVING
-    };
-
-    gps_state.rxbuf = &new_rx_buf;
-
-    /* generate command data */
-    alt_u8* cmd_data = NULL;
-    alt_u32 cmd_data_len = 0;
-    lib_gps_construct_cmd_strings(cmd, &cmd_data, &cmd_data_len, preformatted_args);
+    alt_u8 rx[LIB_gps_RX_BUF_SIZE] = {0};
+    alt_u32 idx = 0;
+
+    /* anything received before the command was sent does not belong to it */
+    lib_uart_rx_flush(gps_state.config);
+
+    /* the matcher runs on every byte in the RX irq and only wakes us once the response is complete, or the buffer
+     * would overflow */
+    lib_gps_build_matcher(&cmd);
+    gps_state.config->uart_rx_irq = lib_gps_rx_match;
+    lib_uart_rx_listen(gps_state.config, xTaskGetCurrentTaskHandle(), LIB_gps_RX_BUF_SIZE - 1, LIB_UART_RX_NO_TERMINATOR);
+
+    /* describe command data */
+    lib_uart_iovec_S cmd_iov[LIB_GPS_CMD_MAX_FRAGMENTS];
+    alt_u32 cmd_iov_count = lib_gps_construct_cmd_iov(&cmd, preformatted_args, cmd_iov);
 
     do {
 
         /* first send the command */
-        res = lib_gps_send_cmd(cmd_data, strlen(cmd_data), timeout_ms);
+        res = lib_gps_send_cmd(cmd_iov, cmd_iov_count, timeout_ms);
         if (res != GPS_SUCCESS) {
             break;
         }
 
         alt_u32 start_time = xTaskGetTickCount();
+        TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+        TickType_t elapsed;
         res = GPS_TIMEOUT;
-        alt_u8* search_str = (alt_u8*)pvPortMalloc(cmd.cmd_len + 3);
-        memset(search_str, 0, cmd.cmd_len + 3);
-        /* wait for command response */
-        while (((xTaskGetTickCount() - start_time)) <= pdMS_TO_TICKS(timeout_ms)) {
+        while ((elapsed = (xTaskGetTickCount() - start_time)) <= timeout) {
+            lib_uart_rx_wait(gps_state.config, timeout - elapsed);
+
+            /* sample completion before draining, every byte the matcher has seen is already in the ring */
+            bool done = lib_at_matcher_done(&gps_matcher);
+            idx += lib_uart_rx_read(gps_state.config, rx + idx, (LIB_gps_RX_BUF_SIZE - 1) - idx);
+
             /* conditions for AT command success are 1) OK response string, 2) Command response string if applicable,
              * and any response must end in \r\n */
-            if (strstr(new_rx_buf.rx_buf, LIB_GPS_CMD_RESP_OK)) {
-                /* if the response type is a regular string then we look for the regex pattern <cmd>: */
-                if (cmd.resp_type == LIB_GPS_RESP_TYPE_STRING) {
-                    sprintf(search_str, "%s: ", cmd.cmd);
-                    if ((strstr(new_rx_buf.rx_buf, search_str) != NULL) &&
-                        (new_rx_buf.rx_buf[new_rx_buf.idx-1] == '\n') &&
-                        (new_rx_buf.rx_buf[new_rx_buf.idx-2] == '\r')) {
-                            res = GPS_SUCCESS;
-                            break;
-                    }
-                } else if (cmd.resp_type == LIB_GPS_RESP_TYPE_ASYNC) {
-                    if (strstr(new_rx_buf.rx_buf, cmd.response_str) != NULL) {
-                        res = GPS_SUCCESS;
-                        break;
-                    }
-                } else {
-                    res = GPS_SUCCESS;
-                    break;
-                }
-            } else if (strstr(new_rx_buf.rx_buf, LIB_GPS_CMD_RESP_ERROR) != NULL) {
-                res = GPS_ERROR;
+            if (done) {
+                res = lib_at_matcher_complete(&gps_matcher) ? GPS_SUCCESS : GPS_ERROR;
                 break;
-            } else if (new_rx_buf.rx_state == RX_DONE) {
-                res = GPS_ERROR;
-                break;
-            } else if (new_rx_buf.rx_state == RX_ERROR) {
+            } else if (idx >= (LIB_gps_RX_BUF_SIZE - 1)) {
                 res = GPS_ERROR;
                 break;
             }
         }
 
-        vPortFree(search_str);
     } while (0);
 
-    gps_state.rxbuf = NULL;
+    lib_uart_rx_listen(gps_state.config, NULL, LIB_UART_RX_RING_SIZE, LIB_UART_RX_NO_TERMINATOR);
+    gps_state.config->uart_rx_irq = NULL;
 
 #if (LIB_GPS_AT_PRINT_OUTPUT == 1)
-    printf("\nReceived GPS %d:\n", new_rx_buf.idx);
-    for (int i = 0; i < new_rx_buf.idx; i++) {
-        printf("%c", new_rx_buf.rx_buf[i]);
+    printf("\nReceived GPS %d:\n", idx);
+    for (int i = 0; i < idx; i++) {
+        printf("%c", rx[i]);
     }
     printf("\n");
 #endif
@@ -279,9 +215,6 @@ static lib_gps_result_E lib_gps_execute_cmd(lib_gps_cmd_type_E cmd, alt_u8* pref
         memcpy(rxbuf, rx, rxsize);
     }
 
-    vPortFree(rx);
-    vPortFree(cmd_data);
-
     return res;
 }
 
@@ -399,13 +332,11 @@ lib_gps_result_E lib_gps_turn_off_gps(void) {
  */
 lib_gps_result_E lib_gps_read_gps(alt_u8* lat, alt_u8* longi) {
     /* prepare buffers */
-    alt_u8* rxbuf = pvPortMalloc(LIB_GPS_RX_BUF_SIZE_GPS_PAYLOAD);
-    memset(rxbuf, 0, LIB_GPS_RX_BUF_SIZE_GPS_PAYLOAD);
+    alt_u8 rxbuf[LIB_GPS_RX_BUF_SIZE_GPS_PAYLOAD] = {0};
 
     /* execute command - 10s timeout because GPS can take a long time to respond */
     lib_gps_result_E ret = lib_gps_execute_cmd(LIB_GPS_GET_LOCATION_CMD, NULL, rxbuf, LIB_GPS_RX_BUF_SIZE_GPS_PAYLOAD - 1, LIB_GPS_AT_DEFAULT_CMD_TIMEOUT_MS*10);
     if (ret != GPS_SUCCESS) {
-        vPortFree(rxbuf);
         return ret;
     }
 
@@ -433,6 +364,5 @@ lib_gps_result_E lib_gps_read_gps(alt_u8* lat, alt_u8* longi) {
         }
     }
 
-    vPortFree(rxbuf);
     return ret;
 }
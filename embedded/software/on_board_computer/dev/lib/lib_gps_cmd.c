@@ -21,69 +21,59 @@ const char LIB_GPS_CMD_RESP_OK[] = {"\r\nOK\r\n"};
 const char LIB_GPS_CMD_RESP_ERROR[] = {"\r\nERROR\r\n"};
 
 /* Command strings */
-const char LIB_GPS_CMD_RESET_STRING[] = {"+CFUN"};
-const char LIB_GPS_CMD_SIM_STATUS_STRING[] = {"+CPIN"};
-const char LIB_GPS_PWR_STRING[] = {"+CGNSPWR"};
-const char LIB_GPS_DATA_STRING[] = {"+CGNSINF"};
+#define LIB_GPS_CMD_RESET_STRING "+CFUN"
+#define LIB_GPS_CMD_SIM_STATUS_STRING "+CPIN"
+#define LIB_GPS_PWR_STRING "+CGNSPWR"
+#define LIB_GPS_DATA_STRING "+CGNSINF"
 
 /* Command arg strings */
-const char LIB_GPS_RESET_ARGS_STRING[] = {"1,1"};
-const char LIB_GPS_ON_ARGS_STRING[] = {"1"};
-const char LIB_GPS_OFF_ARGS_STRING[] = {"0"};
+#define LIB_GPS_RESET_ARGS_STRING "1,1"
+#define LIB_GPS_ON_ARGS_STRING "1"
+#define LIB_GPS_OFF_ARGS_STRING "0"
 
 /* Command response strings */
 const char LIB_GPS_SIM_STATUS_RESPONSE_STRING[] = {"READY"};
 const char LIB_GPS_DATA_RESPONSE_STRING[] = {": 1,1,%f,%f,%f,%*[^0123456789]"};
 
+/* Command spec - same layout as the LTE table, request bytes and response prefix are rendered at compile time */
+#define LIB_GPS_SPEC(cmd_str, request_str, resp_str, resp_size, type, formatted) { \
+    .cmd = cmd_str, \
+    .cmd_len = sizeof(cmd_str), \
+    .request = request_str, \
+    .request_len = sizeof(request_str) - 1, \
+    .resp_prefix = cmd_str ": ", \
+    .resp_prefix_len = sizeof(cmd_str ": ") - 1, \
+    .response_str = resp_str, \
+    .resp_len = resp_size, \
+    .resp_type = type, \
+    .formatted_args = formatted}
+
+/* AT<cmd>\r */
+#define LIB_GPS_SPEC_EXEC(cmd_str, resp_str, resp_size, type) \
+    LIB_GPS_SPEC(cmd_str, "AT" cmd_str "\r", resp_str, resp_size, type, false)
+/* AT<cmd>?\r */
+#define LIB_GPS_SPEC_QUERY(cmd_str, resp_str, resp_size, type) \
+    LIB_GPS_SPEC(cmd_str, "AT" cmd_str "?\r", resp_str, resp_size, type, false)
+/* AT<cmd>=<args>\r */
+#define LIB_GPS_SPEC_SET(cmd_str, args_str, resp_str, resp_size, type) \
+    LIB_GPS_SPEC(cmd_str, "AT" cmd_str "=" args_str "\r", resp_str, resp_size, type, false)
+
 /* Command definitions */
 
 /* status commands */
-const lib_gps_cmd_type_E LIB_GPS_RESET_CMD = {.cmd = LIB_GPS_CMD_RESET_STRING,
-                                            .cmd_len = sizeof(LIB_GPS_CMD_RESET_STRING),
-                                            .cmd_args = LIB_GPS_RESET_ARGS_STRING,
-                                            .args_len = sizeof(LIB_GPS_RESET_ARGS_STRING),
-                                            .response_str = NULL,
-                                            .resp_len = 0,
-                                            .is_query = false,
-                                            .resp_type = LIB_GPS_RESP_TYPE_BASIC,
-                                            .formatted_args = false};
+const lib_gps_cmd_type_E LIB_GPS_RESET_CMD = LIB_GPS_SPEC_SET(LIB_GPS_CMD_RESET_STRING, LIB_GPS_RESET_ARGS_STRING,
+                                                                                NULL, 0, LIB_GPS_RESP_TYPE_BASIC);
 
-const lib_gps_cmd_type_E LIB_GPS_SIM_STATUS_CMD = {.cmd = LIB_GPS_CMD_SIM_STATUS_STRING,
-                                                .cmd_len = sizeof(LIB_GPS_CMD_SIM_STATUS_STRING),
-                                                .cmd_args = NULL,
-                                                .args_len = 0,
-                                                .response_str = LIB_GPS_SIM_STATUS_RESPONSE_STRING,
-                                                .resp_len = sizeof(LIB_GPS_SIM_STATUS_RESPONSE_STRING),
-                                                .is_query = true,
-                                                .resp_type = LIB_GPS_RESP_TYPE_STRING,
-                                                .formatted_args = false};
+const lib_gps_cmd_type_E LIB_GPS_SIM_STATUS_CMD = LIB_GPS_SPEC_QUERY(LIB_GPS_CMD_SIM_STATUS_STRING,
+                                                        LIB_GPS_SIM_STATUS_RESPONSE_STRING,
+                                                        sizeof(LIB_GPS_SIM_STATUS_RESPONSE_STRING),
+                                                        LIB_GPS_RESP_TYPE_STRING);
 
-const lib_gps_cmd_type_E LIB_GPS_POWER_ON_CMD = {.cmd = LIB_GPS_PWR_STRING,
-                                                    .cmd_len = sizeof(LIB_GPS_PWR_STRING),
-                                                    .cmd_args = LIB_GPS_ON_ARGS_STRING,
-                                                    .args_len = sizeof(LIB_GPS_ON_ARGS_STRING),
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_GPS_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
+const lib_gps_cmd_type_E LIB_GPS_POWER_ON_CMD = LIB_GPS_SPEC_SET(LIB_GPS_PWR_STRING, LIB_GPS_ON_ARGS_STRING,
+                                                                                NULL, 0, LIB_GPS_RESP_TYPE_BASIC);
 
-const lib_gps_cmd_type_E LIB_GPS_POWER_OFF_CMD = {.cmd = LIB_GPS_PWR_STRING,
-                                                    .cmd_len = sizeof(LIB_GPS_PWR_STRING),
-                                                    .cmd_args = LIB_GPS_OFF_ARGS_STRING,
-                                                    .args_len = sizeof(LIB_GPS_OFF_ARGS_STRING),
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_GPS_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
+const lib_gps_cmd_type_E LIB_GPS_POWER_OFF_CMD = LIB_GPS_SPEC_SET(LIB_GPS_PWR_STRING, LIB_GPS_OFF_ARGS_STRING,
+                                                                                NULL, 0, LIB_GPS_RESP_TYPE_BASIC);
 
-const lib_gps_cmd_type_E LIB_GPS_GET_LOCATION_CMD = {.cmd = LIB_GPS_DATA_STRING,
-                                                    .cmd_len = sizeof(LIB_GPS_DATA_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_GPS_RESP_TYPE_STRING,
-                                                    .formatted_args = false};
+const lib_gps_cmd_type_E LIB_GPS_GET_LOCATION_CMD = LIB_GPS_SPEC_EXEC(LIB_GPS_DATA_STRING, NULL, 0,
+                                                                                        LIB_GPS_RESP_TYPE_STRING);
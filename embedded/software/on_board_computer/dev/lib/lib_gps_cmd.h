@@ -18,6 +18,7 @@
 #define LIB_GPS_CMD_SIZE_OVERHEAD 5 // formatting -> AT<cmd>=<args>\r\0
 #define LIB_GPS_BASIC_RESPONSE_SIZE_OVERHEAD 10 // formatting -> \r\n<cmd>\r\n\r\nOK\r\n\0
 #define LIB_GPS_EXTENDED_RESPONSE_PADING 6 // formatting -> \r\n<response>\r\n
+#define LIB_GPS_CMD_MAX_FRAGMENTS 3 // AT<cmd>=, <args>, \r
 
 /* public types */
 
@@ -28,35 +29,31 @@ typedef enum {
     LIB_GPS_RESP_TYPE_ASYNC // response data has completely seperate async response regex
 } lib_gps_resp_type_E;
 
-/* generic AT command type */
+/* generic AT command type, built with the spec macros in lib_gps_cmd.c */
 typedef struct {
     const char* cmd; /* command string */
     alt_u32 cmd_len;
-    const char* cmd_args; /* command arguments */
-    alt_u32 args_len;
+    const char* request; /* whole request AT<cmd>[?|=<args>]\r rendered at compile time, or AT<cmd>= for formatted args */
+    alt_u32 request_len; /* without the null terminator */
+    const char* resp_prefix; /* <cmd>: response line prefix rendered at compile time */
+    alt_u32 resp_prefix_len; /* without the null terminator */
     const char* response_str; /* response regex */
     alt_u32 resp_len;
-    bool is_query; /* is this a query AT command? Uses the '?' syntax */
     lib_gps_resp_type_E resp_type; /* basic or data response type -> Supports async responses */
-    bool formatted_args; /* should we use formatted args instead of the static provided args */
+    bool formatted_args; /* args are formatted by the caller and sent between the request and the footer */
 } lib_gps_cmd_type_E;
 
 /* Command components */
 extern const char LIB_GPS_CMD_HEADER[];
-extern const char LIB_GPS_CMD_FOOTER[];
+extern const char LIB_GPS_CMD_FOOTER[2];
 extern const char LIB_GPS_CMD_PADDING[];
 extern const char LIB_GPS_CMD_QUERY[];
 extern const char LIB_GPS_CMD_ARGS_ASSIGNMENT[];
-extern const char LIB_GPS_CMD_RESP_OK[];
-extern const char LIB_GPS_CMD_RESP_ERROR[];
+extern const char LIB_GPS_CMD_RESP_OK[7];
+extern const char LIB_GPS_CMD_RESP_ERROR[10];
 
-/* Command strings */
-extern const char LIB_GPS_CMD_RESET_STRING[];
-extern const char LIB_GPS_CMD_SIM_STATUS_STRING[];
-extern const char LIB_GPS_PWR_STRING[];
-extern const char LIB_GPS_DATA_STRING[];
-extern const char LIB_GPS_ON_ARGS_STRING[];
-extern const char LIB_GPS_OFF_ARGS_STRING[];
+/* Command response strings */
+extern const char LIB_GPS_SIM_STATUS_RESPONSE_STRING[];
 extern const char LIB_GPS_DATA_RESPONSE_STRING[];
 
 /* status commands */
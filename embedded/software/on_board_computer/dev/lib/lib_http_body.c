@@ -0,0 +1,294 @@
+/**
+ * @file lib_http_body.c
+ * @author Emery Nagy
+ * @brief Build a whole HTTP request body locally so it can go to the modem in one transfer
+ * @version 0.1
+ * @date 2023-04-14
+ *
+ */
+
+/* stdlib includes */
+#include "string.h"
+
+/* lib includes */
+#include "lib_http_body.h"
+
+
+/* Private data */
+static const char lib_http_body_hex[] = {"0123456789ABCDEF"};
+
+
+/* Private API */
+
+/**
+ * @brief bytes held back for the closing of the body
+ *
+ * @param body body being built
+ * @return alt_u32 reserved bytes
+ */
+static alt_u32 lib_http_body_reserved(const lib_http_body_S* body) {
+    return ((body->type == LIB_HTTP_BODY_JSON) && !body->finished) ? 1 : 0;
+}
+
+/**
+ * @brief copy bytes into the body as they are
+ *
+ * @param body body being built
+ * @param data bytes to copy
+ * @param len number of bytes
+ * @return true if they fit
+ */
+static bool lib_http_body_put(lib_http_body_S* body, const void* data, alt_u32 len) {
+    if ((body->len + len + lib_http_body_reserved(body)) > body->size) {
+        return false;
+    }
+    memcpy(body->buf + body->len, data, len);
+    body->len += len;
+    return true;
+}
+
+/**
+ * @brief copy a key or value into the body, escaped for the body type
+ *
+ * @param body body being built
+ * @param data text to copy
+ * @param len number of bytes
+ * @return true if it fit
+ */
+static bool lib_http_body_put_escaped(lib_http_body_S* body, const alt_u8* data, alt_u32 len) {
+    alt_u32 limit = body->size - lib_http_body_reserved(body);
+    alt_u32 idx = body->len;
+
+    for (alt_u32 i = 0; i < len; i++) {
+        alt_u8 c = data[i];
+        bool plain;
+        if (body->type == LIB_HTTP_BODY_FORM) {
+            /* only unreserved characters go as they are, base64 '+', '/' and '=' all need escaping */
+            plain = ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9')) ||
+                                                            (c == '-') || (c == '_') || (c == '.') || (c == '~');
+        } else {
+            plain = (c >= 0x20) && (c != '"') && (c != '\\');
+        }
+
+        if (plain) {
+            if (idx + 1 > limit) {
+                return false;
+            }
+            body->buf[idx++] = c;
+        } else if (body->type == LIB_HTTP_BODY_FORM) {
+            if (idx + 3 > limit) {
+                return false;
+            }
+            body->buf[idx++] = '%';
+            body->buf[idx++] = lib_http_body_hex[c >> 4];
+            body->buf[idx++] = lib_http_body_hex[c & 0xF];
+        } else if (c >= 0x20) {
+            if (idx + 2 > limit) {
+                return false;
+            }
+            body->buf[idx++] = '\\';
+            body->buf[idx++] = c;
+        } else {
+            if (idx + 6 > limit) {
+                return false;
+            }
+            memcpy(body->buf + idx, "\\u00", 4);
+            idx += 4;
+            body->buf[idx++] = lib_http_body_hex[c >> 4];
+            body->buf[idx++] = lib_http_body_hex[c & 0xF];
+        }
+    }
+
+    body->len = idx;
+    return true;
+}
+
+/**
+ * @brief start a field, separator from the previous one, the key and whatever opens the value
+ *
+ * @param body body being built
+ * @param key field name
+ * @return true if it fit
+ */
+static bool lib_http_body_put_key(lib_http_body_S* body, const char* key) {
+    bool ok;
+
+    if (body->type == LIB_HTTP_BODY_FORM) {
+        ok = ((body->fields == 0) || lib_http_body_put(body, "&", 1)) &&
+                lib_http_body_put_escaped(body, (const alt_u8*)key, strlen(key)) &&
+                lib_http_body_put(body, "=", 1);
+    } else {
+        ok = ((body->fields == 0) || lib_http_body_put(body, ",", 1)) &&
+                lib_http_body_put(body, "\"", 1) &&
+                lib_http_body_put_escaped(body, (const alt_u8*)key, strlen(key)) &&
+                lib_http_body_put(body, "\":\"", 3);
+    }
+
+    return ok;
+}
+
+/**
+ * @brief close a field value
+ *
+ * @param body body being built
+ * @return true if it fit
+ */
+static bool lib_http_body_put_value_end(lib_http_body_S* body) {
+    return (body->type == LIB_HTTP_BODY_FORM) || lib_http_body_put(body, "\"", 1);
+}
+
+/**
+ * @brief base64 sink writing into the body
+ *
+ * @param data encoded text
+ * @param len number of characters
+ * @param sink_ctx body being built
+ * @return true if the text fit
+ */
+static bool lib_http_body_sink(const alt_u8* data, alt_u32 len, void* sink_ctx) {
+    return lib_http_body_put_escaped((lib_http_body_S*)sink_ctx, data, len);
+}
+
+
+/* Public API */
+
+/**
+ * @brief start an empty body in caller supplied storage
+ *
+ * @param body body to initialize
+ * @param buf body storage, the body is sent straight from here
+ * @param size storage size, at most the BODYLEN the http connection was set up with
+ * @param type body encoding
+ * @param content_type Content-Type header value, NULL for the default of the encoding
+ */
+void lib_http_body_init(lib_http_body_S* body, alt_u8* buf, alt_u32 size, lib_http_body_type_E type, const char* content_type) {
+    body->buf = buf;
+    body->size = size;
+    body->type = type;
+    body->content_type = content_type;
+    if (content_type == NULL) {
+        body->content_type = (type == LIB_HTTP_BODY_FORM) ? LIB_HTTP_BODY_FORM_TYPE :
+                                (type == LIB_HTTP_BODY_JSON) ? LIB_HTTP_BODY_JSON_TYPE : LIB_HTTP_BODY_RAW_TYPE;
+    }
+    lib_http_body_reset(body);
+}
+
+/**
+ * @brief empty the body to build the next one in the same storage
+ *
+ * @param body body to reset
+ */
+void lib_http_body_reset(lib_http_body_S* body) {
+    body->len = 0;
+    body->fields = 0;
+    body->finished = false;
+    if (body->type == LIB_HTTP_BODY_JSON) {
+        lib_http_body_put(body, "{", 1);
+    }
+}
+
+/**
+ * @brief add a text field, escaped for the body encoding
+ *
+ * @param body body being built
+ * @param key field name
+ * @param value field value
+ * @param len value length
+ * @return lib_http_body_result_E LIB_HTTP_BODY_FULL if the field does not fit, nothing is added
+ */
+lib_http_body_result_E lib_http_body_add_field(lib_http_body_S* body, const char* key, const char* value, alt_u32 len) {
+    if ((body->type == LIB_HTTP_BODY_RAW) || body->finished) {
+        return LIB_HTTP_BODY_ERROR;
+    }
+
+    alt_u32 mark = body->len;
+    if (!lib_http_body_put_key(body, key) || !lib_http_body_put_escaped(body, (const alt_u8*)value, len) ||
+                                                                            !lib_http_body_put_value_end(body)) {
+        body->len = mark;
+        return LIB_HTTP_BODY_FULL;
+    }
+
+    body->fields++;
+    return LIB_HTTP_BODY_SUCCESS;
+}
+
+/**
+ * @brief add a field with a base64 value, raw data is encoded straight into the body. The encoder carries partial
+ *        groups from one field to the next, so data can be split anywhere and only the last field is padded. It only
+ *        moves on once the field fit, a field that did not can be added again to the next body.
+ *
+ * @param body body being built
+ * @param key field name
+ * @param encoder encoder shared by every field of the value, its sink is supplied here
+ * @param data raw data to encode
+ * @param len number of raw bytes
+ * @param last true to pad and end the encoding with this field
+ * @return lib_http_body_result_E LIB_HTTP_BODY_FULL if the field does not fit, nothing is added
+ */
+lib_http_body_result_E lib_http_body_add_field_base64(lib_http_body_S* body, const char* key, lib_base64_ctx_S* encoder,
+                                                                        const alt_u8* data, alt_u32 len, bool last) {
+    if ((body->type == LIB_HTTP_BODY_RAW) || body->finished) {
+        return LIB_HTTP_BODY_ERROR;
+    }
+
+    /* encode with a working copy so a field that does not fit leaves the caller's encoder alone */
+    lib_base64_ctx_S working = *encoder;
+    working.sink = lib_http_body_sink;
+    working.sink_ctx = body;
+
+    alt_u32 mark = body->len;
+    if (!lib_http_body_put_key(body, key) || !lib_base64_update(&working, data, len) ||
+                        (last && !lib_base64_final(&working)) || !lib_http_body_put_value_end(body)) {
+        body->len = mark;
+        return LIB_HTTP_BODY_FULL;
+    }
+
+    working.sink = encoder->sink;
+    working.sink_ctx = encoder->sink_ctx;
+    *encoder = working;
+    body->fields++;
+    return LIB_HTTP_BODY_SUCCESS;
+}
+
+/**
+ * @brief append bytes to a raw body as they are
+ *
+ * @param body body being built
+ * @param data bytes to append
+ * @param len number of bytes
+ * @return lib_http_body_result_E LIB_HTTP_BODY_FULL if the bytes do not fit, nothing is added
+ */
+lib_http_body_result_E lib_http_body_append(lib_http_body_S* body, const void* data, alt_u32 len) {
+    if ((body->type != LIB_HTTP_BODY_RAW) || body->finished) {
+        return LIB_HTTP_BODY_ERROR;
+    }
+    return lib_http_body_put(body, data, len) ? LIB_HTTP_BODY_SUCCESS : LIB_HTTP_BODY_FULL;
+}
+
+/**
+ * @brief bytes still free, before escaping and field overhead
+ *
+ * @param body body being built
+ * @return alt_u32 free bytes
+ */
+alt_u32 lib_http_body_space(const lib_http_body_S* body) {
+    return body->size - body->len - lib_http_body_reserved(body);
+}
+
+/**
+ * @brief close the body, nothing more can be added until it is reset. Safe to call again, ie when a transfer is
+ *        retried.
+ *
+ * @param body body being built
+ * @return alt_u32 finished body length
+ */
+alt_u32 lib_http_body_finish(lib_http_body_S* body) {
+    if (!body->finished) {
+        /* the closing brace always has room, it is reserved from the start */
+        if (body->type == LIB_HTTP_BODY_JSON) {
+            body->buf[body->len++] = '}';
+        }
+        body->finished = true;
+    }
+    return body->len;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file lib_http_body.h
+ * @author Emery Nagy
+ * @brief Build a whole HTTP request body locally so it can go to the modem in one transfer
+ * @version 0.1
+ * @date 2023-04-14
+ *
+ */
+
+#ifndef LIB_HTTP_BODY_H_
+#define LIB_HTTP_BODY_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* stdlib includes */
+#include "stdbool.h"
+
+/* lib includes */
+#include "lib_base64.h"
+
+/* Public defines */
+#define LIB_HTTP_BODY_FORM_TYPE "application/x-www-form-urlencoded"
+#define LIB_HTTP_BODY_JSON_TYPE "application/json"
+#define LIB_HTTP_BODY_RAW_TYPE "application/octet-stream"
+
+/* Public types */
+
+/**
+ * @brief body encoding, decides how fields are joined and escaped
+ *
+ */
+typedef enum {
+    LIB_HTTP_BODY_FORM, // key=value&key=value, values are percent encoded
+    LIB_HTTP_BODY_JSON, // {"key":"value","key":"value"}, values are JSON string escaped
+    LIB_HTTP_BODY_RAW // bytes appended as they are, no fields
+} lib_http_body_type_E;
+
+/**
+ * @brief body builder result enum
+ *
+ */
+typedef enum {
+    LIB_HTTP_BODY_SUCCESS,
+    LIB_HTTP_BODY_FULL, // the addition did not fit, the body is left as it was
+    LIB_HTTP_BODY_ERROR // the addition does not fit this type of body or the body is already finished
+} lib_http_body_result_E;
+
+/**
+ * @brief request body being built in a caller supplied buffer
+ *
+ */
+typedef struct {
+    /* body storage */
+    alt_u8* buf;
+    /* storage size */
+    alt_u32 size;
+    /* bytes used */
+    alt_u32 len;
+    /* encoding */
+    lib_http_body_type_E type;
+    /* Content-Type header value */
+    const char* content_type;
+    /* fields added so far */
+    alt_u32 fields;
+    /* closing bytes have been written, nothing more can be added */
+    bool finished;
+} lib_http_body_S;
+
+/* Public API */
+void lib_http_body_init(lib_http_body_S* body, alt_u8* buf, alt_u32 size, lib_http_body_type_E type, const char* content_type);
+void lib_http_body_reset(lib_http_body_S* body);
+lib_http_body_result_E lib_http_body_add_field(lib_http_body_S* body, const char* key, const char* value, alt_u32 len);
+lib_http_body_result_E lib_http_body_add_field_base64(lib_http_body_S* body, const char* key, lib_base64_ctx_S* encoder,
+                                                                        const alt_u8* data, alt_u32 len, bool last);
+lib_http_body_result_E lib_http_body_append(lib_http_body_S* body, const void* data, alt_u32 len);
+alt_u32 lib_http_body_space(const lib_http_body_S* body);
+alt_u32 lib_http_body_finish(lib_http_body_S* body);
+
+#endif /* LIB_HTTP_BODY_H_ */
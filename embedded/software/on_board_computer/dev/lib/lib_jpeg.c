@@ -0,0 +1,685 @@
+/**
+ * @file lib_jpeg.c
+ * @author Emery Nagy
+ * @brief Lightweight JPEG inspection for picking the best frame out of a burst and checking frames as they stream in
+ * @version 0.1
+ * @date 2023-03-10
+ *
+ */
+
+/* stdlib includes */
+#include "stdbool.h"
+#include "string.h"
+
+/* lib includes */
+#include "lib_jpeg.h"
+
+/* Private defines */
+#define LIB_JPEG_MARKER 0xFF
+#define LIB_JPEG_SOI 0xD8
+#define LIB_JPEG_EOI 0xD9
+#define LIB_JPEG_SOF0 0xC0 // baseline
+#define LIB_JPEG_SOF1 0xC1 // extended sequential, same entropy coding as baseline
+#define LIB_JPEG_DHT 0xC4
+#define LIB_JPEG_DQT 0xDB
+#define LIB_JPEG_DRI 0xDD
+#define LIB_JPEG_SOS 0xDA
+#define LIB_JPEG_RST0 0xD0
+#define LIB_JPEG_RST7 0xD7
+#define LIB_JPEG_TEM 0x01 // standalone, no length
+#define LIB_JPEG_STUFFED 0x00 // 0xFF data byte inside entropy coded data
+#define LIB_JPEG_APP0 0xE0
+#define LIB_JPEG_APP15 0xEF
+#define LIB_JPEG_COM 0xFE
+#define LIB_JPEG_MAX_COMPONENTS 3
+#define LIB_JPEG_MAX_TABLES 2 // baseline allows 2 huffman tables per class, quant tables are kept to match
+#define LIB_JPEG_BLOCK_SIZE 64
+#define LIB_JPEG_MAX_CODE_LEN 16
+
+/* Private types */
+
+/**
+ * @brief streaming parser position
+ *
+ */
+typedef enum {
+    LIB_JPEG_STATE_SOI_MARKER,
+    LIB_JPEG_STATE_SOI_CODE,
+    LIB_JPEG_STATE_MARKER, // between segments, expecting 0xFF
+    LIB_JPEG_STATE_CODE, // marker code after 0xFF
+    LIB_JPEG_STATE_LENGTH_HI,
+    LIB_JPEG_STATE_LENGTH_LO,
+    LIB_JPEG_STATE_BODY,
+    LIB_JPEG_STATE_ENTROPY,
+    LIB_JPEG_STATE_ENTROPY_MARKER // 0xFF inside entropy coded data
+} lib_jpeg_state_E;
+
+/**
+ * @brief canonical huffman table, decoded one bit at a time
+ *
+ */
+typedef struct {
+    alt_u8 values[256];
+    alt_32 mincode[LIB_JPEG_MAX_CODE_LEN + 1];
+    alt_32 maxcode[LIB_JPEG_MAX_CODE_LEN + 1];
+    alt_u16 valptr[LIB_JPEG_MAX_CODE_LEN + 1];
+    bool present;
+} lib_jpeg_huff_S;
+
+/**
+ * @brief frame component from SOF and SOS
+ *
+ */
+typedef struct {
+    alt_u8 id;
+    alt_u8 h;
+    alt_u8 v;
+    alt_u8 tq;
+    alt_u8 td;
+    alt_u8 ta;
+    alt_32 pred;
+} lib_jpeg_component_S;
+
+/**
+ * @brief entropy coded segment bit reader
+ *
+ */
+typedef struct {
+    const alt_u8* data;
+    alt_u32 pos;
+    alt_u32 len;
+    alt_u32 bits;
+    alt_u32 count;
+} lib_jpeg_bits_S;
+
+/* Private data, the tables are too big for the camera task stack so scoring is not reentrant */
+static lib_jpeg_huff_S lib_jpeg_dc_tables[LIB_JPEG_MAX_TABLES];
+static lib_jpeg_huff_S lib_jpeg_ac_tables[LIB_JPEG_MAX_TABLES];
+static alt_u16 lib_jpeg_quant[LIB_JPEG_MAX_TABLES][LIB_JPEG_BLOCK_SIZE];
+static lib_jpeg_component_S lib_jpeg_components[LIB_JPEG_MAX_COMPONENTS];
+
+
+/* Private API */
+
+/**
+ * @brief read a big endian 16 bit value
+ *
+ * @param p data
+ * @return alt_u32
+ */
+static alt_u32 lib_jpeg_be16(const alt_u8* p) {
+    return ((alt_u32)p[0] << 8) | p[1];
+}
+
+/**
+ * @brief build the decode limits of a huffman table from its DHT code length counts
+ *
+ * @param table table to build, values must already be filled in
+ * @param counts number of codes of each length 1-16
+ */
+static void lib_jpeg_build_huff(lib_jpeg_huff_S* table, const alt_u8* counts) {
+    alt_32 code = 0;
+    alt_u16 k = 0;
+
+    for (alt_u32 l = 1; l <= LIB_JPEG_MAX_CODE_LEN; l++) {
+        table->valptr[l] = k;
+        table->mincode[l] = code;
+        code += counts[l - 1];
+        k += counts[l - 1];
+        table->maxcode[l] = (counts[l - 1] != 0) ? (code - 1) : -1;
+        code <<= 1;
+    }
+    table->present = true;
+}
+
+/**
+ * @brief pull one bit out of the entropy coded segment, stuffed 0xFF00 bytes are unstuffed
+ *
+ * @param br bit reader
+ * @return alt_32 bit, -1 on a marker or the end of the data
+ */
+static alt_32 lib_jpeg_get_bit(lib_jpeg_bits_S* br) {
+    if (br->count == 0) {
+        if (br->pos >= br->len) {
+            return -1;
+        }
+        alt_u8 byte = br->data[br->pos];
+        if (byte == LIB_JPEG_MARKER) {
+            /* anything but a stuffed zero is a marker, the caller deals with those */
+            if ((br->pos + 1 >= br->len) || (br->data[br->pos + 1] != 0)) {
+                return -1;
+            }
+            br->pos++;
+        }
+        br->pos++;
+        br->bits = byte;
+        br->count = 8;
+    }
+
+    br->count--;
+    return (br->bits >> br->count) & 1;
+}
+
+/**
+ * @brief read a coefficient magnitude and sign extend it
+ *
+ * @param br bit reader
+ * @param s magnitude category
+ * @param value output coefficient
+ * @return true on success
+ */
+static bool lib_jpeg_receive_extend(lib_jpeg_bits_S* br, alt_u32 s, alt_32* value) {
+    alt_32 v = 0;
+
+    for (alt_u32 i = 0; i < s; i++) {
+        alt_32 bit = lib_jpeg_get_bit(br);
+        if (bit < 0) {
+            return false;
+        }
+        v = (v << 1) | bit;
+    }
+    if ((s > 0) && (v < (1 << (s - 1)))) {
+        v -= (1 << s) - 1;
+    }
+    *value = v;
+    return true;
+}
+
+/**
+ * @brief decode one huffman symbol
+ *
+ * @param br bit reader
+ * @param table table to decode with
+ * @return alt_32 symbol, -1 on error
+ */
+static alt_32 lib_jpeg_decode(lib_jpeg_bits_S* br, const lib_jpeg_huff_S* table) {
+    alt_32 code = 0;
+
+    for (alt_u32 l = 1; l <= LIB_JPEG_MAX_CODE_LEN; l++) {
+        alt_32 bit = lib_jpeg_get_bit(br);
+        if (bit < 0) {
+            return -1;
+        }
+        code = (code << 1) | bit;
+        if (code <= table->maxcode[l]) {
+            return table->values[table->valptr[l] + code - table->mincode[l]];
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief walk one 8x8 block, only the DC value and the number of nonzero AC coefficients are kept
+ *
+ * @param br bit reader
+ * @param comp component the block belongs to
+ * @param diff output DC difference to the previous block
+ * @param ac_count incremented for every nonzero AC coefficient
+ * @return true on success
+ */
+static bool lib_jpeg_walk_block(lib_jpeg_bits_S* br, lib_jpeg_component_S* comp, alt_32* diff, alt_u32* ac_count) {
+    alt_32 s = lib_jpeg_decode(br, &lib_jpeg_dc_tables[comp->td]);
+    if ((s < 0) || (s > 11) || !lib_jpeg_receive_extend(br, s, diff)) {
+        return false;
+    }
+    comp->pred += *diff;
+
+    alt_u32 k = 1;
+    while (k < LIB_JPEG_BLOCK_SIZE) {
+        alt_32 rs = lib_jpeg_decode(br, &lib_jpeg_ac_tables[comp->ta]);
+        if (rs < 0) {
+            return false;
+        }
+        alt_u32 r = rs >> 4;
+        s = rs & 0x0F;
+        if (s == 0) {
+            if (r != 15) {
+                break; // end of block
+            }
+            k += 16;
+            continue;
+        }
+        k += r;
+        alt_32 coef;
+        if ((k >= LIB_JPEG_BLOCK_SIZE) || !lib_jpeg_receive_extend(br, s, &coef)) {
+            return false;
+        }
+        (*ac_count)++;
+        k++;
+    }
+
+    return k <= LIB_JPEG_BLOCK_SIZE;
+}
+
+/**
+ * @brief skip a restart marker and reset the decoder state
+ *
+ * @param br bit reader
+ * @param ncomp number of components
+ * @return true if a restart marker was found
+ */
+static bool lib_jpeg_restart(lib_jpeg_bits_S* br, alt_u32 ncomp) {
+    br->count = 0;
+    if ((br->pos + 1 >= br->len) || (br->data[br->pos] != LIB_JPEG_MARKER) ||
+        (br->data[br->pos + 1] < LIB_JPEG_RST0) || (br->data[br->pos + 1] > LIB_JPEG_RST7)) {
+        return false;
+    }
+    br->pos += 2;
+    for (alt_u32 c = 0; c < ncomp; c++) {
+        lib_jpeg_components[c].pred = 0;
+    }
+    return true;
+}
+
+
+/* Public API */
+
+/**
+ * @brief score a frame by walking its entropy coded data without doing any IDCT. Sharpness is the number of nonzero
+ *        luma AC coefficients per block weighted by the quantizer step, exposure is the average luma DC level. Only
+ *        baseline/extended sequential huffman frames are walked, everything else only gets its size filled in.
+ *
+ * @param data JPEG data starting at SOI
+ * @param len JPEG size in bytes
+ * @param score output estimate
+ * @return lib_jpeg_result_E
+ */
+lib_jpeg_result_E lib_jpeg_score(const alt_u8* data, alt_u32 len, lib_jpeg_score_S* score) {
+    lib_jpeg_result_E res = LIB_JPEG_ERROR;
+
+    memset(score, 0, sizeof(lib_jpeg_score_S));
+    score->size = len;
+    memset(lib_jpeg_dc_tables, 0, sizeof(lib_jpeg_dc_tables));
+    memset(lib_jpeg_ac_tables, 0, sizeof(lib_jpeg_ac_tables));
+
+    do {
+        if ((len < 4) || (data[0] != LIB_JPEG_MARKER) || (data[1] != LIB_JPEG_SOI)) {
+            break;
+        }
+
+        alt_u32 width = 0;
+        alt_u32 height = 0;
+        alt_u32 ncomp = 0;
+        alt_u32 restart_interval = 0;
+        alt_u32 scan = 0;
+        bool ok = true;
+
+        /* walk the marker segments up to the start of scan */
+        alt_u32 pos = 2;
+        while (ok && (scan == 0)) {
+            while ((pos < len) && (data[pos] == LIB_JPEG_MARKER)) {
+                pos++; // fill bytes
+            }
+            if ((pos + 2 >= len) || (data[pos - 1] != LIB_JPEG_MARKER)) {
+                ok = false;
+                break;
+            }
+            alt_u8 marker = data[pos];
+            alt_u32 seg_len = lib_jpeg_be16(&data[pos + 1]);
+            const alt_u8* seg = &data[pos + 3];
+            alt_u32 seg_end = pos + 1 + seg_len;
+            if ((seg_len < 2) || (seg_end > len)) {
+                ok = false;
+                break;
+            }
+
+            switch (marker) {
+                case LIB_JPEG_DQT:
+                {
+                    alt_u32 i = 0;
+                    while (ok && (i < seg_len - 2)) {
+                        alt_u8 pq = seg[i] >> 4;
+                        alt_u8 tq = seg[i] & 0x0F;
+                        alt_u32 entry = pq ? 2 : 1;
+                        if ((tq >= LIB_JPEG_MAX_TABLES) || (i + 1 + (LIB_JPEG_BLOCK_SIZE * entry) > seg_len - 2)) {
+                            ok = false;
+                            break;
+                        }
+                        for (alt_u32 k = 0; k < LIB_JPEG_BLOCK_SIZE; k++) {
+                            lib_jpeg_quant[tq][k] = pq ? lib_jpeg_be16(&seg[i + 1 + (2 * k)]) : seg[i + 1 + k];
+                        }
+                        i += 1 + (LIB_JPEG_BLOCK_SIZE * entry);
+                    }
+                    break;
+                }
+                case LIB_JPEG_DHT:
+                {
+                    alt_u32 i = 0;
+                    while (ok && (i < seg_len - 2)) {
+                        alt_u8 tc = seg[i] >> 4;
+                        alt_u8 th = seg[i] & 0x0F;
+                        alt_u32 total = 0;
+                        if ((tc > 1) || (th >= LIB_JPEG_MAX_TABLES) || (i + 17 > seg_len - 2)) {
+                            ok = false;
+                            break;
+                        }
+                        for (alt_u32 k = 0; k < LIB_JPEG_MAX_CODE_LEN; k++) {
+                            total += seg[i + 1 + k];
+                        }
+                        if ((total > 256) || (i + 17 + total > seg_len - 2)) {
+                            ok = false;
+                            break;
+                        }
+                        lib_jpeg_huff_S* table = tc ? &lib_jpeg_ac_tables[th] : &lib_jpeg_dc_tables[th];
+                        memcpy(table->values, &seg[i + 17], total);
+                        lib_jpeg_build_huff(table, &seg[i + 1]);
+                        i += 17 + total;
+                    }
+                    break;
+                }
+                case LIB_JPEG_SOF0:
+                case LIB_JPEG_SOF1:
+                {
+                    /* precision, height, width and the component count come before the components */
+                    if (seg_len < 8) {
+                        ok = false;
+                        break;
+                    }
+                    ncomp = seg[5];
+                    if ((seg_len < 8 + (3 * ncomp)) || (ncomp == 0) || (ncomp > LIB_JPEG_MAX_COMPONENTS)) {
+                        ok = false;
+                        break;
+                    }
+                    height = lib_jpeg_be16(&seg[1]);
+                    width = lib_jpeg_be16(&seg[3]);
+                    for (alt_u32 c = 0; c < ncomp; c++) {
+                        lib_jpeg_components[c].id = seg[6 + (3 * c)];
+                        lib_jpeg_components[c].h = seg[7 + (3 * c)] >> 4;
+                        lib_jpeg_components[c].v = seg[7 + (3 * c)] & 0x0F;
+                        lib_jpeg_components[c].tq = seg[8 + (3 * c)];
+                        lib_jpeg_components[c].pred = 0;
+                        if ((lib_jpeg_components[c].h == 0) || (lib_jpeg_components[c].v == 0) ||
+                            (lib_jpeg_components[c].tq >= LIB_JPEG_MAX_TABLES)) {
+                            ok = false;
+                        }
+                    }
+                    break;
+                }
+                case LIB_JPEG_DRI:
+                {
+                    if (seg_len < 4) {
+                        ok = false;
+                        break;
+                    }
+                    restart_interval = lib_jpeg_be16(seg);
+                    break;
+                }
+                case LIB_JPEG_SOS:
+                {
+                    /* only interleaved scans of every component are walked */
+                    if ((ncomp == 0) || (seg_len < 3) || (seg[0] != ncomp) || (seg_len < 6 + (2 * ncomp))) {
+                        ok = false;
+                        break;
+                    }
+                    for (alt_u32 c = 0; c < ncomp; c++) {
+                        if (seg[1 + (2 * c)] != lib_jpeg_components[c].id) {
+                            ok = false;
+                            break;
+                        }
+                        lib_jpeg_components[c].td = seg[2 + (2 * c)] >> 4;
+                        lib_jpeg_components[c].ta = seg[2 + (2 * c)] & 0x0F;
+                        if ((lib_jpeg_components[c].td >= LIB_JPEG_MAX_TABLES) ||
+                            (lib_jpeg_components[c].ta >= LIB_JPEG_MAX_TABLES) ||
+                            !lib_jpeg_dc_tables[lib_jpeg_components[c].td].present ||
+                            !lib_jpeg_ac_tables[lib_jpeg_components[c].ta].present) {
+                            ok = false;
+                            break;
+                        }
+                    }
+                    scan = seg_end;
+                    break;
+                }
+                case LIB_JPEG_EOI:
+                {
+                    ok = false;
+                    break;
+                }
+                default:
+                {
+                    /* progressive, arithmetic and lossless frames are not walked, APPn/COM are skipped */
+                    if ((marker >= 0xC2) && (marker <= 0xCF) && (marker != LIB_JPEG_DHT) && (marker != 0xC8) &&
+                                                                                                (marker != 0xCC)) {
+                        ok = false;
+                    }
+                    break;
+                }
+            }
+            pos = seg_end;
+        }
+        if (!ok || (width == 0) || (height == 0)) {
+            break;
+        }
+
+        /* MCU geometry, a single component scan is always one block per MCU */
+        alt_u32 hmax = 1;
+        alt_u32 vmax = 1;
+        if (ncomp > 1) {
+            for (alt_u32 c = 0; c < ncomp; c++) {
+                hmax = (lib_jpeg_components[c].h > hmax) ? lib_jpeg_components[c].h : hmax;
+                vmax = (lib_jpeg_components[c].v > vmax) ? lib_jpeg_components[c].v : vmax;
+            }
+        } else {
+            lib_jpeg_components[0].h = 1;
+            lib_jpeg_components[0].v = 1;
+        }
+        alt_u32 mcus = ((width + (8 * hmax) - 1) / (8 * hmax)) * ((height + (8 * vmax) - 1) / (8 * vmax));
+
+        lib_jpeg_bits_S br = {.data = data, .pos = scan, .len = len, .bits = 0, .count = 0};
+        alt_u32 luma_blocks = 0;
+        alt_32 dc_sum = 0;
+        alt_u32 ac_count = 0;
+        for (alt_u32 m = 0; ok && (m < mcus); m++) {
+            if ((restart_interval != 0) && (m != 0) && ((m % restart_interval) == 0)) {
+                ok = lib_jpeg_restart(&br, ncomp);
+            }
+            for (alt_u32 c = 0; ok && (c < ncomp); c++) {
+                lib_jpeg_component_S* comp = &lib_jpeg_components[c];
+                for (alt_u32 b = 0; ok && (b < (alt_u32)(comp->h * comp->v)); b++) {
+                    alt_32 diff;
+                    alt_u32 count = 0;
+                    ok = lib_jpeg_walk_block(&br, comp, &diff, &count);
+                    if (c == 0) {
+                        luma_blocks++;
+                        dc_sum += comp->pred;
+                        ac_count += count;
+                    }
+                }
+            }
+        }
+        if (!ok || (luma_blocks == 0)) {
+            break;
+        }
+
+        /* estimates come from the luma quantizer, DC level is 8x the block mean around mid grey */
+        const alt_u16* quant = lib_jpeg_quant[lib_jpeg_components[0].tq];
+        alt_u32 quant_sum = 0;
+        for (alt_u32 k = 0; k < LIB_JPEG_BLOCK_SIZE; k++) {
+            quant_sum += quant[k];
+        }
+        score->quant = quant_sum / LIB_JPEG_BLOCK_SIZE;
+        score->luma_blocks = luma_blocks;
+
+        alt_32 mean = LIB_JPEG_MID_GREY + (((dc_sum / (alt_32)luma_blocks) * (alt_32)quant[0]) / 8);
+        score->mean_luma = (mean < 0) ? 0 : ((mean > 255) ? 255 : mean);
+        score->sharpness = (ac_count * score->quant * 16) / luma_blocks;
+
+        alt_u32 off_grey = (score->mean_luma > LIB_JPEG_MID_GREY) ? (score->mean_luma - LIB_JPEG_MID_GREY) :
+                                                                        (LIB_JPEG_MID_GREY - score->mean_luma);
+        score->score = (score->sharpness * (LIB_JPEG_MID_GREY - ((off_grey > LIB_JPEG_MID_GREY) ?
+                                                                LIB_JPEG_MID_GREY : off_grey))) / LIB_JPEG_MID_GREY;
+        res = LIB_JPEG_SUCCESS;
+    } while (0);
+
+    return res;
+}
+
+/**
+ * @brief start parsing a new frame
+ *
+ * @param parser parser to reset
+ * @param strip true to drop APPn and COM segments, the image decodes the same without them
+ */
+void lib_jpeg_parser_init(lib_jpeg_parser_S* parser, bool strip) {
+    parser->status = LIB_JPEG_PARSE_MORE;
+    parser->state = LIB_JPEG_STATE_SOI_MARKER;
+    parser->remaining = 0;
+    parser->held = 0;
+    parser->stripped = 0;
+    parser->scans = 0;
+    parser->strip = strip;
+    parser->dropping = false;
+    parser->in_sos = false;
+}
+
+/**
+ * @brief handle a marker code, the 0xFF before it is already in the output and held
+ *
+ * @param parser parser
+ * @param buf frame buffer
+ * @param out in/out: output position
+ * @param code marker code
+ */
+static void lib_jpeg_parse_code(lib_jpeg_parser_S* parser, alt_u8* buf, alt_u32* out, alt_u8 code) {
+    if (code == LIB_JPEG_MARKER) {
+        /* fill byte, one 0xFF is enough */
+        parser->stripped++;
+        return;
+    }
+
+    if ((code == LIB_JPEG_SOI) || (code == LIB_JPEG_STUFFED) || ((code >= LIB_JPEG_RST0) && (code <= LIB_JPEG_RST7)) ||
+                                                            ((code == LIB_JPEG_EOI) && (parser->scans == 0))) {
+        /* out of place, nothing after this can be trusted */
+        parser->status = LIB_JPEG_PARSE_ERROR;
+        return;
+    }
+
+    if (parser->strip && (((code >= LIB_JPEG_APP0) && (code <= LIB_JPEG_APP15)) || (code == LIB_JPEG_COM))) {
+        /* take the held 0xFF back out */
+        (*out)--;
+        parser->held = 0;
+        parser->stripped += 2;
+        parser->dropping = true;
+        parser->in_sos = false;
+        parser->state = LIB_JPEG_STATE_LENGTH_HI;
+        return;
+    }
+
+    buf[(*out)++] = code;
+    parser->held = 0;
+    if (code == LIB_JPEG_EOI) {
+        parser->status = LIB_JPEG_PARSE_END;
+    } else if (code == LIB_JPEG_TEM) {
+        parser->state = LIB_JPEG_STATE_MARKER;
+    } else {
+        parser->dropping = false;
+        parser->in_sos = (code == LIB_JPEG_SOS);
+        parser->state = LIB_JPEG_STATE_LENGTH_HI;
+    }
+}
+
+/**
+ * @brief run newly read frame data through the parser. The data is compacted in place: raw bytes sit at
+ *        buf[fill, fill + len) and the kept ones are moved down to follow the output so far. Parsing stops at EOI, the
+ *        rest of the raw data is left alone.
+ *
+ * @param parser parser for this frame
+ * @param buf frame buffer
+ * @param fill output so far, the previous return value, 0 for a new frame
+ * @param len number of raw bytes read in after the output
+ * @return alt_u32 output size, the last parser->held bytes of it are not decided yet
+ */
+alt_u32 lib_jpeg_parse(lib_jpeg_parser_S* parser, alt_u8* buf, alt_u32 fill, alt_u32 len) {
+    alt_u32 out = fill;
+
+    for (alt_u32 in = fill; (in < (fill + len)) && (parser->status == LIB_JPEG_PARSE_MORE); in++) {
+        alt_u8 c = buf[in];
+
+        switch (parser->state) {
+            case LIB_JPEG_STATE_SOI_MARKER:
+            case LIB_JPEG_STATE_SOI_CODE:
+                if (c != ((parser->state == LIB_JPEG_STATE_SOI_MARKER) ? LIB_JPEG_MARKER : LIB_JPEG_SOI)) {
+                    parser->status = LIB_JPEG_PARSE_ERROR;
+                    break;
+                }
+                buf[out++] = c;
+                parser->state = (parser->state == LIB_JPEG_STATE_SOI_MARKER) ? LIB_JPEG_STATE_SOI_CODE :
+                                                                                            LIB_JPEG_STATE_MARKER;
+                break;
+
+            case LIB_JPEG_STATE_MARKER:
+                if (c != LIB_JPEG_MARKER) {
+                    parser->status = LIB_JPEG_PARSE_ERROR;
+                    break;
+                }
+                buf[out++] = c;
+                parser->held = 1;
+                parser->state = LIB_JPEG_STATE_CODE;
+                break;
+
+            case LIB_JPEG_STATE_CODE:
+                lib_jpeg_parse_code(parser, buf, &out, c);
+                break;
+
+            case LIB_JPEG_STATE_LENGTH_HI:
+            case LIB_JPEG_STATE_LENGTH_LO:
+            case LIB_JPEG_STATE_BODY:
+                if (parser->dropping) {
+                    parser->stripped++;
+                } else {
+                    buf[out++] = c;
+                }
+                if (parser->state == LIB_JPEG_STATE_LENGTH_HI) {
+                    parser->remaining = (alt_u32)c << 8;
+                    parser->state = LIB_JPEG_STATE_LENGTH_LO;
+                    break;
+                }
+                if (parser->state == LIB_JPEG_STATE_LENGTH_LO) {
+                    /* the length counts itself */
+                    parser->remaining |= c;
+                    if (parser->remaining < 2) {
+                        parser->status = LIB_JPEG_PARSE_ERROR;
+                        break;
+                    }
+                    parser->remaining -= 2;
+                } else {
+                    parser->remaining--;
+                }
+                parser->state = LIB_JPEG_STATE_BODY;
+                if (parser->remaining == 0) {
+                    if (parser->in_sos) {
+                        parser->scans++;
+                        parser->state = LIB_JPEG_STATE_ENTROPY;
+                    } else {
+                        parser->state = LIB_JPEG_STATE_MARKER;
+                    }
+                }
+                break;
+
+            case LIB_JPEG_STATE_ENTROPY:
+                buf[out++] = c;
+                if (c == LIB_JPEG_MARKER) {
+                    parser->held = 1;
+                    parser->state = LIB_JPEG_STATE_ENTROPY_MARKER;
+                }
+                break;
+
+            case LIB_JPEG_STATE_ENTROPY_MARKER:
+                if ((c == LIB_JPEG_STUFFED) || ((c >= LIB_JPEG_RST0) && (c <= LIB_JPEG_RST7))) {
+                    buf[out++] = c;
+                    parser->held = 0;
+                    parser->state = LIB_JPEG_STATE_ENTROPY;
+                } else {
+                    /* end of the scan, EOI or the tables for the next one */
+                    parser->state = LIB_JPEG_STATE_CODE;
+                    lib_jpeg_parse_code(parser, buf, &out, c);
+                }
+                break;
+
+            default:
+                parser->status = LIB_JPEG_PARSE_ERROR;
+                break;
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file lib_jpeg.h
+ * @author Emery Nagy
+ * @brief Lightweight JPEG inspection for picking the best frame out of a burst and checking frames as they stream in
+ * @version 0.1
+ * @date 2023-03-10
+ *
+ */
+
+#ifndef LIB_JPEG_H_
+#define LIB_JPEG_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* stdlib includes */
+#include "stdbool.h"
+
+/* Public defines */
+#define LIB_JPEG_MID_GREY 128
+
+/* Public types */
+
+/**
+ * @brief jpeg result enum
+ *
+ */
+typedef enum {
+    LIB_JPEG_SUCCESS,
+    LIB_JPEG_ERROR // not a baseline huffman JPEG or the scan is corrupt, only size is filled in
+} lib_jpeg_result_E;
+
+/**
+ * @brief frame quality estimate, higher score is better
+ *
+ */
+typedef struct {
+    /* JPEG size in bytes, blurry frames compress smaller */
+    alt_u32 size;
+    /* average luma quantizer step */
+    alt_u32 quant;
+    /* number of 8x8 luma blocks */
+    alt_u32 luma_blocks;
+    /* average luma level 0-255 from the DC coefficients, exposure proxy */
+    alt_u32 mean_luma;
+    /* nonzero luma AC coefficients per block weighted by the quantizer, x16 fixed point, sharpness proxy */
+    alt_u32 sharpness;
+    /* sharpness scaled down the further exposure is from mid grey */
+    alt_u32 score;
+} lib_jpeg_score_S;
+
+/**
+ * @brief streaming parser status
+ *
+ */
+typedef enum {
+    LIB_JPEG_PARSE_MORE, // frame is fine so far, feed more data
+    LIB_JPEG_PARSE_END, // EOI seen, anything the camera sends after it is padding
+    LIB_JPEG_PARSE_ERROR // bad SOI, marker or segment structure, the frame is corrupt
+} lib_jpeg_parse_E;
+
+/**
+ * @brief streaming marker parser, checks SOI/EOI structure and optionally strips APPn/COM segments as the frame
+ *        comes in. Owned by the caller, one per frame.
+ *
+ */
+typedef struct {
+    /* parse status */
+    lib_jpeg_parse_E status;
+    /* position in the marker structure, private */
+    alt_u32 state;
+    /* bytes left in the current marker segment */
+    alt_u32 remaining;
+    /* bytes at the end of the output that may still be dropped, not safe to hand out yet */
+    alt_u32 held;
+    /* bytes stripped so far */
+    alt_u32 stripped;
+    /* scans started so far, the headers before the first one have been checked once this is nonzero */
+    alt_u32 scans;
+    /* drop APPn and COM segments */
+    bool strip;
+    /* current segment is being dropped */
+    bool dropping;
+    /* current segment is SOS, entropy coded data follows it */
+    bool in_sos;
+} lib_jpeg_parser_S;
+
+/* Public API */
+lib_jpeg_result_E lib_jpeg_score(const alt_u8* data, alt_u32 len, lib_jpeg_score_S* score);
+void lib_jpeg_parser_init(lib_jpeg_parser_S* parser, bool strip);
+alt_u32 lib_jpeg_parse(lib_jpeg_parser_S* parser, alt_u8* buf, alt_u32 fill, alt_u32 len);
+
+#endif /* LIB_JPEG_H_ */
@@ -24,6 +24,10 @@
 
 /* lib includes */
 #include "lib_uart.h"
+#include "lib_at_matcher.h"
+#include "lib_baud.h"
+#include "lib_base64.h"
+#include "lib_urc.h"
 #include "lib_lte.h"
 #include "lib_lte_cmd.h"
 
@@ -31,34 +35,53 @@
 #define LIB_LTE_RX_BUF_SIZE 513 // 512 byte buffer + 1 for
 #define LIB_LTE_RX_BUF_SIZE_SMALL 64
 #define LIB_LTE_RX_BUF_SIZE_GPS_PAYLOAD LIB_LTE_RX_BUF_SIZE_SMALL + 95 // guaranteed 94 byte async data payload
+#define LIB_LTE_RX_BUF_SIZE_SOCKET (LIB_LTE_SOCKET_RECV_MAX + LIB_LTE_RX_BUF_SIZE_SMALL) // received data plus framing
 #define LIB_LTE_AT_PRINT_OUTPUT 0
 #define LIB_LTE_AT_PORT_ECHO_RESPONSE 0
 #define LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS 1000
 #define LIB_LTE_AT_MODULE_RESET_WAKEUP_RETRIES 20
+#define LIB_LTE_ARGS_SCRATCH_SIZE 24 // largest formatted numeric args, ie "<len>,<timeout>"
+#define LIB_LTE_CMD_PROMPT '>' // module is ready for raw data
+#define LIB_LTE_HTTP_BODY_INPUT_TIMEOUT_MS 10000 // how long the module waits for all raw body bytes
+#define LIB_LTE_URC_TASK_STACK_SIZE 512
+#define LIB_LTE_URC_TASK_PRIORITY 4
+#define LIB_LTE_RESULT_OK "OK" // result codes as bare lines, these always belong to the pending command
+#define LIB_LTE_RESULT_ERROR "ERROR"
+#define LIB_LTE_URC_PDP "+APP PDP: 0," // PDP context 0 changed state
+#define LIB_LTE_URC_PDP_ACTIVE "ACTIVE"
+#define LIB_LTE_URC_READY "RDY" // module restarted
+#define LIB_LTE_URC_HTTP_STATE "+SHSTATE: " // http connection state, 1 while connected
+#define LIB_LTE_HTTP_URL_SIZE 96
+#define LIB_LTE_HTTP_SESSION_TRUST_MS 5000 // an idle connection is checked with AT+SHSTATE? before it is reused
+#define LIB_LTE_SOCKET_INPUT_TIMEOUT_MS 10000 // how long the module waits for all raw send bytes
+#define LIB_LTE_SOCKET_OPEN_TIMEOUT_MS 15000 // TCP handshake over the air
+#define LIB_LTE_URC_SOCKET_DATA "+CADATAIND: " // data is waiting on a socket, read it with AT+CARECV
+#define LIB_LTE_URC_SOCKET_STATE "+CASTATE: " // socket state changed, 0 once the remote end closed it
 
 /* private types */
 
-typedef enum {
-    RX_RECEIVING,
-    RX_ERROR,
-    RX_DONE
-} lib_lte_rxstate_E;
-
-/* lte module rx buffer used to collect data from uart callback */
+/* http session, what the module was last configured with so unchanged parameters are not sent again */
 typedef struct {
-    /* rx buffer */
-    volatile alt_u8* rx_buf;
-
-    /* rx buffer current index */
-    alt_u32 idx;
-
-    /* rx buffer size */
-    alt_u32 buffersize;
-
-    /* Current RX state */
-    lib_lte_rxstate_E rx_state;
-
-} lib_lte_rx_buffer_S;
+    /* configured URL, empty if unknown */
+    char url[LIB_LTE_HTTP_URL_SIZE];
+    /* configured sizes, 0 if unknown */
+    alt_u16 hdr_size;
+    alt_u16 body_size;
+    /* connection is up as far as we know */
+    volatile bool connected;
+    /* last request failed, check the connection before trusting it again */
+    bool suspect;
+    /* tick of the last successful request */
+    TickType_t last_used;
+} lib_lte_http_session_S;
+
+/* socket, as far as the URCs tell us */
+typedef struct {
+    /* connection is up */
+    volatile bool connected;
+    /* the module holds received data that has not been read yet */
+    volatile bool readable;
+} lib_lte_socket_S;
 
 /* state struct */
 typedef struct {
@@ -66,83 +89,166 @@ typedef struct {
     /* UART settings */
     lib_uart_config_S* config;
 
-    /* RX buffer */
-    volatile lib_lte_rx_buffer_S* rxbuf;
-
     /* mutex for handling multiple requests */
     SemaphoreHandle_t mutex;
 
+    /* URC dispatcher task */
+    TaskHandle_t urc_task;
+
+    /* PDP context is up, kept current by the URC dispatcher */
+    bool network_attached;
+
+    /* http session */
+    lib_lte_http_session_S http;
+
+    /* raw TCP sockets, indexed by connection id */
+    lib_lte_socket_S sockets[LIB_LTE_SOCKET_COUNT];
+
 } lib_lte_state_S;
 
-/* UART driver */
-static void lib_lte_rx_error_callback(void);
-static void lib_lte_rx_callback(alt_u8 rxdata);
+/* what the RX irq does with a byte besides line assembly for the URC dispatcher */
+typedef enum {
+    LIB_LTE_RX_IDLE, // no command is pending
+    LIB_LTE_RX_MATCH, // run the response matcher
+    LIB_LTE_RX_PROMPT // run the response matcher, a data prompt also completes the wait
+} lib_lte_rx_mode_E;
+
+/* command payload base64 encoded straight into the TX ring between the args and the footer */
+typedef struct {
+    /* working copy of the caller's encoder */
+    lib_base64_ctx_S encoder;
+    /* raw payload */
+    const alt_u8* data;
+    alt_u32 len;
+    /* pad and end the encoding after this payload */
+    bool last;
+} lib_lte_payload_S;
 
 
 /* Private data */
 
-/* uart configuration */
+/* uart configuration, responses are collected by lib_uart and read in bulk from task context */
 static lib_uart_config_S lte_config = {
-    .uart_rx_irq = (lib_uart_generic_rx_irq*)lib_lte_rx_callback,
-    .uart_rx_error = (lib_uart_rx_error*)lib_lte_rx_error_callback
+    .name = "cell",
+    .uart_rx_irq = NULL,
+    .uart_rx_error = NULL,
+    .uart_freq = CELL_MODULE_FREQ,
+    .fixed_baud = CELL_MODULE_FIXED_BAUD,
+    .baud = CELL_MODULE_BAUD
 };
 
-/* state configuration, initially no rxbuffer set up */
+/* response matcher, rebuilt for every command and stepped from the UART RX irq */
+static lib_at_matcher_S lte_matcher;
+
+/* set from the UART RX irq once a data prompt arrives */
+static volatile bool lte_prompt = false;
+
+/* only changed while the irq leaves the matcher alone, ie set to idle before the matcher is rebuilt */
+static volatile lib_lte_rx_mode_E lte_rx_mode = LIB_LTE_RX_IDLE;
+
+/* every line from the module goes through here, lines the pending command does not claim reach the handlers */
+static lib_urc_S lte_urc;
+
+/* numeric args are formatted here, every other part of a command is rendered at compile time or sent in place. Only
+ * the app task talks to the module so one buffer is enough */
+static char lte_args[LIB_LTE_ARGS_SCRATCH_SIZE];
+
+/* state configuration */
 volatile static lib_lte_state_S lte_state = {
     .config = &lte_config,
-    .rxbuf = NULL,
+};
+
+static bool lib_lte_request_baud(alt_u32 rate, alt_u32 timeout_ms);
+static bool lib_lte_verify_link(alt_u32 timeout_ms);
+
+/* module powers on at the system.h rate, AT+IPR takes it up to 921600 in two steps. Ports generated with a fixed baud
+ * rate have no divisor register, negotiation is skipped on those */
+static lib_baud_link_S lte_baud = {
+    .config = &lte_config,
+    .rates = {CELL_MODULE_BAUD, 460800, 921600},
+    .stage_count = 3,
+    .stage = 0,
+    .ceiling = 2,
+    .request = lib_lte_request_baud,
+    .verify = lib_lte_verify_link,
+    .cmd_timeout_ms = LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS,
+    .error_limit = LIB_BAUD_DEFAULT_ERROR_LIMIT
 };
 
 /**
- * @brief UART rx error callback, sets rxbuffer error to notify lib that incoming data chunk is garbage
+ * @brief UART RX irq hook, installed for the life of the driver. Every byte is assembled into lines for the URC
+ *        dispatcher, and runs through the response matcher while a command is pending. The data prompt has no line
+ *        ending so it wakes the task on its own, an ERROR in its place is still caught by the matcher.
  *
+ * @param rxdata received byte
+ * @return true once the command response is complete or the prompt arrived to wake the waiting task
  */
-static void lib_lte_rx_error_callback(void) {
-    volatile lib_lte_rx_buffer_S* buffer = lte_state.rxbuf;
-    if (buffer == NULL) {
-        return;
+static bool lib_lte_rx_irq(alt_u8 rxdata) {
+    if (lib_urc_feed(&lte_urc, rxdata) && (lte_state.urc_task != NULL)) {
+        vTaskNotifyGiveFromISR(lte_state.urc_task, NULL);
     }
-    /* set rxbuffer error for currently incomming data only if we are expecting a response */
-    if (buffer->rx_state == RX_RECEIVING) {
-        buffer->rx_state = RX_ERROR;
+
+    switch (lte_rx_mode) {
+        case LIB_LTE_RX_PROMPT:
+            if (rxdata == LIB_LTE_CMD_PROMPT) {
+                lte_prompt = true;
+                return true;
+            }
+            return lib_at_matcher_step(&lte_matcher, rxdata);
+        case LIB_LTE_RX_MATCH:
+            return lib_at_matcher_step(&lte_matcher, rxdata);
+        default:
+            return false;
     }
 }
 
 /**
- * @brief UART rxdata callback, writes new data into rxbuffer if rxbuffer is in a good state,
+ * @brief build the response matcher for a command: OK and ERROR result codes plus the <cmd>: response line or the
+ *        async response string the command waits on
  *
- * @param rxdata incoming UART data
+ * @param cmd command datastructure
  */
-static void lib_lte_rx_callback(alt_u8 rxdata) {
-    volatile lib_lte_rx_buffer_S* buffer = lte_state.rxbuf;
-    if (buffer == NULL) {
-        return;
+static void lib_lte_build_matcher(const lib_lte_cmd_type_E* cmd) {
+    lib_at_matcher_init(&lte_matcher);
+    lib_at_matcher_add(&lte_matcher, LIB_LTE_CMD_RESP_OK, sizeof(LIB_LTE_CMD_RESP_OK) - 1, LIB_AT_MATCHER_REQUIRED);
+    lib_at_matcher_add(&lte_matcher, LIB_LTE_CMD_RESP_ERROR, sizeof(LIB_LTE_CMD_RESP_ERROR) - 1, LIB_AT_MATCHER_FINAL);
+    if (cmd->resp_type == LIB_LTE_RESP_TYPE_STRING) {
+        /* response line is in the format <cmd>: <data> */
+        lib_at_matcher_add(&lte_matcher, cmd->resp_prefix, cmd->resp_prefix_len, LIB_AT_MATCHER_REQUIRED);
+    } else if (cmd->resp_type == LIB_LTE_RESP_TYPE_ASYNC) {
+        lib_at_matcher_add(&lte_matcher, cmd->response_str, cmd->resp_len - 1, LIB_AT_MATCHER_REQUIRED);
     }
+    lib_at_matcher_compile(&lte_matcher);
+}
 
-    /* set rxbuffer error for currently incomming data only if we are expecting a response */
-    if (buffer->rx_state == RX_RECEIVING) {
-        buffer->rx_buf[buffer->idx] = rxdata;
-        (buffer->idx)++;
-        if (buffer->idx >= buffer->buffersize) {
-            buffer->rx_state = RX_DONE;
-        }
+/**
+ * @brief hold the lines a command answers with back from the URC handlers: result codes plus the <cmd>: response
+ *        line or the async response string the command waits on
+ *
+ * @param cmd command datastructure
+ */
+static void lib_lte_claim_response(const lib_lte_cmd_type_E* cmd) {
+    lib_urc_claim(&lte_urc, LIB_LTE_RESULT_OK, sizeof(LIB_LTE_RESULT_OK) - 1);
+    lib_urc_claim(&lte_urc, LIB_LTE_RESULT_ERROR, sizeof(LIB_LTE_RESULT_ERROR) - 1);
+    if (cmd->resp_type == LIB_LTE_RESP_TYPE_STRING) {
+        lib_urc_claim(&lte_urc, cmd->resp_prefix, cmd->resp_prefix_len);
+    } else if (cmd->resp_type == LIB_LTE_RESP_TYPE_ASYNC) {
+        lib_urc_claim(&lte_urc, cmd->response_str, cmd->resp_len - 1);
     }
 }
 
 /**
  * @brief Send a command sequence to the lte module
  *
- * @param cmd command sequence to sent
- * @param cmd_len size of command sequence
+ * @param iov command fragments to send
+ * @param count number of command fragments
  * @param cmd_tx_timeout timeout of transmission window in ms
- * @param rxbuf receivebuffer for response data
  * @return lib_lte_result_E
  */
-static lib_lte_result_E lib_lte_send_cmd(alt_u8* cmd, alt_u32 cmd_len, alt_u32 cmd_tx_timeout) {
+static lib_lte_result_E lib_lte_send_cmd(const lib_uart_iovec_S* iov, alt_u32 count, alt_u32 cmd_tx_timeout) {
 
     lib_lte_result_E result = LTE_ERROR;
-    /* set up rx buffer before sending command */
-    if (lib_uart_tx(lte_state.config, cmd, cmd_len, cmd_tx_timeout) == LIB_UART_SUCCESS) {
+    if (lib_uart_txv(lte_state.config, iov, count, cmd_tx_timeout) == LIB_UART_SUCCESS) {
         result = LTE_SUCCESS;
     }
 
@@ -150,39 +256,125 @@ static lib_lte_result_E lib_lte_send_cmd(alt_u8* cmd, alt_u32 cmd_len, alt_u32 c
 }
 
 /**
- * @brief construct command string from command datatypes
+ * @brief base64 sink feeding the module TX ring
  *
- * @param cmd command datastructure
- * @param cmd_data command data string
- * @param cmd_len command size
+ * @param data encoded text
+ * @param len number of characters
+ * @param sink_ctx transmit timeout in ms
+ * @return true if the text was queued in time
+ */
+static bool lib_lte_tx_sink(const alt_u8* data, alt_u32 len, void* sink_ctx) {
+    return (lib_uart_tx_stream(lte_state.config, data, len, *(alt_u32*)sink_ctx) == LIB_UART_SUCCESS);
+}
+
+/**
+ * @brief Send a command sequence to the lte module with a payload encoded in front of the footer, the encoded text
+ *        never exists anywhere but the TX ring
+ *
+ * @param iov command fragments to send, the last one is the footer
+ * @param count number of command fragments
+ * @param payload payload to encode, its encoder is advanced
+ * @param cmd_tx_timeout timeout of transmission window in ms
  * @return lib_lte_result_E
  */
-static lib_lte_result_E lib_lte_construct_cmd_strings(lib_lte_cmd_type_E cmd, alt_u8** cmd_data, alt_u32* cmd_len, alt_u8* preformatted_args) {
+static lib_lte_result_E lib_lte_send_cmd_payload(const lib_uart_iovec_S* iov, alt_u32 count, lib_lte_payload_S* payload,
+                                                                                            alt_u32 cmd_tx_timeout) {
+    lib_lte_result_E result = LTE_ERROR;
 
-    /* first calculate the length of command and response */
-    *cmd_len = (cmd.cmd_len + LIB_LTE_CMD_SIZE_OVERHEAD + cmd.args_len);
-    if (cmd.formatted_args == true) {
-        *cmd_len = *cmd_len + strlen(preformatted_args);
-    }
-    /* generate AT command string */
-    alt_u8* cmd_string = (alt_u8*)pvPortMalloc(*cmd_len);
-    memset(cmd_string, 0, *cmd_len);
-    strcat(cmd_string, LIB_LTE_CMD_HEADER);
-    strcat(cmd_string, cmd.cmd);
-    if (cmd.is_query) {
-        strcat(cmd_string, LIB_LTE_CMD_QUERY);
-    } else if (cmd.formatted_args == true) {
-        strcat(cmd_string, LIB_LTE_CMD_ARGS_ASSIGNMENT);
-        strcat(cmd_string, preformatted_args);
+    payload->encoder.sink = lib_lte_tx_sink;
+    payload->encoder.sink_ctx = &cmd_tx_timeout;
+
+    do {
+        alt_u32 i = 0;
+        for (; i < (count - 1); i++) {
+            if (lib_uart_tx_stream(lte_state.config, iov[i].base, iov[i].len, cmd_tx_timeout) != LIB_UART_SUCCESS) {
+                break;
+            }
+        }
+        if (i < (count - 1)) {
+            break;
+        }
+        if (!lib_base64_update(&payload->encoder, payload->data, payload->len)) {
+            break;
+        }
+        if (payload->last && !lib_base64_final(&payload->encoder)) {
+            break;
+        }
+        if ((lib_uart_tx_stream(lte_state.config, iov[count - 1].base, iov[count - 1].len, cmd_tx_timeout) !=
+                    LIB_UART_SUCCESS) || (lib_uart_tx_drain(lte_state.config, cmd_tx_timeout) != LIB_UART_SUCCESS)) {
+            break;
+        }
+        result = LTE_SUCCESS;
+    } while (0);
+
+    return result;
+}
+
+/**
+ * @brief collect the response to a command that has been sent until the matcher completes or the prompt arrives
+ *
+ * @param rx response buffer, LIB_LTE_RX_BUF_SIZE bytes
+ * @param idx bytes already in the response buffer, advanced by what is read
+ * @param timeout_ms response timeout in ms
+ * @return lib_lte_result_E
+ */
+static lib_lte_result_E lib_lte_wait_response(alt_u8* rx, alt_u32* idx, alt_u32 timeout_ms) {
+    lib_lte_result_E res = LTE_TIMEOUT;
+    alt_u32 start_time = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    TickType_t elapsed;
+
+    while ((elapsed = (xTaskGetTickCount() - start_time)) <= timeout) {
+        lib_uart_rx_wait(lte_state.config, timeout - elapsed);
+
+        /* sample completion before draining, every byte the matcher has seen is already in the ring */
+        bool prompt = lte_prompt;
+        bool done = lib_at_matcher_done(&lte_matcher);
+        *idx += lib_uart_rx_read(lte_state.config, rx + *idx, (LIB_LTE_RX_BUF_SIZE - 1) - *idx);
+
+        /* conditions for AT command success are 1) OK response string, 2) Command response string if applicable,
+         * and any response must end in \r\n. A data prompt ends the wait on its own */
+        if (prompt) {
+            res = LTE_SUCCESS;
+            break;
+        } else if (done) {
+            res = lib_at_matcher_complete(&lte_matcher) ? LTE_SUCCESS : LTE_ERROR;
+            break;
+        } else if (*idx >= (LIB_LTE_RX_BUF_SIZE - 1)) {
+            res = LTE_ERROR;
+            break;
+        } else if (lib_uart_rx_take_error(lte_state.config)) {
+            res = LTE_ERROR;
+            break;
+        }
     }
-    else if (cmd.args_len != 0) {
-        strcat(cmd_string, LIB_LTE_CMD_ARGS_ASSIGNMENT);
-        strcat(cmd_string, cmd.cmd_args);
+
+    return res;
+}
+
+/**
+ * @brief describe the AT command string as a list of fragments without copying anything. The request is rendered at
+ *        compile time, so only commands with formatted args need more than one fragment: AT<cmd>=, <args...>, \r
+ *
+ * @param cmd command datastructure
+ * @param args formatted arg fragments (only used if the command takes formatted args)
+ * @param args_count number of formatted arg fragments
+ * @param iov output fragment list, must hold LIB_LTE_CMD_MAX_FRAGMENTS entries
+ * @return alt_u32 number of fragments used
+ */
+static alt_u32 lib_lte_construct_cmd_iov(const lib_lte_cmd_type_E* cmd, const lib_uart_iovec_S* args, alt_u32 args_count,
+                                                                                                lib_uart_iovec_S* iov) {
+    alt_u32 count = 0;
+
+    iov[count++] = (lib_uart_iovec_S){cmd->request, cmd->request_len};
+    if (cmd->formatted_args == true) {
+        for (alt_u32 i = 0; (i < args_count) && (i < LIB_LTE_CMD_MAX_ARG_FRAGMENTS); i++) {
+            iov[count++] = args[i];
+        }
+        iov[count++] = (lib_uart_iovec_S){LIB_LTE_CMD_FOOTER, sizeof(LIB_LTE_CMD_FOOTER) - 1};
     }
-    strcat(cmd_string, LIB_LTE_CMD_FOOTER);
 
-    *cmd_data = cmd_string;
-    return LTE_SUCCESS;
+    return count;
 }
 
 
@@ -190,87 +382,67 @@ static lib_lte_result_E lib_lte_construct_cmd_strings(lib_lte_cmd_type_E cmd, al
  * @brief execute AT command and parse reponse
  *
  * @param cmd command to execute
- * @param preformatted_args already formatted args to send with AT command
+ * @param args formatted arg fragments to send with AT command, sent back to back without being copied
+ * @param args_count number of formatted arg fragments
+ * @param payload optional -> payload base64 encoded after the args
  * @param rxbuf optional -> copy rxsize bytes captured from the AT port to existing buffer rxbuf
  * @param rxsize optional -> number of bytes to copy out
  * @param timeout_ms command timeout in ms
  * @return lib_lte_result_E
  */
-static lib_lte_result_E lib_lte_execute_cmd(lib_lte_cmd_type_E cmd, alt_u8* preformatted_args, alt_u8* rxbuf, alt_u32 rxsize, alt_u32 timeout_ms) {
+static lib_lte_result_E lib_lte_execute_cmd_v(lib_lte_cmd_type_E cmd, const lib_uart_iovec_S* args, alt_u32 args_count,
+                                    lib_lte_payload_S* payload, alt_u8* rxbuf, alt_u32 rxsize, alt_u32 timeout_ms) {
     lib_lte_result_E res = LTE_TIMEOUT;
 
     /* make rx buf */
     alt_u8 rx[LIB_LTE_RX_BUF_SIZE] = {0};
-    volatile lib_lte_rx_buffer_S new_rx_buf = {
-        .buffersize = LIB_LTE_RX_BUF_SIZE,
-        .idx = 0,
-        .rx_buf = rx,
-        .rx_state = RX_RECEIVING
-    };
+    alt_u32 idx = 0;
 
-    lte_state.rxbuf = &new_rx_buf;
+    /* anything received before the command was sent does not belong to it */
+    lib_uart_rx_flush(lte_state.config);
+    lib_uart_rx_take_error(lte_state.config);
 
-    /* generate command data */
-    alt_u8* cmd_data = NULL;
-    alt_u32 cmd_data_len = 0;
-    lib_lte_construct_cmd_strings(cmd, &cmd_data, &cmd_data_len, preformatted_args);
+    /* the matcher runs on every byte in the RX irq and only wakes us once the response is complete, or the buffer
+     * would overflow */
+    lib_lte_build_matcher(&cmd);
+    lib_lte_claim_response(&cmd);
+    lte_prompt = false;
+    lte_rx_mode = LIB_LTE_RX_MATCH;
+    lib_uart_rx_listen(lte_state.config, xTaskGetCurrentTaskHandle(), LIB_LTE_RX_BUF_SIZE - 1, LIB_UART_RX_NO_TERMINATOR);
+
+    /* describe command data */
+    lib_uart_iovec_S cmd_iov[LIB_LTE_CMD_MAX_FRAGMENTS];
+    alt_u32 cmd_iov_count = lib_lte_construct_cmd_iov(&cmd, args, args_count, cmd_iov);
 
     do {
 
         /* first send the command */
-        res = lib_lte_send_cmd(cmd_data, cmd_data_len, timeout_ms);
+        if (payload == NULL) {
+            res = lib_lte_send_cmd(cmd_iov, cmd_iov_count, timeout_ms);
+        } else {
+            res = lib_lte_send_cmd_payload(cmd_iov, cmd_iov_count, payload, timeout_ms);
+        }
         if (res != LTE_SUCCESS) {
             break;
         }
 
-        alt_u32 start_time = xTaskGetTickCount();
-        res = LTE_TIMEOUT;
-        /* wait for command response */
-        while (((xTaskGetTickCount() - start_time)) <= pdMS_TO_TICKS(timeout_ms)) {
-            //vTaskDelay(pdMS_TO_TICKS(5)); //10ms delay, let other tasks do their thing
-            /* conditions for AT command success are 1) OK response string, 2) Command response string if applicable,
-             * and any response must end in \r\n */
-            if (strstr(new_rx_buf.rx_buf, LIB_LTE_CMD_RESP_OK)) {
-                /* if the response type is a regular string then we look for the regex pattern <cmd>: */
-                if (cmd.resp_type == LIB_LTE_RESP_TYPE_STRING) {
-                    alt_u8* search_str[LIB_LTE_RX_BUF_SIZE_SMALL];
-                    sprintf(search_str, "%s: ", cmd.cmd);
-                    if ((strstr(new_rx_buf.rx_buf, search_str) != NULL) &&
-                        (new_rx_buf.rx_buf[new_rx_buf.idx-1] == '\n') &&
-                        (new_rx_buf.rx_buf[new_rx_buf.idx-2] == '\r')) {
-                            res = LTE_SUCCESS;
-                            break;
-                    }
-                } else if (cmd.resp_type == LIB_LTE_RESP_TYPE_ASYNC) {
-                    if (strstr(new_rx_buf.rx_buf, cmd.response_str) != NULL) {
-                        res = LTE_SUCCESS;
-                        break;
-                    }
-                } else {
-                    res = LTE_SUCCESS;
-                    break;
-                }
-            } else if (strstr(new_rx_buf.rx_buf, LIB_LTE_CMD_RESP_ERROR) != NULL) {
-                res = LTE_ERROR;
-                break;
-            } else if (new_rx_buf.rx_state == RX_DONE) {
-                res = LTE_ERROR;
-                break;
-            } else if (new_rx_buf.rx_state == RX_ERROR) {
-                res = LTE_ERROR;
-                break;
-            }
-        }
+        res = lib_lte_wait_response(rx, &idx, timeout_ms);
 
     } while (0);
 
-    lte_state.rxbuf = NULL;
+    lib_uart_rx_listen(lte_state.config, NULL, LIB_UART_RX_RING_SIZE, LIB_UART_RX_NO_TERMINATOR);
+    lte_rx_mode = LIB_LTE_RX_IDLE;
+    lib_urc_release(&lte_urc);
 
 #if (LIB_LTE_AT_PRINT_OUTPUT == 1)
-    printf("\nReceived CELL %d:\n", new_rx_buf.idx);
-    printf("CMD: %s, length: %d\n", cmd_data, cmd_data_len);
-    for (int i = 0; i < new_rx_buf.idx; i++) {
-        printf("%c", new_rx_buf.rx_buf[i]);
+    printf("\nReceived CELL %d:\n", idx);
+    printf("CMD: ");
+    for (int i = 0; i < cmd_iov_count; i++) {
+        printf("%.*s", (int)cmd_iov[i].len, (const char*)cmd_iov[i].base);
+    }
+    printf("\n");
+    for (int i = 0; i < idx; i++) {
+        printf("%c", rx[i]);
     }
     printf("\n");
 #endif
@@ -280,11 +452,235 @@ static lib_lte_result_E lib_lte_execute_cmd(lib_lte_cmd_type_E cmd, alt_u8* pref
         memcpy(rxbuf, rx, rxsize);
     }
 
-    vPortFree(cmd_data);
+    return res;
+}
+
+/**
+ * @brief execute AT command and parse reponse
+ *
+ * @param cmd command to execute
+ * @param preformatted_args already formatted args to send with AT command
+ * @param rxbuf optional -> copy rxsize bytes captured from the AT port to existing buffer rxbuf
+ * @param rxsize optional -> number of bytes to copy out
+ * @param timeout_ms command timeout in ms
+ * @return lib_lte_result_E
+ */
+static lib_lte_result_E lib_lte_execute_cmd(lib_lte_cmd_type_E cmd, alt_u8* preformatted_args, alt_u8* rxbuf, alt_u32 rxsize, alt_u32 timeout_ms) {
+    lib_uart_iovec_S args = {.base = preformatted_args, .len = 0};
+    if (cmd.formatted_args && (preformatted_args != NULL)) {
+        args.len = strlen(preformatted_args);
+    }
+    return lib_lte_execute_cmd_v(cmd, &args, 1, NULL, rxbuf, rxsize, timeout_ms);
+}
+
+/**
+ * @brief execute an AT command that prompts for raw data, ie AT+SHBOD. The data is sent as is once the module prompts
+ *        for it and the command completes on the OK that follows it.
+ *
+ * @param cmd command to execute
+ * @param args formatted arg fragments, these announce the data length to the module
+ * @param args_count number of formatted arg fragments
+ * @param data raw data fragments to send back to back after the prompt, their lengths must add up to what the args
+ *        announced
+ * @param data_count number of raw data fragments
+ * @param timeout_ms timeout in ms for the prompt and again for the response to the data
+ * @return lib_lte_result_E
+ */
+static lib_lte_result_E lib_lte_execute_cmd_data(lib_lte_cmd_type_E cmd, const lib_uart_iovec_S* args, alt_u32 args_count,
+                                            const lib_uart_iovec_S* data, alt_u32 data_count, alt_u32 timeout_ms) {
+    lib_lte_result_E res = LTE_ERROR;
+
+    /* make rx buf */
+    alt_u8 rx[LIB_LTE_RX_BUF_SIZE] = {0};
+    alt_u32 idx = 0;
+
+    /* anything received before the command was sent does not belong to it */
+    lib_uart_rx_flush(lte_state.config);
+    lib_uart_rx_take_error(lte_state.config);
+
+    /* wait on the prompt first, an ERROR in its place still completes the matcher */
+    lib_lte_build_matcher(&cmd);
+    lib_lte_claim_response(&cmd);
+    lte_prompt = false;
+    lte_rx_mode = LIB_LTE_RX_PROMPT;
+    lib_uart_rx_listen(lte_state.config, xTaskGetCurrentTaskHandle(), LIB_LTE_RX_BUF_SIZE - 1, LIB_UART_RX_NO_TERMINATOR);
+
+    /* describe command data */
+    lib_uart_iovec_S cmd_iov[LIB_LTE_CMD_MAX_FRAGMENTS];
+    alt_u32 cmd_iov_count = lib_lte_construct_cmd_iov(&cmd, args, args_count, cmd_iov);
+
+    do {
+        if (lib_lte_send_cmd(cmd_iov, cmd_iov_count, timeout_ms) != LTE_SUCCESS) {
+            break;
+        }
+
+        res = lib_lte_wait_response(rx, &idx, timeout_ms);
+        if (res != LTE_SUCCESS) {
+            break;
+        } else if (!lte_prompt) {
+            res = LTE_ERROR;
+            break;
+        }
+
+        /* module is quiet until it has all the data, then answers with a plain OK */
+        lte_rx_mode = LIB_LTE_RX_IDLE;
+        lib_at_matcher_reset(&lte_matcher);
+        lte_prompt = false;
+        lte_rx_mode = LIB_LTE_RX_MATCH;
+
+        res = lib_lte_send_cmd(data, data_count, timeout_ms);
+        if (res != LTE_SUCCESS) {
+            break;
+        }
+
+        res = lib_lte_wait_response(rx, &idx, timeout_ms);
+    } while (0);
+
+    lib_uart_rx_listen(lte_state.config, NULL, LIB_UART_RX_RING_SIZE, LIB_UART_RX_NO_TERMINATOR);
+    lte_rx_mode = LIB_LTE_RX_IDLE;
+    lib_urc_release(&lte_urc);
+
+#if (LIB_LTE_AT_PRINT_OUTPUT == 1)
+    printf("\nReceived CELL %d:\n", idx);
+    printf("CMD: ");
+    for (int i = 0; i < cmd_iov_count; i++) {
+        printf("%.*s", (int)cmd_iov[i].len, (const char*)cmd_iov[i].base);
+    }
+    printf(" + %u data fragments\n", (unsigned int)data_count);
+    for (int i = 0; i < idx; i++) {
+        printf("%c", rx[i]);
+    }
+    printf("\n");
+#endif
 
     return res;
 }
 
+/**
+ * @brief ask the module to change its UART rate with AT+IPR, OK comes back at the old rate
+ *
+ * @param rate new baud rate
+ * @param timeout_ms command timeout
+ * @return true if the module acknowledged
+ */
+static bool lib_lte_request_baud(alt_u32 rate, alt_u32 timeout_ms) {
+    lib_uart_iovec_S args = {lte_args, snprintf(lte_args, sizeof(lte_args), "%u", (unsigned int)rate)};
+    return (lib_lte_execute_cmd_v(LIB_LTE_SET_BAUD_CMD, &args, 1, NULL, NULL, 0, timeout_ms) == LTE_SUCCESS);
+}
+
+/**
+ * @brief handshake with the module by checking the sim status
+ *
+ * @param timeout_ms command timeout
+ * @return true if the module answered correctly at the current rate
+ */
+static bool lib_lte_verify_link(alt_u32 timeout_ms) {
+    return (lib_lte_execute_cmd(LIB_LTE_SIM_STATUS_CMD, NULL, NULL, 0, timeout_ms) == LTE_SUCCESS);
+}
+
+/**
+ * @brief forget the http session, the module lost its configuration and connection (reset or restart)
+ *
+ */
+static void lib_lte_http_session_forget(void) {
+    lte_state.http.url[0] = '\0';
+    lte_state.http.hdr_size = 0;
+    lte_state.http.body_size = 0;
+    lte_state.http.connected = false;
+    lte_state.http.suspect = false;
+}
+
+/**
+ * @brief forget every socket, the module closed them along with the PDP context or on a restart
+ *
+ */
+static void lib_lte_socket_forget_all(void) {
+    for (alt_u32 i = 0; i < LIB_LTE_SOCKET_COUNT; i++) {
+        lte_state.sockets[i].connected = false;
+        lte_state.sockets[i].readable = false;
+    }
+}
+
+/**
+ * @brief PDP context URC, the network can drop the context at any time
+ *
+ * @param line +APP PDP: 0,<ACTIVE|DEACTIVE>
+ * @param len line length
+ * @param ctx unused
+ */
+static void lib_lte_urc_pdp(const char* line, alt_u32 len, void* ctx) {
+    lte_state.network_attached = (strcmp(line + sizeof(LIB_LTE_URC_PDP) - 1, LIB_LTE_URC_PDP_ACTIVE) == 0);
+    if (!lte_state.network_attached) {
+        lte_state.http.connected = false;
+        lib_lte_socket_forget_all();
+    }
+}
+
+/**
+ * @brief module restarted on its own, every network context is gone
+ *
+ * @param line RDY
+ * @param len line length
+ * @param ctx unused
+ */
+static void lib_lte_urc_ready(const char* line, alt_u32 len, void* ctx) {
+    lte_state.network_attached = false;
+    lib_lte_http_session_forget();
+    lib_lte_socket_forget_all();
+}
+
+/**
+ * @brief http connection state reported outside of AT+SHSTATE?, ie the server closed the connection
+ *
+ * @param line +SHSTATE: <0|1>
+ * @param len line length
+ * @param ctx unused
+ */
+static void lib_lte_urc_http_state(const char* line, alt_u32 len, void* ctx) {
+    lte_state.http.connected = (line[sizeof(LIB_LTE_URC_HTTP_STATE) - 1] == '1');
+}
+
+/**
+ * @brief data arrived on a socket, it waits in the module until it is read
+ *
+ * @param line +CADATAIND: <cid>
+ * @param len line length
+ * @param ctx unused
+ */
+static void lib_lte_urc_socket_data(const char* line, alt_u32 len, void* ctx) {
+    alt_u32 cid = strtoul(line + sizeof(LIB_LTE_URC_SOCKET_DATA) - 1, NULL, 10);
+    if (cid < LIB_LTE_SOCKET_COUNT) {
+        lte_state.sockets[cid].readable = true;
+    }
+}
+
+/**
+ * @brief socket state reported outside of a command, ie the remote end closed the connection
+ *
+ * @param line +CASTATE: <cid>,<state>
+ * @param len line length
+ * @param ctx unused
+ */
+static void lib_lte_urc_socket_state(const char* line, alt_u32 len, void* ctx) {
+    char* state;
+    alt_u32 cid = strtoul(line + sizeof(LIB_LTE_URC_SOCKET_STATE) - 1, &state, 10);
+    if ((cid < LIB_LTE_SOCKET_COUNT) && (*state == ',')) {
+        lte_state.sockets[cid].connected = (state[1] != '0');
+    }
+}
+
+/**
+ * @brief URC dispatcher task, runs the handlers for lines the RX irq has queued
+ *
+ * @param params unused
+ */
+static void lib_lte_urc_task(void* params) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        lib_urc_dispatch(&lte_urc);
+    }
+}
+
 /* public API*/
 
 /**
@@ -298,6 +694,19 @@ lib_lte_result_E lib_lte_init(alt_u32 UART_BASE, alt_u32 UART_IRQ) {
     lte_state.config->uart_base = (volatile unsigned int*)UART_BASE;
     lte_state.config->uart_irq = UART_IRQ;
 
+    /* the dispatcher has to be up before the first byte arrives */
+    lib_urc_init(&lte_urc);
+    lib_urc_register(&lte_urc, LIB_LTE_URC_PDP, lib_lte_urc_pdp, NULL);
+    lib_urc_register(&lte_urc, LIB_LTE_URC_READY, lib_lte_urc_ready, NULL);
+    lib_urc_register(&lte_urc, LIB_LTE_URC_HTTP_STATE, lib_lte_urc_http_state, NULL);
+    lib_urc_register(&lte_urc, LIB_LTE_URC_SOCKET_DATA, lib_lte_urc_socket_data, NULL);
+    lib_urc_register(&lte_urc, LIB_LTE_URC_SOCKET_STATE, lib_lte_urc_socket_state, NULL);
+    lib_lte_http_session_forget();
+    lib_lte_socket_forget_all();
+    xTaskCreate(lib_lte_urc_task, "lte_urc", LIB_LTE_URC_TASK_STACK_SIZE, NULL, LIB_LTE_URC_TASK_PRIORITY,
+                                                                                    (TaskHandle_t*)&lte_state.urc_task);
+    lte_state.config->uart_rx_irq = lib_lte_rx_irq;
+
     if (lib_uart_init(lte_state.config) == LIB_UART_SUCCESS) {
         res = LTE_SUCCESS;
     }
@@ -323,6 +732,9 @@ lib_lte_result_E lib_lte_power_state_on(volatile unsigned int* GPIO_BASE) {
         *((volatile unsigned int *)GPIO_BASE) = ~c_gpio;
         vTaskDelay(pdMS_TO_TICKS(2000));
         *((volatile unsigned int *)GPIO_BASE) = c_gpio;
+        lib_baud_module_reset(&lte_baud);
+        lib_lte_http_session_forget();
+        lib_lte_socket_forget_all();
         vTaskDelay(pdMS_TO_TICKS(10000)); // 3.5 seconds for AT port available
 
         /* now attempt to contact module, usually takes a few attempts before it is responsive */
@@ -348,6 +760,24 @@ lib_lte_result_E lib_lte_get_sim_status(void) {
     return lib_lte_execute_cmd(LIB_LTE_SIM_STATUS_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
 }
 
+/**
+ * @brief negotiate the AT port up to the fastest rate both ends hold reliably, no-op on fixed baud ports
+ *
+ * @return lib_lte_result_E LTE_ERROR if the module stopped answering and should be reset
+ */
+lib_lte_result_E lib_lte_negotiate_baud(void) {
+    return (lib_baud_negotiate(&lte_baud) != LIB_BAUD_ERROR) ? LTE_SUCCESS : LTE_ERROR;
+}
+
+/**
+ * @brief check the AT port for a spike in line errors, drops to a slower rate if needed
+ *
+ * @return lib_lte_result_E LTE_ERROR if the module stopped answering and should be reset
+ */
+lib_lte_result_E lib_lte_check_baud(void) {
+    return (lib_baud_check(&lte_baud) != LIB_BAUD_ERROR) ? LTE_SUCCESS : LTE_ERROR;
+}
+
 /**
  * @brief reset LTE module -> AT command port can take upward of 30 seconds to re-initialize
  *
@@ -355,6 +785,11 @@ lib_lte_result_E lib_lte_get_sim_status(void) {
  */
 lib_lte_result_E lib_lte_reset_module(void) {
     lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_RESET_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+    lte_state.network_attached = false;
+    lib_lte_http_session_forget();
+    lib_lte_socket_forget_all();
+    /* module comes back up at its power on rate */
+    lib_baud_module_reset(&lte_baud);
     /* delay for 500 ms to allow reset to execute on module */
     vTaskDelay(pdMS_TO_TICKS(LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*4));
     lib_lte_get_sim_status();
@@ -373,6 +808,11 @@ lib_lte_result_E lib_lte_reset_module(void) {
 #if (LIB_LTE_AT_PORT_ECHO_RESPONSE == 0)
     lib_lte_execute_cmd(LIB_LTE_ECHO_OFF_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
 #endif
+
+    /* climb back to the fastest rate the link held before the reset */
+    if (ret == LTE_SUCCESS) {
+        ret = lib_lte_negotiate_baud();
+    }
     return ret;
 }
 
@@ -384,14 +824,12 @@ lib_lte_result_E lib_lte_reset_module(void) {
  */
 lib_lte_result_E lib_lte_get_signal_strength(alt_u8* rssi) {
     /* prepare buffers */
-    alt_u8* rxbuf = pvPortMalloc(LIB_LTE_RX_BUF_SIZE_SMALL);
-    memset(rxbuf, 0, LIB_LTE_RX_BUF_SIZE_SMALL);
+    alt_u8 rxbuf[LIB_LTE_RX_BUF_SIZE_SMALL] = {0};
     alt_u8 ber;
 
     /* execute command, check that response can be read from reported RSSI */
     lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_RSSI_CMD, NULL, rxbuf, LIB_LTE_RX_BUF_SIZE_SMALL - 1, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
     if (ret != LTE_SUCCESS) {
-        vPortFree(rxbuf);
         return ret;
     }
 
@@ -406,7 +844,6 @@ lib_lte_result_E lib_lte_get_signal_strength(alt_u8* rssi) {
         token = strtok(NULL, LIB_LTE_RSSI_CMD.cmd);
     }
 
-    vPortFree(rxbuf);
     return ret;
 }
 
@@ -443,7 +880,11 @@ lib_lte_result_E lib_lte_set_apn(void) {
  * @return lib_lte_result_E
  */
 lib_lte_result_E lib_lte_attach_to_network(void) {
-    return lib_lte_execute_cmd(LIB_LTE_NETWORK_ATTACH_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*5);
+    lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_NETWORK_ATTACH_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*5);
+    if (ret == LTE_SUCCESS) {
+        lte_state.network_attached = true;
+    }
+    return ret;
 }
 
 /**
@@ -452,11 +893,39 @@ lib_lte_result_E lib_lte_attach_to_network(void) {
  * @return lib_lte_result_E
  */
 lib_lte_result_E lib_lte_detach_from_network(void) {
-    return lib_lte_execute_cmd(LIB_LTE_NETWORK_DETACH_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+    lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_NETWORK_DETACH_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+    if (ret == LTE_SUCCESS) {
+        lte_state.network_attached = false;
+    }
+    return ret;
+}
+
+/**
+ * @brief check the PDP context without talking to the module, the URC dispatcher tracks it as the network reports
+ *        changes
+ *
+ * @return true if the module is attached
+ */
+bool lib_lte_network_attached(void) {
+    return lte_state.network_attached;
 }
 
 /**
- * @brief setup http connection with server
+ * @brief route module output that does not belong to a pending command to a handler. Lines starting with prefix are
+ *        passed to handler from the URC dispatcher task, keep handlers short and never issue commands from them.
+ *
+ * @param prefix line prefix, ie "+SHREQ: ", must stay valid
+ * @param handler line handler
+ * @param ctx passed to the handler
+ * @return lib_lte_result_E LTE_ERROR if the handler table is full
+ */
+lib_lte_result_E lib_lte_register_urc(const char* prefix, lib_urc_handler handler, void* ctx) {
+    return (lib_urc_register(&lte_urc, prefix, handler, ctx) == LIB_URC_SUCCESS) ? LTE_SUCCESS : LTE_ERROR;
+}
+
+/**
+ * @brief setup http connection with server, only parameters that differ from what the module already holds are sent.
+ *        The module only takes new parameters while disconnected, so a change ends the current connection first.
  *
  * @param addr URL of server to connect to
  * @param hdr_size size of header
@@ -465,37 +934,51 @@ lib_lte_result_E lib_lte_detach_from_network(void) {
  */
 lib_lte_result_E lib_lte_setup_http_connection(alt_u8* addr, alt_u16 hdr_size, alt_u16 body_size) {
     lib_lte_result_E res = LTE_ERROR;
+    lib_lte_http_session_S* http = (lib_lte_http_session_S*)&lte_state.http;
+    alt_u32 addr_len = strlen(addr);
+    bool url_changed = (strcmp(http->url, addr) != 0);
+    bool body_changed = (http->body_size != body_size);
+    bool hdr_changed = (http->hdr_size != hdr_size);
 
     do {
-        /* Assemble web URL in command string */
-        alt_u8* url_cmd_string = (alt_u8*)pvPortMalloc(strlen(addr)+10); // "URL","<URL>"
-        url_cmd_string[0] = '\0';
-        sprintf(url_cmd_string, "\"URL\",\"%s\"", addr);
+        if ((url_changed || body_changed || hdr_changed) && http->connected) {
+            lib_lte_end_http_connection();
+        }
 
-        if (lib_lte_execute_cmd(LIB_LTE_HTTP_CONFIGURE_CMD, url_cmd_string, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS) != LTE_SUCCESS) {
-            vPortFree(url_cmd_string);
-            break;
+        /* URL is sent in place between the quoting fragments, a URL too long to remember is sent every time */
+        if (url_changed) {
+            lib_uart_iovec_S url_args[] = {
+                {"\"URL\",\"", 7},
+                {addr, addr_len},
+                {"\"", 1}
+            };
+            http->url[0] = '\0';
+            if (lib_lte_execute_cmd_v(LIB_LTE_HTTP_CONFIGURE_CMD, url_args, 3, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS) != LTE_SUCCESS) {
+                break;
+            }
+            if (addr_len < sizeof(http->url)) {
+                memcpy(http->url, addr, addr_len + 1);
+            }
         }
-        vPortFree(url_cmd_string);
 
-        /* Assemble body and header command strings */
-        alt_u8* body_cmd_string = (alt_u8*)pvPortMalloc(24);
-        body_cmd_string[0] = '\0';
-        sprintf(body_cmd_string, "\"BODYLEN\",%u", body_size);
-        if (lib_lte_execute_cmd(LIB_LTE_HTTP_CONFIGURE_CMD, body_cmd_string, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS) != LTE_SUCCESS) {
-            vPortFree(body_cmd_string);
-            break;
+        /* body and header lengths */
+        if (body_changed) {
+            http->body_size = 0;
+            lib_uart_iovec_S len_args = {lte_args, snprintf(lte_args, sizeof(lte_args), "\"BODYLEN\",%u", body_size)};
+            if (lib_lte_execute_cmd_v(LIB_LTE_HTTP_CONFIGURE_CMD, &len_args, 1, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS) != LTE_SUCCESS) {
+                break;
+            }
+            http->body_size = body_size;
         }
-        vPortFree(body_cmd_string);
 
-        alt_u8* hdr_cmd_string = (alt_u8*)pvPortMalloc(24);
-        hdr_cmd_string[0] = '\0';
-        sprintf(hdr_cmd_string, "\"HEADERLEN\",%u", hdr_size);
-        if (lib_lte_execute_cmd(LIB_LTE_HTTP_CONFIGURE_CMD, hdr_cmd_string, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS) != LTE_SUCCESS) {
-            vPortFree(hdr_cmd_string);
-            break;
+        if (hdr_changed) {
+            http->hdr_size = 0;
+            lib_uart_iovec_S len_args = {lte_args, snprintf(lte_args, sizeof(lte_args), "\"HEADERLEN\",%u", hdr_size)};
+            if (lib_lte_execute_cmd_v(LIB_LTE_HTTP_CONFIGURE_CMD, &len_args, 1, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS) != LTE_SUCCESS) {
+                break;
+            }
+            http->hdr_size = hdr_size;
         }
-        vPortFree(hdr_cmd_string);
 
         res = LTE_SUCCESS;
     } while (0);
@@ -509,15 +992,22 @@ lib_lte_result_E lib_lte_setup_http_connection(alt_u8* addr, alt_u16 hdr_size, a
  * @return lib_lte_result_E
  */
 lib_lte_result_E lib_lte_start_http_connection(void) {
-    return lib_lte_execute_cmd(LIB_LTE_HTTP_CONN_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*10);
+    lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_HTTP_CONN_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*10);
+    if (ret == LTE_SUCCESS) {
+        lte_state.http.connected = true;
+        lte_state.http.suspect = false;
+        lte_state.http.last_used = xTaskGetTickCount();
+    }
+    return ret;
 }
 
 /**
- * @brief end existing http connection
+ * @brief end existing http connection, the session is closed even if the module did not answer
  *
  * @return lib_lte_result_E
  */
 lib_lte_result_E lib_lte_end_http_connection(void) {
+    lte_state.http.connected = false;
     return lib_lte_execute_cmd(LIB_LTE_HTTP_DISCONNECT_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
 }
 
@@ -527,7 +1017,52 @@ lib_lte_result_E lib_lte_end_http_connection(void) {
  * @return lib_lte_result_E
  */
 lib_lte_result_E lib_lte_check_http_connection(void) {
-    return lib_lte_execute_cmd(LIB_LTE_HTTP_CHECK_CONN_CMD, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+    alt_u8 rxbuf[LIB_LTE_RX_BUF_SIZE_SMALL] = {0};
+
+    /* the matcher only proves the state line arrived, the state itself is read here */
+    lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_HTTP_CHECK_CONN_CMD, NULL, rxbuf, LIB_LTE_RX_BUF_SIZE_SMALL - 1, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+    if (ret == LTE_SUCCESS) {
+        alt_u8* token = strstr(rxbuf, LIB_LTE_HTTP_CHECK_CONN_CMD.resp_prefix);
+        if ((token == NULL) || (strncmp(token + LIB_LTE_HTTP_CHECK_CONN_CMD.resp_prefix_len,
+                            LIB_LTE_CMD_HTTP_CONNECTED_RESPONSE_STRING, LIB_LTE_HTTP_CHECK_CONN_CMD.resp_len - 1) != 0)) {
+            ret = LTE_ERROR;
+        }
+    }
+    lte_state.http.connected = (ret == LTE_SUCCESS);
+    return ret;
+}
+
+/**
+ * @brief make sure there is a connection to the server, reusing the one that is already up. Unchanged parameters are
+ *        not sent again and a connection that has been idle or failed a request is checked with AT+SHSTATE? before it
+ *        is reused, so a steady state call costs at most one round trip. Dropped connections are only reconnected here.
+ *
+ * @param addr URL of server to connect to
+ * @param hdr_size size of header
+ * @param body_size size of body
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_http_session_open(alt_u8* addr, alt_u16 hdr_size, alt_u16 body_size) {
+    lib_lte_result_E res = LTE_ERROR;
+
+    do {
+        if (lib_lte_setup_http_connection(addr, hdr_size, body_size) != LTE_SUCCESS) {
+            break;
+        }
+
+        if (lte_state.http.connected && (lte_state.http.suspect ||
+                ((xTaskGetTickCount() - lte_state.http.last_used) > pdMS_TO_TICKS(LIB_LTE_HTTP_SESSION_TRUST_MS)))) {
+            lib_lte_check_http_connection();
+        }
+
+        if (!lte_state.http.connected && (lib_lte_start_http_connection() != LTE_SUCCESS)) {
+            break;
+        }
+
+        res = LTE_SUCCESS;
+    } while (0);
+
+    return res;
 }
 
 /**
@@ -568,6 +1103,90 @@ lib_lte_result_E lib_lte_write_to_http_body(alt_u8* databuffer) {
     return lib_lte_execute_cmd(LIB_LTE_HTTP_WRITE_TO_BODY_CMD, databuffer, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
 }
 
+/**
+ * @brief write a field made of several fragments to the existing http body, the fragments are streamed to the module
+ *        as they are without being joined first
+ *
+ * @param fields fragments making up the SHPARA args, ie "key", "," and the value
+ * @param count number of fragments (at most LIB_LTE_CMD_MAX_ARG_FRAGMENTS)
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_write_to_http_body_v(const lib_uart_iovec_S* fields, alt_u32 count) {
+    return lib_lte_execute_cmd_v(LIB_LTE_HTTP_WRITE_TO_BODY_CMD, fields, count, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+}
+
+/**
+ * @brief write a field with a base64 value to the existing http body, raw data is encoded straight into the UART TX
+ *        ring. The encoder carries partial groups from one field to the next, so data can be split anywhere and only
+ *        the last field is padded. It only moves on once the module took the field, a failed write is simply repeated.
+ *
+ * @param fields fragments making up the start of the SHPARA args, ie "key" and ","
+ * @param count number of fragments (at most LIB_LTE_CMD_MAX_ARG_FRAGMENTS)
+ * @param encoder encoder shared by every field of the value, its sink is supplied here
+ * @param data raw data to encode
+ * @param len number of raw bytes
+ * @param last true to pad and end the encoding with this field
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_write_to_http_body_base64(const lib_uart_iovec_S* fields, alt_u32 count,
+                                    lib_base64_ctx_S* encoder, const alt_u8* data, alt_u32 len, bool last) {
+    lib_lte_payload_S payload = {.encoder = *encoder, .data = data, .len = len, .last = last};
+
+    lib_lte_result_E res = lib_lte_execute_cmd_v(LIB_LTE_HTTP_WRITE_TO_BODY_CMD, fields, count, &payload, NULL, 0,
+                                                                                    LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+    if (res == LTE_SUCCESS) {
+        payload.encoder.sink = encoder->sink;
+        payload.encoder.sink_ctx = encoder->sink_ctx;
+        *encoder = payload.encoder;
+    }
+
+    return res;
+}
+
+/**
+ * @brief replace the existing http body with raw bytes using AT+SHBOD. Nothing is encoded, binary data goes over the
+ *        air at its real size. Set a Content-Type header that matches before posting.
+ *
+ * @param data raw body
+ * @param len number of bytes, at most the body size the connection was set up with
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_write_to_http_body_binary(const alt_u8* data, alt_u32 len) {
+    lib_uart_iovec_S field = {lte_args, snprintf(lte_args, sizeof(lte_args), "%u,%u", (unsigned int)len,
+                                                                                LIB_LTE_HTTP_BODY_INPUT_TIMEOUT_MS)};
+    lib_uart_iovec_S body = {data, len};
+    return lib_lte_execute_cmd_data(LIB_LTE_HTTP_WRITE_BINARY_BODY_CMD, &field, 1, &body, 1,
+                                                                                LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*2);
+}
+
+/**
+ * @brief add a Content-Type header matching a locally built body, once per cleared header is enough for any number of
+ *        bodies of the same type
+ *
+ * @param body body the header describes
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_write_http_content_type(const lib_http_body_S* body) {
+    lib_uart_iovec_S args[] = {
+        {"\"Content-Type\",\"", 16},
+        {body->content_type, strlen(body->content_type)},
+        {"\"", 1}
+    };
+    return lib_lte_execute_cmd_v(LIB_LTE_HTTP_WRITE_TO_HEADER_CMD, args, 3, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+}
+
+/**
+ * @brief replace the existing http body with a locally built one in a single AT+SHBOD transfer, one round trip no
+ *        matter how many fields it holds. The body is finished first, a failed transfer can simply be repeated.
+ *
+ * @param body body to send, at most the body size the connection was set up with
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_write_http_body(lib_http_body_S* body) {
+    alt_u32 len = lib_http_body_finish(body);
+    return lib_lte_write_to_http_body_binary(body->buf, len);
+}
+
 /**
  * @brief post data to server via http (uses already set up connection)
  *
@@ -577,20 +1196,19 @@ lib_lte_result_E lib_lte_write_to_http_body(alt_u8* databuffer) {
  */
 lib_lte_result_E lib_lte_post_http_request(alt_u8* endpoint, alt_u16* response_code, alt_u16* resp_len) {
     /* prepare buffers */
-    alt_u8* rxbuf = pvPortMalloc(LIB_LTE_RX_BUF_SIZE_SMALL);
-    memset(rxbuf, 0, LIB_LTE_RX_BUF_SIZE_SMALL);
+    alt_u8 rxbuf[LIB_LTE_RX_BUF_SIZE_SMALL] = {0};
 
-    /* prepare command args */
-    alt_u8* txbuf = pvPortMalloc(strlen(endpoint) + 20);
-    memset(txbuf, 0, strlen(endpoint) + 10);
-    snprintf(txbuf, "\"%s\"", endpoint);
-    txbuf = strcat(txbuf, ",3");
+    /* endpoint is sent in place, 3 is the POST method */
+    lib_uart_iovec_S args[] = {
+        {"\"", 1},
+        {endpoint, strlen(endpoint)},
+        {"\",3", 3}
+    };
 
-    /* execute command */
-    lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_HTTP_POST_CMD, txbuf, rxbuf, LIB_LTE_RX_BUF_SIZE_SMALL - 1, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*2);
+    /* execute command, a failed request leaves the session to be checked before it is reused */
+    lib_lte_result_E ret = lib_lte_execute_cmd_v(LIB_LTE_HTTP_POST_CMD, args, 3, NULL, rxbuf, LIB_LTE_RX_BUF_SIZE_SMALL - 1, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*2);
     if (ret != LTE_SUCCESS) {
-        vPortFree(rxbuf);
-        vPortFree(txbuf);
+        lte_state.http.suspect = true;
         return ret;
     }
 
@@ -617,8 +1235,11 @@ lib_lte_result_E lib_lte_post_http_request(alt_u8* endpoint, alt_u16* response_c
         }
     }
 
-    vPortFree(rxbuf);
-    vPortFree(txbuf);
+    if (ret == LTE_SUCCESS) {
+        lte_state.http.last_used = xTaskGetTickCount();
+    } else {
+        lte_state.http.suspect = true;
+    }
     return ret;
 }
 
@@ -632,15 +1253,191 @@ lib_lte_result_E lib_lte_post_http_request(alt_u8* endpoint, alt_u16* response_c
  * @return lib_lte_result_E
  */
 lib_lte_result_E lib_lte_get_http_response_data(alt_u16 length, alt_u16 start_addr, alt_u8* databuffer, alt_u16 data_size) {
-    /* Assemble web URL in command string */
-    alt_u8* cmd_string = (alt_u8*)pvPortMalloc(40); // 0,length
-    cmd_string[0] = '\0';
-    sprintf(cmd_string, "%u,%u", start_addr, length);
-    lib_lte_result_E ret = lib_lte_execute_cmd(LIB_LTE_HTTP_READ_RESP_CMD, cmd_string, databuffer, data_size, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
-    vPortFree(cmd_string);
+    lib_uart_iovec_S args = {lte_args, snprintf(lte_args, sizeof(lte_args), "%u,%u", start_addr, length)};
+    return lib_lte_execute_cmd_v(LIB_LTE_HTTP_READ_RESP_CMD, &args, 1, NULL, databuffer, data_size, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+}
+
+/**
+ * @brief open a raw TCP connection with AT+CAOPEN on the attached PDP context. Received data waits in the module and
+ *        is announced with +CADATAIND, read it with lib_lte_socket_recv.
+ *
+ * @param cid connection id, below LIB_LTE_SOCKET_COUNT
+ * @param host server address
+ * @param port server port
+ * @return lib_lte_result_E LTE_ERROR if the module could not connect
+ */
+lib_lte_result_E lib_lte_socket_open(alt_u8 cid, const char* host, alt_u16 port) {
+    lib_lte_result_E ret = LTE_ERROR;
+    alt_u8 rxbuf[LIB_LTE_RX_BUF_SIZE_SMALL] = {0};
+
+    do {
+        if (cid >= LIB_LTE_SOCKET_COUNT) {
+            break;
+        }
+
+        /* the module refuses to open a connection id that is still in use */
+        if (lte_state.sockets[cid].connected) {
+            lib_lte_socket_close(cid);
+        }
+        lte_state.sockets[cid].readable = false;
+
+        /* <cid>,<pdp>,"TCP","<host>",<port>, host is sent in place */
+        char cid_str[8];
+        char port_str[8];
+        lib_uart_iovec_S args[] = {
+            {cid_str, snprintf(cid_str, sizeof(cid_str), "%u,0,", cid)},
+            {"\"TCP\",\"", 7},
+            {host, strlen(host)},
+            {port_str, snprintf(port_str, sizeof(port_str), "\",%u", port)}
+        };
+        if (lib_lte_execute_cmd_v(LIB_LTE_SOCKET_OPEN_CMD, args, 4, NULL, rxbuf, LIB_LTE_RX_BUF_SIZE_SMALL - 1,
+                                                                    LIB_LTE_SOCKET_OPEN_TIMEOUT_MS) != LTE_SUCCESS) {
+            break;
+        }
+
+        /* +CAOPEN: <cid>,<result>, anything but 0 is a failed connect */
+        alt_u8* token = strstr(rxbuf, LIB_LTE_SOCKET_OPEN_CMD.resp_prefix);
+        unsigned int resp_cid;
+        unsigned int result;
+        if ((token == NULL) || (sscanf(token + LIB_LTE_SOCKET_OPEN_CMD.resp_prefix_len, "%u,%u", &resp_cid, &result) != 2) ||
+                                                                                (resp_cid != cid) || (result != 0)) {
+            break;
+        }
+
+        lte_state.sockets[cid].connected = true;
+        ret = LTE_SUCCESS;
+    } while (0);
+
+    return ret;
+}
+
+/**
+ * @brief send raw bytes on an open socket with AT+CASEND, the fragments follow the prompt back to back without being
+ *        joined first, ie a protocol header and the payload it describes
+ *
+ * @param cid connection id
+ * @param data fragments to send
+ * @param count number of fragments
+ * @return lib_lte_result_E LTE_ERROR if the socket is closed or the total is over LIB_LTE_SOCKET_SEND_MAX
+ */
+lib_lte_result_E lib_lte_socket_send_v(alt_u8 cid, const lib_uart_iovec_S* data, alt_u32 count) {
+    alt_u32 len = 0;
+    for (alt_u32 i = 0; i < count; i++) {
+        len += data[i].len;
+    }
+    if ((cid >= LIB_LTE_SOCKET_COUNT) || !lte_state.sockets[cid].connected || (len == 0) ||
+                                                                                    (len > LIB_LTE_SOCKET_SEND_MAX)) {
+        return LTE_ERROR;
+    }
+
+    lib_uart_iovec_S args = {lte_args, snprintf(lte_args, sizeof(lte_args), "%u,%u,%u", cid, (unsigned int)len,
+                                                                                LIB_LTE_SOCKET_INPUT_TIMEOUT_MS)};
+    return lib_lte_execute_cmd_data(LIB_LTE_SOCKET_SEND_CMD, &args, 1, data, count, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*2);
+}
+
+/**
+ * @brief send raw bytes on an open socket with AT+CASEND
+ *
+ * @param cid connection id
+ * @param data bytes to send
+ * @param len number of bytes, at most LIB_LTE_SOCKET_SEND_MAX
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_socket_send(alt_u8 cid, const alt_u8* data, alt_u32 len) {
+    lib_uart_iovec_S iov = {data, len};
+    return lib_lte_socket_send_v(cid, &iov, 1);
+}
+
+/**
+ * @brief read data the module has received on a socket with AT+CARECV. The data travels inside the command response,
+ *        a payload that holds a bare OK or ERROR line would end the response early, so keep binary replies short.
+ *
+ * @param cid connection id
+ * @param buf output buffer
+ * @param size output buffer size, at most LIB_LTE_SOCKET_RECV_MAX bytes are read per call
+ * @param len output number of bytes read, 0 if nothing was waiting
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_socket_recv(alt_u8 cid, alt_u8* buf, alt_u32 size, alt_u32* len) {
+    lib_lte_result_E ret = LTE_ERROR;
+    alt_u8 rxbuf[LIB_LTE_RX_BUF_SIZE_SOCKET] = {0};
+    alt_u32 want = (size < LIB_LTE_SOCKET_RECV_MAX) ? size : LIB_LTE_SOCKET_RECV_MAX;
+
+    *len = 0;
+    do {
+        if ((cid >= LIB_LTE_SOCKET_COUNT) || (want == 0)) {
+            break;
+        }
+
+        /* clear before asking, data that arrives after the read is announced again */
+        lte_state.sockets[cid].readable = false;
+        lib_uart_iovec_S args = {lte_args, snprintf(lte_args, sizeof(lte_args), "%u,%u", cid, (unsigned int)want)};
+        if (lib_lte_execute_cmd_v(LIB_LTE_SOCKET_RECV_CMD, &args, 1, NULL, rxbuf, LIB_LTE_RX_BUF_SIZE_SOCKET - 1,
+                                                                        LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS) != LTE_SUCCESS) {
+            break;
+        }
+
+        /* +CARECV: <len>[,<data>], the prefix comes before any binary data so a string search finds it */
+        alt_u8* token = strstr(rxbuf, LIB_LTE_SOCKET_RECV_CMD.resp_prefix);
+        if (token == NULL) {
+            break;
+        }
+        char* data;
+        alt_u32 got = strtoul(token + LIB_LTE_SOCKET_RECV_CMD.resp_prefix_len, &data, 10);
+        if ((got > want) || ((got != 0) && ((*data != ',') ||
+                                            ((alt_u8*)data + 1 + got) > (rxbuf + LIB_LTE_RX_BUF_SIZE_SOCKET - 1)))) {
+            break;
+        }
+        memcpy(buf, data + 1, got);
+        *len = got;
+
+        /* a full read can leave more behind, the module only announces new arrivals */
+        if (got == want) {
+            lte_state.sockets[cid].readable = true;
+        }
+        ret = LTE_SUCCESS;
+    } while (0);
+
     return ret;
 }
 
+/**
+ * @brief close a socket with AT+CACLOSE, the socket is forgotten even if the module did not answer
+ *
+ * @param cid connection id
+ * @return lib_lte_result_E
+ */
+lib_lte_result_E lib_lte_socket_close(alt_u8 cid) {
+    if (cid >= LIB_LTE_SOCKET_COUNT) {
+        return LTE_ERROR;
+    }
+    lte_state.sockets[cid].connected = false;
+    lte_state.sockets[cid].readable = false;
+
+    lib_uart_iovec_S args = {lte_args, snprintf(lte_args, sizeof(lte_args), "%u", cid)};
+    return lib_lte_execute_cmd_v(LIB_LTE_SOCKET_CLOSE_CMD, &args, 1, NULL, NULL, 0, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS);
+}
+
+/**
+ * @brief check a socket without talking to the module, the URC dispatcher notices when the remote end closes it
+ *
+ * @param cid connection id
+ * @return true if the socket is open
+ */
+bool lib_lte_socket_connected(alt_u8 cid) {
+    return (cid < LIB_LTE_SOCKET_COUNT) && lte_state.sockets[cid].connected;
+}
+
+/**
+ * @brief check for received data without talking to the module, set from +CADATAIND
+ *
+ * @param cid connection id
+ * @return true if data is waiting to be read with lib_lte_socket_recv
+ */
+bool lib_lte_socket_readable(alt_u8 cid) {
+    return (cid < LIB_LTE_SOCKET_COUNT) && lte_state.sockets[cid].readable;
+}
+
 /**
  * @brief turn ON GPS power to the module - Note that GPS and LTE do not run properly at the same time
  *
@@ -668,13 +1465,11 @@ lib_lte_result_E lib_lte_turn_off_gps(void) {
  */
 lib_lte_result_E lib_lte_read_gps(alt_u8* lat, alt_u8* longi) {
     /* prepare buffers */
-    alt_u8* rxbuf = pvPortMalloc(LIB_LTE_RX_BUF_SIZE_GPS_PAYLOAD);
-    memset(rxbuf, 0, LIB_LTE_RX_BUF_SIZE_GPS_PAYLOAD);
+    alt_u8 rxbuf[LIB_LTE_RX_BUF_SIZE_GPS_PAYLOAD] = {0};
 
     /* execute command - 10s timeout because GPS can take a long time to respond */
     lib_lte_result_E ret = lib_lte_execute_cmd(LIT_LTE_GPS_GET_LOCATION_CMD, NULL, rxbuf, LIB_LTE_RX_BUF_SIZE_GPS_PAYLOAD - 1, LIB_LTE_AT_DEFAULT_CMD_TIMEOUT_MS*10);
     if (ret != LTE_SUCCESS) {
-        vPortFree(rxbuf);
         return ret;
     }
 
@@ -697,6 +1492,5 @@ lib_lte_result_E lib_lte_read_gps(alt_u8* lat, alt_u8* longi) {
         }
     }
 
-    vPortFree(rxbuf);
     return ret;
 }
@@ -14,9 +14,16 @@
 #include "system.h"
 #include "alt_types.h"
 #include "lib_lte_cmd.h"
+#include "lib_uart.h"
+#include "lib_base64.h"
+#include "lib_urc.h"
+#include "lib_http_body.h"
 
 /* public defines */
 #define LIB_LTE_RSSI_INVALID 99
+#define LIB_LTE_SOCKET_COUNT 2 // connection ids tracked, the module has more but only these are used
+#define LIB_LTE_SOCKET_SEND_MAX 1460 // AT+CASEND limit, one TCP segment
+#define LIB_LTE_SOCKET_RECV_MAX 256 // AT+CARECV bytes per read, has to fit the response buffer with its framing
 
 /* public types */
 
@@ -34,21 +41,39 @@ lib_lte_result_E lib_lte_power_state_on(volatile unsigned int* GPIO_BASE);
 lib_lte_result_E lib_lte_reset_module(void);
 lib_lte_result_E lib_lte_get_signal_strength(alt_u8* rssi);
 lib_lte_result_E lib_lte_get_sim_status(void);
+lib_lte_result_E lib_lte_negotiate_baud(void);
+lib_lte_result_E lib_lte_check_baud(void);
 lib_lte_result_E lib_lte_turn_off_radio(void);
 lib_lte_result_E lib_lte_turn_on_radio(void);
 lib_lte_result_E lib_lte_set_apn(void);
 lib_lte_result_E lib_lte_attach_to_network(void);
 lib_lte_result_E lib_lte_detach_from_network(void);
+bool lib_lte_network_attached(void);
+lib_lte_result_E lib_lte_register_urc(const char* prefix, lib_urc_handler handler, void* ctx);
 lib_lte_result_E lib_lte_setup_http_connection(alt_u8* addr, alt_u16 hdr_size, alt_u16 body_size);
 lib_lte_result_E lib_lte_start_http_connection(void);
 lib_lte_result_E lib_lte_end_http_connection(void);
 lib_lte_result_E lib_lte_check_http_connection(void);
+lib_lte_result_E lib_lte_http_session_open(alt_u8* addr, alt_u16 hdr_size, alt_u16 body_size);
 lib_lte_result_E lib_lte_clear_http_header(void);
 lib_lte_result_E lib_lte_write_to_http_header(alt_u8* databuffer);
 lib_lte_result_E lib_lte_clear_http_body(void);
 lib_lte_result_E lib_lte_write_to_http_body(alt_u8* databuffer);
+lib_lte_result_E lib_lte_write_to_http_body_v(const lib_uart_iovec_S* fields, alt_u32 count);
+lib_lte_result_E lib_lte_write_to_http_body_base64(const lib_uart_iovec_S* fields, alt_u32 count,
+                                    lib_base64_ctx_S* encoder, const alt_u8* data, alt_u32 len, bool last);
+lib_lte_result_E lib_lte_write_to_http_body_binary(const alt_u8* data, alt_u32 len);
+lib_lte_result_E lib_lte_write_http_content_type(const lib_http_body_S* body);
+lib_lte_result_E lib_lte_write_http_body(lib_http_body_S* body);
 lib_lte_result_E lib_lte_post_http_request(alt_u8* endpoint, alt_u16* response_code, alt_u16* resp_len);
 lib_lte_result_E lib_lte_get_http_response_data(alt_u16 length, alt_u16 start_addr, alt_u8* databuffer, alt_u16 data_size);
+lib_lte_result_E lib_lte_socket_open(alt_u8 cid, const char* host, alt_u16 port);
+lib_lte_result_E lib_lte_socket_send_v(alt_u8 cid, const lib_uart_iovec_S* data, alt_u32 count);
+lib_lte_result_E lib_lte_socket_send(alt_u8 cid, const alt_u8* data, alt_u32 len);
+lib_lte_result_E lib_lte_socket_recv(alt_u8 cid, alt_u8* buf, alt_u32 size, alt_u32* len);
+lib_lte_result_E lib_lte_socket_close(alt_u8 cid);
+bool lib_lte_socket_connected(alt_u8 cid);
+bool lib_lte_socket_readable(alt_u8 cid);
 lib_lte_result_E lib_lte_turn_on_gps(void);
 lib_lte_result_E lib_lte_turn_off_gps(void);
 lib_lte_result_E lib_lte_read_gps(alt_u8* lat, alt_u8* longi);
@@ -23,36 +23,41 @@ const char LIB_LTE_CMD_RESP_OK[] = {"\r\nOK\r\n"};
 const char LIB_LTE_CMD_RESP_ERROR[] = {"\r\nERROR\r\n"};
 
 /* Command strings */
-const char LIB_LTE_CMD_RESET_STRING[] = {"+CFUN"};
-const char LIB_LTE_CMD_SIM_STATUS_STRING[] = {"+CPIN"};
-const char LIB_LTE_CMD_RSSI_STRING[] = {"+CSQ"};
-const char LIB_LTE_CMD_RADIO_STRING[] = {"+CFUN"};
-const char LIB_LTE_CMD_APN_STRING[] = {"+CNCFG"};
-const char LIB_LTE_CMD_NETWORK_STRING[] = {"+CNACT"};
-const char LIB_LTE_HTTP_CONFIG_STRING[] = {"+SHCONF"};
-const char LIB_LTE_HTTP_CONNECT_STRING[] = {"+SHCONN"};
-const char LIB_LTE_HTTP_STATE_STRING[] = {"+SHSTATE"};
-const char LIB_LTE_HTTP_CLEAR_HDR_STRING[] = {"+SHCHEAD"};
-const char LIB_LTE_HTTP_CLEAR_BDY_STRING[] = {"+SHCPARA"};
-const char LIB_LTE_HTTP_WRITE_HDR_STRING[] = {"+SHAHEAD"};
-const char LIB_LTE_HTTP_WRITE_BDY_STRING[] = {"+SHPARA"};
-const char LIB_LTE_HTTP_POST_STRING[] = {"+SHREQ"};
-const char LIB_LTE_HTTP_READ_RESPONSE_STRING[] = {"+SHREAD"};
-const char LIB_LTE_HTTP_DISCONNECT_STRING[] = {"+SHDISC"};
-const char LIB_LTE_GPS_PWR_STRING[] = {"+CGNSPWR"};
-const char LIB_LTE_GPS_DATA_STRING[] = {"+CGNSINF"};
-const char LIB_LTE_CMD_ECHO_OFF[] = {"E0"};
+#define LIB_LTE_CMD_RESET_STRING "+CFUN"
+#define LIB_LTE_CMD_SIM_STATUS_STRING "+CPIN"
+#define LIB_LTE_CMD_RSSI_STRING "+CSQ"
+#define LIB_LTE_CMD_RADIO_STRING "+CFUN"
+#define LIB_LTE_CMD_APN_STRING "+CNCFG"
+#define LIB_LTE_CMD_NETWORK_STRING "+CNACT"
+#define LIB_LTE_HTTP_CONFIG_STRING "+SHCONF"
+#define LIB_LTE_HTTP_CONNECT_STRING "+SHCONN"
+#define LIB_LTE_HTTP_STATE_STRING "+SHSTATE"
+#define LIB_LTE_HTTP_CLEAR_HDR_STRING "+SHCHEAD"
+#define LIB_LTE_HTTP_CLEAR_BDY_STRING "+SHCPARA"
+#define LIB_LTE_HTTP_WRITE_HDR_STRING "+SHAHEAD"
+#define LIB_LTE_HTTP_WRITE_BDY_STRING "+SHPARA"
+#define LIB_LTE_HTTP_WRITE_BINARY_BDY_STRING "+SHBOD"
+#define LIB_LTE_HTTP_POST_STRING "+SHREQ"
+#define LIB_LTE_HTTP_READ_RESPONSE_STRING "+SHREAD"
+#define LIB_LTE_HTTP_DISCONNECT_STRING "+SHDISC"
+#define LIB_LTE_SOCKET_OPEN_STRING "+CAOPEN"
+#define LIB_LTE_SOCKET_SEND_STRING "+CASEND"
+#define LIB_LTE_SOCKET_RECV_STRING "+CARECV"
+#define LIB_LTE_SOCKET_CLOSE_STRING "+CACLOSE"
+#define LIB_LTE_GPS_PWR_STRING "+CGNSPWR"
+#define LIB_LTE_GPS_DATA_STRING "+CGNSINF"
+#define LIB_LTE_CMD_ECHO_OFF "E0"
+#define LIB_LTE_CMD_BAUD_STRING "+IPR"
 
 /* Command arg strings */
-const char LIB_LTE_RESET_ARGS_STRING[] = {"1,1"};
-const char LIB_LTE_RADIO_ON_ARGS_STRING[] = {"1"};
-const char LIB_LTE_RADIO_OFF_ARGS_STRING[] = {"0"};
-const char LIB_LTE_TELUS_APN_ARGS_STRING[] = {"0,1,\"m2m.telus.iot\""};
-const char LIB_LTE_NETWORK_ATTACH_ARGS_STRING[] = {"0,1"};
-const char LIB_LTE_NETWORK_DETACH_ARGS_STRING[] = {"0,0"};
-const char LIB_LTE_HTTP_POST_ARGS_STRING[] = {"\"/checkFace\",3"};
-const char LIB_LTE_GPS_ON_ARGS_STRING[] = {"1"};
-const char LIB_LTE_GPS_OFF_ARGS_STRING[] = {"0"};
+#define LIB_LTE_RESET_ARGS_STRING "1,1"
+#define LIB_LTE_RADIO_ON_ARGS_STRING "1"
+#define LIB_LTE_RADIO_OFF_ARGS_STRING "0"
+#define LIB_LTE_TELUS_APN_ARGS_STRING "0,1,\"m2m.telus.iot\""
+#define LIB_LTE_NETWORK_ATTACH_ARGS_STRING "0,1"
+#define LIB_LTE_NETWORK_DETACH_ARGS_STRING "0,0"
+#define LIB_LTE_GPS_ON_ARGS_STRING "1"
+#define LIB_LTE_GPS_OFF_ARGS_STRING "0"
 
 /* Command response strings */
 const char LIB_LTE_SIM_STATUS_RESPONSE_STRING[] = {"READY"};
@@ -64,239 +69,135 @@ const char LIB_LTE_CMD_HTTP_POST_RESPONSE_STRING[] = {": \"POST\",%3s,%3s"};
 const char LIB_LTE_CMD_HTTP_READ_DATA_RESPONSE_STRING[] = {"*\r\n"}; /* STOP character from server */
 const char LIB_LTE_GPS_DATA_RESPONSE_STRING[] = {": 1,1,%18s,%9s,%11s,%*[^0123456789]"};
 
+/* Command spec - the preprocessor renders the request bytes and the <cmd>: response prefix from the command literal,
+ * so sending a command or building its matcher never formats anything */
+#define LIB_LTE_SPEC(cmd_str, request_str, resp_str, resp_size, type, formatted) { \
+    .cmd = cmd_str, \
+    .cmd_len = sizeof(cmd_str), \
+    .request = request_str, \
+    .request_len = sizeof(request_str) - 1, \
+    .resp_prefix = cmd_str ": ", \
+    .resp_prefix_len = sizeof(cmd_str ": ") - 1, \
+    .response_str = resp_str, \
+    .resp_len = resp_size, \
+    .resp_type = type, \
+    .formatted_args = formatted}
+
+/* AT<cmd>\r */
+#define LIB_LTE_SPEC_EXEC(cmd_str, resp_str, resp_size, type) \
+    LIB_LTE_SPEC(cmd_str, "AT" cmd_str "\r", resp_str, resp_size, type, false)
+/* AT<cmd>?\r */
+#define LIB_LTE_SPEC_QUERY(cmd_str, resp_str, resp_size, type) \
+    LIB_LTE_SPEC(cmd_str, "AT" cmd_str "?\r", resp_str, resp_size, type, false)
+/* AT<cmd>=<args>\r */
+#define LIB_LTE_SPEC_SET(cmd_str, args_str, resp_str, resp_size, type) \
+    LIB_LTE_SPEC(cmd_str, "AT" cmd_str "=" args_str "\r", resp_str, resp_size, type, false)
+/* AT<cmd>= then the args formatted by the caller and the footer */
+#define LIB_LTE_SPEC_FORMATTED(cmd_str, resp_str, resp_size, type) \
+    LIB_LTE_SPEC(cmd_str, "AT" cmd_str "=", resp_str, resp_size, type, true)
+
 /* Command definitions */
 
 /* status commands */
-const lib_lte_cmd_type_E LIB_LTE_RESET_CMD = {.cmd = LIB_LTE_CMD_RESET_STRING,
-                                            .cmd_len = sizeof(LIB_LTE_CMD_RESET_STRING),
-                                            .cmd_args = LIB_LTE_RESET_ARGS_STRING,
-                                            .args_len = sizeof(LIB_LTE_RESET_ARGS_STRING),
-                                            .response_str = NULL,
-                                            .resp_len = 0,
-                                            .is_query = false,
-                                            .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                            .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_SIM_STATUS_CMD = {.cmd = LIB_LTE_CMD_SIM_STATUS_STRING,
-                                                .cmd_len = sizeof(LIB_LTE_CMD_SIM_STATUS_STRING),
-                                                .cmd_args = NULL,
-                                                .args_len = 0,
-                                                .response_str = LIB_LTE_SIM_STATUS_RESPONSE_STRING,
-                                                .resp_len = sizeof(LIB_LTE_SIM_STATUS_RESPONSE_STRING),
-                                                .is_query = true,
-                                                .resp_type = LIB_LTE_RESP_TYPE_STRING,
-                                                .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_RSSI_CMD = {.cmd = LIB_LTE_CMD_RSSI_STRING,
-                                            .cmd_len = sizeof(LIB_LTE_CMD_RSSI_STRING),
-                                            .cmd_args = NULL,
-                                            .args_len = 0,
-                                            .response_str = NULL,
-                                            .resp_len = 0,
-                                            .is_query = false,
-                                            .resp_type = LIB_LTE_RESP_TYPE_STRING,
-                                            .formatted_args = false};
-
-
-const lib_lte_cmd_type_E LIB_LTE_ECHO_OFF_CMD = {.cmd = LIB_LTE_CMD_ECHO_OFF,
-                                            .cmd_len = sizeof(LIB_LTE_CMD_ECHO_OFF),
-                                            .cmd_args = NULL,
-                                            .args_len = 0,
-                                            .response_str = NULL,
-                                            .resp_len = 0,
-                                            .is_query = false,
-                                            .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                            .formatted_args = false};
+const lib_lte_cmd_type_E LIB_LTE_RESET_CMD = LIB_LTE_SPEC_SET(LIB_LTE_CMD_RESET_STRING, LIB_LTE_RESET_ARGS_STRING,
+                                                                                NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_SIM_STATUS_CMD = LIB_LTE_SPEC_QUERY(LIB_LTE_CMD_SIM_STATUS_STRING,
+                                                        LIB_LTE_SIM_STATUS_RESPONSE_STRING,
+                                                        sizeof(LIB_LTE_SIM_STATUS_RESPONSE_STRING),
+                                                        LIB_LTE_RESP_TYPE_STRING);
+
+const lib_lte_cmd_type_E LIB_LTE_RSSI_CMD = LIB_LTE_SPEC_EXEC(LIB_LTE_CMD_RSSI_STRING, NULL, 0, LIB_LTE_RESP_TYPE_STRING);
+
+const lib_lte_cmd_type_E LIB_LTE_ECHO_OFF_CMD = LIB_LTE_SPEC_EXEC(LIB_LTE_CMD_ECHO_OFF, NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_SET_BAUD_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_CMD_BAUD_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
 
 
 /* network commands */
-const lib_lte_cmd_type_E LIB_LTE_RADIO_OFF_CMD = {.cmd = LIB_LTE_CMD_RADIO_STRING,
-                                                .cmd_len = sizeof(LIB_LTE_CMD_RADIO_STRING),
-                                                .cmd_args = LIB_LTE_RADIO_OFF_ARGS_STRING,
-                                                .args_len = sizeof(LIB_LTE_RADIO_OFF_ARGS_STRING),
-                                                .response_str = NULL,
-                                                .resp_len = 0,
-                                                .is_query = false,
-                                                .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_RADIO_ON_CMD = {.cmd = LIB_LTE_CMD_RADIO_STRING,
-                                                .cmd_len = sizeof(LIB_LTE_CMD_RADIO_STRING),
-                                                .cmd_args = LIB_LTE_RADIO_ON_ARGS_STRING,
-                                                .args_len = sizeof(LIB_LTE_RADIO_ON_ARGS_STRING),
-                                                .response_str = NULL,
-                                                .resp_len = 0,
-                                                .is_query = false,
-                                                .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_SET_APN_CMD = {.cmd = LIB_LTE_CMD_APN_STRING,
-                                                .cmd_len = sizeof(LIB_LTE_CMD_APN_STRING),
-                                                .cmd_args = LIB_LTE_TELUS_APN_ARGS_STRING,
-                                                .args_len = sizeof(LIB_LTE_TELUS_APN_ARGS_STRING),
-                                                .response_str = NULL,
-                                                .resp_len = 0,
-                                                .is_query = false,
-                                                .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_NETWORK_ATTACH_CMD = {.cmd = LIB_LTE_CMD_NETWORK_STRING,
-                                                        .cmd_len = sizeof(LIB_LTE_CMD_NETWORK_STRING),
-                                                        .cmd_args = LIB_LTE_NETWORK_ATTACH_ARGS_STRING,
-                                                        .args_len = sizeof(LIB_LTE_NETWORK_ATTACH_ARGS_STRING),
-                                                        .response_str = LIB_LTE_CMD_NETWORK_ATTACH_RESPONSE_STRING,
-                                                        .resp_len = sizeof(LIB_LTE_CMD_NETWORK_ATTACH_RESPONSE_STRING),
-                                                        .is_query = false,
-                                                        .resp_type = LIB_LTE_RESP_TYPE_ASYNC,
-                                                        .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_NETWORK_DETACH_CMD = {.cmd = LIB_LTE_CMD_NETWORK_STRING,
-                                                        .cmd_len = sizeof(LIB_LTE_CMD_NETWORK_STRING),
-                                                        .cmd_args = LIB_LTE_NETWORK_DETACH_ARGS_STRING,
-                                                        .args_len = sizeof(LIB_LTE_NETWORK_DETACH_ARGS_STRING),
-                                                        .response_str = LIB_LTE_CMD_NETWORK_DETACH_RESPONSE_STRING,
-                                                        .resp_len = sizeof(LIB_LTE_CMD_NETWORK_DETACH_RESPONSE_STRING),
-                                                        .is_query = false,
-                                                        .resp_type = LIB_LTE_RESP_TYPE_ASYNC,
-                                                        .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_NETWORK_LOCAL_IP_CMD = {.cmd = LIB_LTE_CMD_NETWORK_STRING,
-                                                        .cmd_len = sizeof(LIB_LTE_CMD_NETWORK_STRING),
-                                                        .cmd_args = NULL,
-                                                        .args_len = 0,
-                                                        .response_str = NULL,
-                                                        .resp_len = 0,
-                                                        .is_query = true,
-                                                        .resp_type = LIB_LTE_RESP_TYPE_STRING,
-                                                        .formatted_args = false};
+const lib_lte_cmd_type_E LIB_LTE_RADIO_OFF_CMD = LIB_LTE_SPEC_SET(LIB_LTE_CMD_RADIO_STRING, LIB_LTE_RADIO_OFF_ARGS_STRING,
+                                                                                NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_RADIO_ON_CMD = LIB_LTE_SPEC_SET(LIB_LTE_CMD_RADIO_STRING, LIB_LTE_RADIO_ON_ARGS_STRING,
+                                                                                NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_SET_APN_CMD = LIB_LTE_SPEC_SET(LIB_LTE_CMD_APN_STRING, LIB_LTE_TELUS_APN_ARGS_STRING,
+                                                                                NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_NETWORK_ATTACH_CMD = LIB_LTE_SPEC_SET(LIB_LTE_CMD_NETWORK_STRING,
+                                                        LIB_LTE_NETWORK_ATTACH_ARGS_STRING,
+                                                        LIB_LTE_CMD_NETWORK_ATTACH_RESPONSE_STRING,
+                                                        sizeof(LIB_LTE_CMD_NETWORK_ATTACH_RESPONSE_STRING),
+                                                        LIB_LTE_RESP_TYPE_ASYNC);
+
+const lib_lte_cmd_type_E LIB_LTE_NETWORK_DETACH_CMD = LIB_LTE_SPEC_SET(LIB_LTE_CMD_NETWORK_STRING,
+                                                        LIB_LTE_NETWORK_DETACH_ARGS_STRING,
+                                                        LIB_LTE_CMD_NETWORK_DETACH_RESPONSE_STRING,
+                                                        sizeof(LIB_LTE_CMD_NETWORK_DETACH_RESPONSE_STRING),
+                                                        LIB_LTE_RESP_TYPE_ASYNC);
+
+const lib_lte_cmd_type_E LIB_LTE_NETWORK_LOCAL_IP_CMD = LIB_LTE_SPEC_QUERY(LIB_LTE_CMD_NETWORK_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_STRING);
 
 /* HTTP commands */
-const lib_lte_cmd_type_E LIB_LTE_HTTP_CONFIGURE_CMD = {.cmd = LIB_LTE_HTTP_CONFIG_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_CONFIG_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = true};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_CONN_CMD = {.cmd = LIB_LTE_HTTP_CONNECT_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_CONNECT_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_CHECK_CONN_CMD = {.cmd = LIB_LTE_HTTP_STATE_STRING,
-                                                        .cmd_len = sizeof(LIB_LTE_HTTP_STATE_STRING),
-                                                        .cmd_args = NULL,
-                                                        .args_len = 0,
-                                                        .response_str = LIB_LTE_CMD_HTTP_CONNECTED_RESPONSE_STRING,
-                                                        .resp_len = sizeof(LIB_LTE_CMD_HTTP_CONNECTED_RESPONSE_STRING),
-                                                        .is_query = true,
-                                                        .resp_type = LIB_LTE_RESP_TYPE_STRING,
-                                                        .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_CLEAR_HEADER_CMD = {.cmd = LIB_LTE_HTTP_CLEAR_HDR_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_CLEAR_HDR_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_CLEAR_BODY_CMD = {.cmd = LIB_LTE_HTTP_CLEAR_BDY_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_CLEAR_BDY_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_WRITE_TO_HEADER_CMD = {.cmd = LIB_LTE_HTTP_WRITE_HDR_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_WRITE_HDR_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = true};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_WRITE_TO_BODY_CMD = {.cmd = LIB_LTE_HTTP_WRITE_BDY_STRING,
-                                                        .cmd_len = sizeof(LIB_LTE_HTTP_WRITE_BDY_STRING),
-                                                        .cmd_args = NULL,
-                                                        .args_len = 0,
-                                                        .response_str = NULL,
-                                                        .resp_len = 0,
-                                                        .is_query = false,
-                                                        .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                        .formatted_args = true};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_POST_CMD = {.cmd = LIB_LTE_HTTP_POST_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_POST_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = LIB_LTE_CMD_HTTP_POST_RESPONSE_STRING,
-                                                    .resp_len = sizeof(LIB_LTE_CMD_HTTP_POST_RESPONSE_STRING),
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_STRING,
-                                                    .formatted_args = true};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_READ_RESP_CMD = {.cmd = LIB_LTE_HTTP_READ_RESPONSE_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_READ_RESPONSE_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = LIB_LTE_CMD_HTTP_READ_DATA_RESPONSE_STRING,
-                                                    .resp_len = sizeof(LIB_LTE_CMD_HTTP_READ_DATA_RESPONSE_STRING),
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_ASYNC,
-                                                    .formatted_args = true};
-
-const lib_lte_cmd_type_E LIB_LTE_HTTP_DISCONNECT_CMD = {.cmd = LIB_LTE_HTTP_DISCONNECT_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_HTTP_DISCONNECT_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
-
-const lib_lte_cmd_type_E LIT_LTE_GPS_POWER_ON_CMD = {.cmd = LIB_LTE_GPS_PWR_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_GPS_PWR_STRING),
-                                                    .cmd_args = LIB_LTE_GPS_ON_ARGS_STRING,
-                                                    .args_len = sizeof(LIB_LTE_GPS_ON_ARGS_STRING),
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
-
-const lib_lte_cmd_type_E LIT_LTE_GPS_POWER_OFF_CMD = {.cmd = LIB_LTE_GPS_PWR_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_GPS_PWR_STRING),
-                                                    .cmd_args = LIB_LTE_GPS_OFF_ARGS_STRING,
-                                                    .args_len = sizeof(LIB_LTE_GPS_OFF_ARGS_STRING),
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_BASIC,
-                                                    .formatted_args = false};
-
-const lib_lte_cmd_type_E LIT_LTE_GPS_GET_LOCATION_CMD = {.cmd = LIB_LTE_GPS_DATA_STRING,
-                                                    .cmd_len = sizeof(LIB_LTE_GPS_DATA_STRING),
-                                                    .cmd_args = NULL,
-                                                    .args_len = 0,
-                                                    .response_str = NULL,
-                                                    .resp_len = 0,
-                                                    .is_query = false,
-                                                    .resp_type = LIB_LTE_RESP_TYPE_STRING,
-                                                    .formatted_args = false};
+const lib_lte_cmd_type_E LIB_LTE_HTTP_CONFIGURE_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_HTTP_CONFIG_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_CONN_CMD = LIB_LTE_SPEC_EXEC(LIB_LTE_HTTP_CONNECT_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_CHECK_CONN_CMD = LIB_LTE_SPEC_QUERY(LIB_LTE_HTTP_STATE_STRING,
+                                                        LIB_LTE_CMD_HTTP_CONNECTED_RESPONSE_STRING,
+                                                        sizeof(LIB_LTE_CMD_HTTP_CONNECTED_RESPONSE_STRING),
+                                                        LIB_LTE_RESP_TYPE_STRING);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_CLEAR_HEADER_CMD = LIB_LTE_SPEC_EXEC(LIB_LTE_HTTP_CLEAR_HDR_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_CLEAR_BODY_CMD = LIB_LTE_SPEC_EXEC(LIB_LTE_HTTP_CLEAR_BDY_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_WRITE_TO_HEADER_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_HTTP_WRITE_HDR_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_WRITE_TO_BODY_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_HTTP_WRITE_BDY_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_WRITE_BINARY_BODY_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_HTTP_WRITE_BINARY_BDY_STRING,
+                                                                                NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_POST_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_HTTP_POST_STRING,
+                                                        LIB_LTE_CMD_HTTP_POST_RESPONSE_STRING,
+                                                        sizeof(LIB_LTE_CMD_HTTP_POST_RESPONSE_STRING),
+                                                        LIB_LTE_RESP_TYPE_STRING);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_READ_RESP_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_HTTP_READ_RESPONSE_STRING,
+                                                        LIB_LTE_CMD_HTTP_READ_DATA_RESPONSE_STRING,
+                                                        sizeof(LIB_LTE_CMD_HTTP_READ_DATA_RESPONSE_STRING),
+                                                        LIB_LTE_RESP_TYPE_ASYNC);
+
+const lib_lte_cmd_type_E LIB_LTE_HTTP_DISCONNECT_CMD = LIB_LTE_SPEC_EXEC(LIB_LTE_HTTP_DISCONNECT_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+/* socket commands */
+const lib_lte_cmd_type_E LIB_LTE_SOCKET_OPEN_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_SOCKET_OPEN_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_STRING);
+
+const lib_lte_cmd_type_E LIB_LTE_SOCKET_SEND_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_SOCKET_SEND_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIB_LTE_SOCKET_RECV_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_SOCKET_RECV_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_STRING);
+
+const lib_lte_cmd_type_E LIB_LTE_SOCKET_CLOSE_CMD = LIB_LTE_SPEC_FORMATTED(LIB_LTE_SOCKET_CLOSE_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIT_LTE_GPS_POWER_ON_CMD = LIB_LTE_SPEC_SET(LIB_LTE_GPS_PWR_STRING, LIB_LTE_GPS_ON_ARGS_STRING,
+                                                                                NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIT_LTE_GPS_POWER_OFF_CMD = LIB_LTE_SPEC_SET(LIB_LTE_GPS_PWR_STRING, LIB_LTE_GPS_OFF_ARGS_STRING,
+                                                                                NULL, 0, LIB_LTE_RESP_TYPE_BASIC);
+
+const lib_lte_cmd_type_E LIT_LTE_GPS_GET_LOCATION_CMD = LIB_LTE_SPEC_EXEC(LIB_LTE_GPS_DATA_STRING, NULL, 0,
+                                                                                        LIB_LTE_RESP_TYPE_STRING);
@@ -0,0 +1,164 @@
+/**
+ * @file lib_pool.c
+ * @author Emery Nagy
+ * @brief Deterministic fixed-size block pool allocator
+ * @version 0.1
+ * @date 2023-03-08
+ *
+ */
+
+/* HAL includes */
+#include "sys/alt_irq.h"
+
+/* FreeRTOS includes */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* lib includes */
+#include "lib_pool.h"
+
+
+/* Private API */
+
+/**
+ * @brief pop a block off the free list, caller must hold off interrupts
+ *
+ * @param pool pool to allocate from
+ * @return void* block, NULL if the pool is empty
+ */
+static void* lib_pool_pop(lib_pool_S* pool) {
+    lib_pool_block_S* block = pool->free_list;
+
+    if (block != NULL) {
+        pool->free_list = block->next;
+        pool->used++;
+        if (pool->used > pool->high_water) {
+            pool->high_water = pool->used;
+        }
+    } else {
+        pool->failures++;
+    }
+
+    return block;
+}
+
+/**
+ * @brief push a block back onto the free list, caller must hold off interrupts
+ *
+ * @param pool pool the block came from
+ * @param block block to release
+ * @return lib_pool_result_E LIB_POOL_ERROR if the block does not belong to the pool
+ */
+static lib_pool_result_E lib_pool_push(lib_pool_S* pool, void* block) {
+    alt_u32 offset = (alt_u8*)block - pool->storage;
+
+    /* unsigned offset also catches pointers below the pool */
+    if ((block == NULL) || (offset >= (pool->block_size * pool->block_count)) || ((offset % pool->block_size) != 0)) {
+        return LIB_POOL_ERROR;
+    }
+
+    ((lib_pool_block_S*)block)->next = pool->free_list;
+    pool->free_list = (lib_pool_block_S*)block;
+    pool->used--;
+
+    return LIB_POOL_SUCCESS;
+}
+
+
+/* Public API */
+
+/**
+ * @brief carve static storage into a free list of blocks
+ *
+ * @param pool pool to initialize
+ * @param storage static storage, at least LIB_POOL_STORAGE_WORDS(block_size, block_count) words
+ * @param block_size requested block size in bytes, rounded up with LIB_POOL_BLOCK_SIZE
+ * @param block_count number of blocks
+ */
+void lib_pool_init(lib_pool_S* pool, alt_u32* storage, alt_u32 block_size, alt_u32 block_count) {
+    pool->storage = (alt_u8*)storage;
+    pool->block_size = LIB_POOL_BLOCK_SIZE(block_size);
+    pool->block_count = block_count;
+    pool->used = 0;
+    pool->high_water = 0;
+    pool->failures = 0;
+
+    /* link blocks in address order */
+    pool->free_list = NULL;
+    for (alt_u32 i = block_count; i > 0; i--) {
+        lib_pool_block_S* block = (lib_pool_block_S*)(pool->storage + ((i - 1) * pool->block_size));
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+}
+
+/**
+ * @brief allocate one block from task context
+ *
+ * @param pool pool to allocate from
+ * @return void* block, NULL if the pool is empty
+ */
+void* lib_pool_alloc(lib_pool_S* pool) {
+    taskENTER_CRITICAL();
+    void* block = lib_pool_pop(pool);
+    taskEXIT_CRITICAL();
+    return block;
+}
+
+/**
+ * @brief release one block from task context
+ *
+ * @param pool pool the block came from
+ * @param block block to release
+ * @return lib_pool_result_E
+ */
+lib_pool_result_E lib_pool_free(lib_pool_S* pool, void* block) {
+    taskENTER_CRITICAL();
+    lib_pool_result_E res = lib_pool_push(pool, block);
+    taskEXIT_CRITICAL();
+    return res;
+}
+
+/**
+ * @brief allocate one block from an ISR
+ *
+ * @param pool pool to allocate from
+ * @return void* block, NULL if the pool is empty
+ */
+void* lib_pool_alloc_from_isr(lib_pool_S* pool) {
+    /* the port has no interrupt mask from ISR, disable everything so a nested handler can't interleave */
+    alt_irq_context context = alt_irq_disable_all();
+    void* block = lib_pool_pop(pool);
+    alt_irq_enable_all(context);
+    return block;
+}
+
+/**
+ * @brief release one block from an ISR
+ *
+ * @param pool pool the block came from
+ * @param block block to release
+ * @return lib_pool_result_E
+ */
+lib_pool_result_E lib_pool_free_from_isr(lib_pool_S* pool, void* block) {
+    alt_irq_context context = alt_irq_disable_all();
+    lib_pool_result_E res = lib_pool_push(pool, block);
+    alt_irq_enable_all(context);
+    return res;
+}
+
+/**
+ * @brief take a consistent snapshot of pool occupancy
+ *
+ * @param pool pool to report
+ * @param stats output occupancy
+ */
+void lib_pool_get_stats(lib_pool_S* pool, lib_pool_stats_S* stats) {
+    taskENTER_CRITICAL();
+    stats->block_size = pool->block_size;
+    stats->block_count = pool->block_count;
+    stats->used = pool->used;
+    stats->high_water = pool->high_water;
+    stats->failures = pool->failures;
+    taskEXIT_CRITICAL();
+}
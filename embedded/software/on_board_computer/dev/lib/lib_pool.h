@@ -0,0 +1,84 @@
+/**
+ * @file lib_pool.h
+ * @author Emery Nagy
+ * @brief Deterministic fixed-size block pool allocator
+ * @version 0.1
+ * @date 2023-03-08
+ *
+ */
+
+#ifndef LIB_POOL_H_
+#define LIB_POOL_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* Public defines */
+
+/* block size rounded up so every block can hold the free list link and stays word aligned */
+#define LIB_POOL_BLOCK_SIZE(size) ((((size) < sizeof(void*)) ? sizeof(void*) : ((size) + sizeof(void*) - 1)) & \
+                                                                                            ~(sizeof(void*) - 1))
+/* number of words of static storage needed for a pool, declare storage as alt_u32 name[LIB_POOL_STORAGE_WORDS(...)] */
+#define LIB_POOL_STORAGE_WORDS(size, count) ((LIB_POOL_BLOCK_SIZE(size) * (count)) / sizeof(alt_u32))
+
+/* Public types */
+
+/**
+ * @brief free block, the link lives inside the block itself
+ *
+ */
+typedef struct lib_pool_block_S {
+    struct lib_pool_block_S* next;
+} lib_pool_block_S;
+
+/**
+ * @brief block pool, all operations are O(1)
+ *
+ */
+typedef struct {
+    /* first free block */
+    lib_pool_block_S* free_list;
+    /* pool storage */
+    alt_u8* storage;
+    /* size of each block after rounding */
+    alt_u32 block_size;
+    /* number of blocks in the pool */
+    alt_u32 block_count;
+    /* blocks currently allocated */
+    alt_u32 used;
+    /* most blocks ever allocated at once */
+    alt_u32 high_water;
+    /* allocations that failed because the pool was empty */
+    alt_u32 failures;
+} lib_pool_S;
+
+/**
+ * @brief pool occupancy snapshot
+ *
+ */
+typedef struct {
+    alt_u32 block_size;
+    alt_u32 block_count;
+    alt_u32 used;
+    alt_u32 high_water;
+    alt_u32 failures;
+} lib_pool_stats_S;
+
+/**
+ * @brief pool result enum
+ *
+ */
+typedef enum {
+    LIB_POOL_SUCCESS,
+    LIB_POOL_ERROR
+} lib_pool_result_E;
+
+/* Public API */
+void lib_pool_init(lib_pool_S* pool, alt_u32* storage, alt_u32 block_size, alt_u32 block_count);
+void* lib_pool_alloc(lib_pool_S* pool);
+lib_pool_result_E lib_pool_free(lib_pool_S* pool, void* block);
+void* lib_pool_alloc_from_isr(lib_pool_S* pool);
+lib_pool_result_E lib_pool_free_from_isr(lib_pool_S* pool, void* block);
+void lib_pool_get_stats(lib_pool_S* pool, lib_pool_stats_S* stats);
+
+#endif /* LIB_POOL_H_ */
@@ -2,7 +2,7 @@
  * @file lib_uart.c
  * @author Emery Nagy
  * @brief UART firmware driver
- * @version 0.1
+ * @version 0.2
  * @date 2023-02-11
  * 
  */
@@ -13,6 +13,7 @@
 #include "sys/alt_irq.h"
 #include "priv/alt_legacy_irq.h"
 #include "altera_avalon_uart_regs.h"
+#include "altera_avalon_timer_regs.h"
 
 /* FreeRTOS includes */
 #include "FreeRTOS.h"
@@ -20,48 +21,215 @@
 
 /* stdlib includes */
 #include "stdio.h"
+#include "string.h"
 
 /* lib includes */
 #include "lib_uart.h"
 
 
+/* Private data */
+
+/* every initialized port, so link statistics can be reported without knowing which drivers are running */
+static lib_uart_config_S* lib_uart_ports[LIB_UART_MAX_PORTS];
+static alt_u32 lib_uart_port_count = 0;
+
 /* Private API */
 
 /**
- * @brief Generic UART rx irq, processes interrupt and calls app layer irq as well as app rx error callback.
- *  App layer callbacks should be as lightweight as possible.
+ * @brief push as many bytes as will fit into a ring, producer side only
  *
+ * @param ring ring to fill
+ * @param data data to push
+ * @param len number of bytes to push
+ * @return alt_u32 number of bytes actually pushed
  */
-void lib_uart_rx_irq(void* isr_context, alt_u32 id) {
+static alt_u32 lib_uart_ring_push(lib_uart_ring_S* ring, const alt_u8* data, alt_u32 len) {
+    alt_u32 space = (ring->mask + 1) - (ring->head - ring->tail);
+    alt_u32 count = (len < space) ? len : space;
 
-    lib_uart_config_S* config = (lib_uart_config_S*)isr_context;
-    alt_u32 status = IORD_ALTERA_AVALON_UART_STATUS(config->uart_base);
+    for (alt_u32 i = 0; i < count; i++) {
+        ring->buf[(ring->head + i) & ring->mask] = data[i];
+    }
+    /* only publish the new head once the data is in place */
+    ring->head += count;
 
-    /* Clear any error flags set at the device */
-    IOWR_ALTERA_AVALON_UART_STATUS(config->uart_base, 0);
+    return count;
+}
 
-    /* Dummy read to ensure IRQ is negated before ISR returns */
-    IORD_ALTERA_AVALON_UART_STATUS(config->uart_base);
+#if (LIB_UART_STATS_ISR_CYCLES == 1)
+/**
+ * @brief latch and read the system tick timer, counts down once per CPU cycle and reloads every tick
+ *
+ * @return alt_u32 current counter value
+ */
+static inline alt_u32 lib_uart_cycle_snapshot(void) {
+    IOWR_ALTERA_AVALON_TIMER_SNAPL(SYS_CLK_BASE, 0);
+    return (IORD_ALTERA_AVALON_TIMER_SNAPH(SYS_CLK_BASE) << 16) | IORD_ALTERA_AVALON_TIMER_SNAPL(SYS_CLK_BASE);
+}
+#endif
+
+/**
+ * @brief enable TRDY interrupts so the ISR starts draining the TX ring
+ *
+ * @param config UART config struct
+ */
+static void lib_uart_tx_irq_enable(lib_uart_config_S* config) {
+    taskENTER_CRITICAL();
+    alt_u32 cntrl = IORD_ALTERA_AVALON_UART_CONTROL(config->uart_base);
+    IOWR_ALTERA_AVALON_UART_CONTROL(config->uart_base, cntrl | ALTERA_AVALON_UART_CONTROL_TRDY_MSK);
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Transmit half of the UART irq, moves one byte from the TX ring into the transmitter. Once the ring is empty
+ *        TRDY interrupts are disabled and the waiting task (if any) is notified.
+ *
+ * @param config UART config struct
+ * @param status UART status register captured on irq entry
+ * @param woken set if a higher priority task was woken
+ */
+static void lib_uart_tx_irq(lib_uart_config_S* config, alt_u32 status, BaseType_t* woken) {
+    lib_uart_ring_S* ring = &config->tx_ring;
+
+    /* TRDY is always set while the transmitter is idle, only act on it if we asked for it */
+    if (!(status & ALTERA_AVALON_UART_STATUS_TRDY_MSK) ||
+        !(IORD_ALTERA_AVALON_UART_CONTROL(config->uart_base) & ALTERA_AVALON_UART_CONTROL_TRDY_MSK)) {
+        return;
+    }
+
+    alt_u32 waiting = ring->head - ring->tail;
+    if (waiting > config->stats.tx_ring_high_water) {
+        config->stats.tx_ring_high_water = waiting;
+    }
+
+    if (waiting != 0) {
+        IOWR_ALTERA_AVALON_UART_TXDATA(config->uart_base, ring->buf[ring->tail & ring->mask]);
+        ring->tail++;
+        config->stats.tx_bytes++;
+    }
+
+    if (ring->head == ring->tail) {
+        alt_u32 cntrl = IORD_ALTERA_AVALON_UART_CONTROL(config->uart_base);
+        IOWR_ALTERA_AVALON_UART_CONTROL(config->uart_base, cntrl & ~ALTERA_AVALON_UART_CONTROL_TRDY_MSK);
+
+        TaskHandle_t task = config->tx_notify_task;
+        if (task != NULL) {
+            config->tx_notify_task = NULL;
+            vTaskNotifyGiveIndexedFromISR(task, LIB_UART_TX_NOTIFY_INDEX, woken);
+        }
+    }
+}
+
+/**
+ * @brief Receive half of the UART irq, queues the incoming byte in the RX ring and wakes the listening task once its
+ *  threshold or terminator is hit, the rx hook asks for it, or a line error is latched. Optional app layer hooks
+ *  should be as lightweight as possible.
+ *
+ * @param config UART config struct
+ * @param status UART status register captured on irq entry
+ * @param woken set if a higher priority task was woken
+ */
+static void lib_uart_rx_irq(lib_uart_config_S* config, alt_u32 status, BaseType_t* woken) {
 
     /* Throw out any bad data */
     if (status & (ALTERA_AVALON_UART_STATUS_PE_MSK |
                     ALTERA_AVALON_UART_STATUS_FE_MSK|
                     ALTERA_AVALON_UART_STATUS_ROE_MSK))
     {
+        config->rx_error = true;
+        if (status & ALTERA_AVALON_UART_STATUS_PE_MSK) {
+            config->stats.parity_errors++;
+        }
+        if (status & ALTERA_AVALON_UART_STATUS_FE_MSK) {
+            config->stats.framing_errors++;
+        }
+        if (status & ALTERA_AVALON_UART_STATUS_ROE_MSK) {
+            config->stats.overrun_errors++;
+        }
 
         /* call error callback */
         lib_uart_rx_error err_cb = config->uart_rx_error;
-        err_cb();
+        if (err_cb != NULL) {
+            err_cb();
+        }
+
+        /* let the listener see the error now rather than at its timeout */
+        TaskHandle_t task = config->rx_notify_task;
+        if (task != NULL) {
+            vTaskNotifyGiveIndexedFromISR(task, LIB_UART_RX_NOTIFY_INDEX, woken);
+        }
         return;
     }
 
     /* process a read irq */
     if (status & ALTERA_AVALON_UART_STATUS_RRDY_MSK)
     {
+        lib_uart_ring_S* ring = &config->rx_ring;
+        alt_u8 rxdata = IORD_ALTERA_AVALON_UART_RXDATA(config->uart_base);
+        bool wake = false;
+
+        /* drop the byte if the listener has fallen a whole ring behind */
+        config->stats.rx_bytes++;
+        if ((ring->head - ring->tail) <= ring->mask) {
+            ring->buf[ring->head & ring->mask] = rxdata;
+            ring->head++;
+        } else {
+            config->stats.rx_dropped++;
+        }
+
+        alt_u32 waiting = ring->head - ring->tail;
+        if (waiting > config->stats.rx_ring_high_water) {
+            config->stats.rx_ring_high_water = waiting;
+        }
+
         lib_uart_generic_rx_irq rx_cb = config->uart_rx_irq;
-        rx_cb(IORD_ALTERA_AVALON_UART_RXDATA(config->uart_base));
+        if (rx_cb != NULL) {
+            wake = rx_cb(rxdata);
+        }
+
+        if (wake || (rxdata == config->rx_terminator) || (waiting >= config->rx_threshold)) {
+            TaskHandle_t task = config->rx_notify_task;
+            if (task != NULL) {
+                vTaskNotifyGiveIndexedFromISR(task, LIB_UART_RX_NOTIFY_INDEX, woken);
+            }
+        }
     }
+}
+
+/**
+ * @brief Generic UART irq, services both the transmit ring and incoming data
+ *
+ */
+static void lib_uart_irq(void* isr_context, alt_u32 id) {
 
+    lib_uart_config_S* config = (lib_uart_config_S*)isr_context;
+#if (LIB_UART_STATS_ISR_CYCLES == 1)
+    alt_u32 start_cycles = lib_uart_cycle_snapshot();
+#endif
+    alt_u32 status = IORD_ALTERA_AVALON_UART_STATUS(config->uart_base);
+    BaseType_t woken = pdFALSE;
+
+    /* Clear any error flags set at the device */
+    IOWR_ALTERA_AVALON_UART_STATUS(config->uart_base, 0);
+
+    /* Dummy read to ensure IRQ is negated before ISR returns */
+    IORD_ALTERA_AVALON_UART_STATUS(config->uart_base);
+
+    lib_uart_tx_irq(config, status, &woken);
+    lib_uart_rx_irq(config, status, &woken);
+
+    config->stats.isr_count++;
+#if (LIB_UART_STATS_ISR_CYCLES == 1)
+    /* timer counts down, account for a reload in the middle of the irq */
+    alt_u32 end_cycles = lib_uart_cycle_snapshot();
+    alt_u32 cycles = (start_cycles >= end_cycles) ? (start_cycles - end_cycles) :
+                                        (start_cycles + (configCPU_CLOCK_HZ / configTICK_RATE_HZ) - end_cycles);
+    if (cycles > config->stats.isr_max_cycles) {
+        config->stats.isr_max_cycles = cycles;
+    }
+#endif
+
+    portEND_SWITCHING_ISR(woken);
 }
 
 
@@ -75,6 +243,24 @@ void lib_uart_rx_irq(void* isr_context, alt_u32 id) {
  */
 lib_uart_resp_E lib_uart_init(lib_uart_config_S* config) {
 
+    /* TX ring starts empty, TRDY interrupts are only enabled while it holds data */
+    config->tx_ring.head = 0;
+    config->tx_ring.tail = 0;
+    config->tx_ring.mask = LIB_UART_TX_RING_SIZE - 1;
+    config->tx_ring.buf = config->tx_storage;
+    config->tx_notify_task = NULL;
+
+    /* nobody is listening for RX data until a driver asks for it */
+    config->rx_ring.head = 0;
+    config->rx_ring.tail = 0;
+    config->rx_ring.mask = LIB_UART_RX_RING_SIZE - 1;
+    config->rx_ring.buf = config->rx_storage;
+    config->rx_notify_task = NULL;
+    config->rx_threshold = LIB_UART_RX_RING_SIZE;
+    config->rx_terminator = LIB_UART_RX_NO_TERMINATOR;
+    config->rx_error = false;
+    memset((void*)&config->stats, 0, sizeof(config->stats));
+
     /* Enable rx interrupts */
     alt_16 cntrl = ALTERA_AVALON_UART_CONTROL_RRDY_MSK |
                     ALTERA_AVALON_UART_CONTROL_PE_MSK |
@@ -83,56 +269,356 @@ lib_uart_resp_E lib_uart_init(lib_uart_config_S* config) {
 
     IOWR_ALTERA_AVALON_UART_CONTROL(config->uart_base, cntrl);
 
-    /* Register rx interrupt irq, calls uart generic rx interrupt irq */
-    alt_irq_register(config->uart_irq, config, (alt_isr_func)lib_uart_rx_irq);
+    /* Register uart interrupt irq, services both rx and tx */
+    alt_irq_register(config->uart_irq, config, (alt_isr_func)lib_uart_irq);
+
+    /* register port for reporting */
+    bool registered = false;
+    for (alt_u32 i = 0; i < lib_uart_port_count; i++) {
+        registered |= (lib_uart_ports[i] == config);
+    }
+    if (!registered && (lib_uart_port_count < LIB_UART_MAX_PORTS)) {
+        lib_uart_ports[lib_uart_port_count++] = config;
+    }
 
     return LIB_UART_SUCCESS;
 }
 
 /**
- * @brief Send tx buffer via UART
+ * @brief Queue tx buffer for interrupt driven transmission and return immediately. The whole buffer is queued or
+ *        nothing is, only one task may transmit on a given UART at a time.
  *
  * @param config UART config struct
  * @param tx_buf UART transmit buffer
  * @param tx_len Size of transmit buffer in bytes
+ * @param notify_task optional -> task to notify on LIB_UART_TX_NOTIFY_INDEX once all queued data has been sent
  * @return lib_uart_resp_E
  */
-lib_uart_resp_E lib_uart_tx(lib_uart_config_S* config, void* tx_buf, alt_u32 tx_len, alt_32 timeout_ms) {
+lib_uart_resp_E lib_uart_tx_async(lib_uart_config_S* config, const void* tx_buf, alt_u32 tx_len, TaskHandle_t notify_task) {
 
-    lib_uart_resp_E result = LIB_UART_ERROR;
+    lib_uart_ring_S* ring = &config->tx_ring;
 
-    /* Get uart status and only transmit if hardware ready */
-    alt_u32 status = IORD_ALTERA_AVALON_UART_STATUS(config->uart_base);
-    alt_u64 starting_timestamp = xTaskGetTickCount();
-    alt_8* tx_ptr = tx_buf;
-    alt_32 sent = 0;
+    /* not enough room in the ring for this buffer */
+    if (tx_len > ((ring->mask + 1) - (ring->head - ring->tail))) {
+        return LIB_UART_ERROR;
+    }
 
-    /* Only block app task for maximum amount of time defined by timeout_ms */
-    while (((xTaskGetTickCount() - starting_timestamp)/portTICK_PERIOD_MS) < timeout_ms) {
+    if (notify_task != NULL) {
+        config->tx_notify_task = notify_task;
+    }
+    lib_uart_ring_push(ring, tx_buf, tx_len);
+    lib_uart_tx_irq_enable(config);
+
+    return LIB_UART_SUCCESS;
+}
+
+/**
+ * @brief get the number of bytes still waiting to be transmitted
+ *
+ * @param config UART config struct
+ * @return alt_u32
+ */
+alt_u32 lib_uart_tx_pending(lib_uart_config_S* config) {
+    return config->tx_ring.head - config->tx_ring.tail;
+}
 
-        if (status & ALTERA_AVALON_UART_STATUS_TRDY_MSK) {
-            IOWR_ALTERA_AVALON_UART_TXDATA(config->uart_base, *tx_ptr);
-            sent++;
+/**
+ * @brief Send several non-contiguous fragments back to back via UART, blocks the calling task (without spinning) until
+ *        all of them have been sent. Fragments are streamed straight into the TX ring, no intermediate buffer is built.
+ *
+ * @param config UART config struct
+ * @param iov fragments to send in order
+ * @param count number of fragments
+ * @param timeout_ms maximum time to block for
+ * @return lib_uart_resp_E
+ */
+lib_uart_resp_E lib_uart_txv(lib_uart_config_S* config, const lib_uart_iovec_S* iov, alt_u32 count, alt_32 timeout_ms) {
 
-            if (sent == tx_len) {
-                result = LIB_UART_SUCCESS;
+    lib_uart_resp_E result = LIB_UART_ERROR;
+    lib_uart_ring_S* ring = &config->tx_ring;
+    TickType_t starting_timestamp = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    alt_u32 frag = 0;
+    alt_u32 sent = 0;
+
+    /* Only block app task for maximum amount of time defined by timeout_ms */
+    while (1) {
+        /* arm the drain notification before queueing so a fast drain cannot be missed */
+        config->tx_notify_task = xTaskGetCurrentTaskHandle();
+
+        /* queue as many fragments as the ring will take */
+        while (frag < count) {
+            const alt_u8* base = iov[frag].base;
+            sent += lib_uart_ring_push(ring, base + sent, iov[frag].len - sent);
+            if (sent < iov[frag].len) {
                 break;
             }
-            tx_ptr++;
+            frag++;
+            sent = 0;
+        }
+        lib_uart_tx_irq_enable(config);
+
+        TickType_t elapsed = xTaskGetTickCount() - starting_timestamp;
+        if ((elapsed >= timeout) || (ulTaskNotifyTakeIndexed(LIB_UART_TX_NOTIFY_INDEX, pdTRUE, timeout - elapsed) == 0)) {
+            config->tx_notify_task = NULL;
+            break;
+        }
+
+        /* notification may be stale from an earlier drain, only done once everything has left the ring */
+        if ((frag == count) && (ring->head == ring->tail)) {
+            result = LIB_UART_SUCCESS;
+            break;
         }
-        status = IORD_ALTERA_AVALON_UART_STATUS(config->uart_base);
     }
 
     return result;
 }
 
+/**
+ * @brief Queue data behind whatever is already waiting in the TX ring without waiting for it to go out, blocks only
+ *        while the ring is full. Lets a producer stream data of any length straight into the ring, finish with
+ *        lib_uart_tx_drain.
+ *
+ * @param config UART config struct
+ * @param tx_buf data to queue
+ * @param tx_len number of bytes
+ * @param timeout_ms maximum time to block for room in the ring
+ * @return lib_uart_resp_E LIB_UART_ERROR if the ring did not drain in time, part of the data may be queued
+ */
+lib_uart_resp_E lib_uart_tx_stream(lib_uart_config_S* config, const void* tx_buf, alt_u32 tx_len, alt_32 timeout_ms) {
+    lib_uart_ring_S* ring = &config->tx_ring;
+    const alt_u8* data = tx_buf;
+    TickType_t starting_timestamp = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+
+    while (1) {
+        /* arm the drain notification before queueing so a fast drain cannot be missed */
+        config->tx_notify_task = xTaskGetCurrentTaskHandle();
+        alt_u32 sent = lib_uart_ring_push(ring, data, tx_len);
+        lib_uart_tx_irq_enable(config);
+        data += sent;
+        tx_len -= sent;
+        if (tx_len == 0) {
+            /* the armed notification is left for lib_uart_tx_drain, stale ones are harmless */
+            return LIB_UART_SUCCESS;
+        }
+
+        /* ring is full, wait for it to empty */
+        TickType_t elapsed = xTaskGetTickCount() - starting_timestamp;
+        if ((elapsed >= timeout) || (ulTaskNotifyTakeIndexed(LIB_UART_TX_NOTIFY_INDEX, pdTRUE, timeout - elapsed) == 0)) {
+            config->tx_notify_task = NULL;
+            return LIB_UART_ERROR;
+        }
+    }
+}
+
+/**
+ * @brief block the calling task (without spinning) until everything queued in the TX ring has been sent
+ *
+ * @param config UART config struct
+ * @param timeout_ms maximum time to block for
+ * @return lib_uart_resp_E
+ */
+lib_uart_resp_E lib_uart_tx_drain(lib_uart_config_S* config, alt_32 timeout_ms) {
+    lib_uart_ring_S* ring = &config->tx_ring;
+    TickType_t starting_timestamp = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+
+    while (1) {
+        config->tx_notify_task = xTaskGetCurrentTaskHandle();
+        if (ring->head == ring->tail) {
+            config->tx_notify_task = NULL;
+            return LIB_UART_SUCCESS;
+        }
+
+        /* notification may be stale from an earlier drain, the ring is checked again */
+        TickType_t elapsed = xTaskGetTickCount() - starting_timestamp;
+        if ((elapsed >= timeout) || (ulTaskNotifyTakeIndexed(LIB_UART_TX_NOTIFY_INDEX, pdTRUE, timeout - elapsed) == 0)) {
+            config->tx_notify_task = NULL;
+            return LIB_UART_ERROR;
+        }
+    }
+}
+
+/**
+ * @brief Send tx buffer via UART, blocks the calling task (without spinning) until the data has been sent
+ *
+ * @param config UART config struct
+ * @param tx_buf UART transmit buffer
+ * @param tx_len Size of transmit buffer in bytes
+ * @param timeout_ms maximum time to block for
+ * @return lib_uart_resp_E
+ */
+lib_uart_resp_E lib_uart_tx(lib_uart_config_S* config, void* tx_buf, alt_u32 tx_len, alt_32 timeout_ms) {
+    lib_uart_iovec_S iov = {.base = tx_buf, .len = tx_len};
+    return lib_uart_txv(config, &iov, 1, timeout_ms);
+}
+
+/**
+ * @brief register the task to be notified about incoming data. Notifications latch, so data that arrives between
+ *        two waits is never missed.
+ *
+ * @param config UART config struct
+ * @param task task to notify on LIB_UART_RX_NOTIFY_INDEX, NULL to stop listening
+ * @param threshold notify once this many bytes are waiting in the RX ring
+ * @param terminator notify when this byte arrives (ie '\n'), LIB_UART_RX_NO_TERMINATOR to disable
+ */
+void lib_uart_rx_listen(lib_uart_config_S* config, TaskHandle_t task, alt_u32 threshold, alt_16 terminator) {
+    taskENTER_CRITICAL();
+    config->rx_threshold = threshold;
+    config->rx_terminator = terminator;
+    config->rx_notify_task = task;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief block the listening task until the RX ISR notifies it
+ *
+ * @param config UART config struct
+ * @param block_ticks maximum time to block for
+ * @return true if notified, false on timeout
+ */
+bool lib_uart_rx_wait(lib_uart_config_S* config, TickType_t block_ticks) {
+    return (ulTaskNotifyTakeIndexed(LIB_UART_RX_NOTIFY_INDEX, pdTRUE, block_ticks) != 0);
+}
+
+/**
+ * @brief copy waiting bytes out of the RX ring, consumer side only
+ *
+ * @param config UART config struct
+ * @param rx_buf output buffer
+ * @param max_len maximum number of bytes to copy
+ * @return alt_u32 number of bytes copied
+ */
+alt_u32 lib_uart_rx_read(lib_uart_config_S* config, void* rx_buf, alt_u32 max_len) {
+    lib_uart_ring_S* ring = &config->rx_ring;
+    alt_u8* out = rx_buf;
+    alt_u32 available = ring->head - ring->tail;
+    alt_u32 count = (max_len < available) ? max_len : available;
+
+    for (alt_u32 i = 0; i < count; i++) {
+        out[i] = ring->buf[(ring->tail + i) & ring->mask];
+    }
+    /* only hand the space back to the ISR once the data has been copied */
+    ring->tail += count;
+
+    return count;
+}
+
+/**
+ * @brief get the number of bytes waiting in the RX ring
+ *
+ * @param config UART config struct
+ * @return alt_u32
+ */
+alt_u32 lib_uart_rx_pending(lib_uart_config_S* config) {
+    return config->rx_ring.head - config->rx_ring.tail;
+}
+
+/**
+ * @brief discard everything waiting in the RX ring along with any latched notification, called by the listening task
+ *
+ * @param config UART config struct
+ */
+void lib_uart_rx_flush(lib_uart_config_S* config) {
+    config->rx_ring.tail = config->rx_ring.head;
+    ulTaskNotifyValueClearIndexed(NULL, LIB_UART_RX_NOTIFY_INDEX, 0xFFFFFFFF);
+}
+
+/**
+ * @brief check for and clear a latched RX line error
+ *
+ * @param config UART config struct
+ * @return true if a parity, framing or overrun error happened since the last call
+ */
+bool lib_uart_rx_take_error(lib_uart_config_S* config) {
+    taskENTER_CRITICAL();
+    bool error = config->rx_error;
+    config->rx_error = false;
+    taskEXIT_CRITICAL();
+    return error;
+}
+
+/**
+ * @brief get the running count of RX line errors, compare against an earlier count to get an error rate
+ *
+ * @param config UART config struct
+ * @return alt_u32
+ */
+alt_u32 lib_uart_rx_error_count(lib_uart_config_S* config) {
+    return config->stats.parity_errors + config->stats.framing_errors + config->stats.overrun_errors;
+}
+
+/**
+ * @brief take a consistent snapshot of the port statistics
+ *
+ * @param config UART config struct
+ * @param stats output statistics
+ */
+void lib_uart_get_stats(lib_uart_config_S* config, lib_uart_stats_S* stats) {
+    taskENTER_CRITICAL();
+    memcpy(stats, (const void*)&config->stats, sizeof(*stats));
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief get an initialized port by index, used to walk every port for reporting
+ *
+ * @param index port index, starting from 0
+ * @return lib_uart_config_S* port, NULL once index is past the last initialized port
+ */
+lib_uart_config_S* lib_uart_get_port(alt_u32 index) {
+    return (index < lib_uart_port_count) ? lib_uart_ports[index] : NULL;
+}
+
 /**
  * @brief change the UART system baud rate accoring to https://www.intel.com/content/www/us/en/docs/programmable/683130/22-3/divisor-register-optional.html
+ *        waits for the transmitter to go idle first so the last byte is not sent at the wrong rate
  *
  * @param config uart device to change
  * @param rate new baud rate to set
+ * @return lib_uart_resp_E LIB_UART_ERROR if the port has no divisor register or the transmitter did not go idle
+ *         within LIB_UART_BAUD_IDLE_TIMEOUT_MS, the rate is left as it was
+ */
+lib_uart_resp_E lib_uart_set_baud(lib_uart_config_S* config, alt_u32 rate) {
+    lib_uart_resp_E res = LIB_UART_ERROR;
+
+    do {
+        if (config->fixed_baud || (rate == 0) || (config->uart_freq == 0)) {
+            break;
+        }
+
+        /* an async transfer can still be queued, let it go out at the old rate without spinning */
+        if (lib_uart_tx_drain(config, LIB_UART_BAUD_IDLE_TIMEOUT_MS) != LIB_UART_SUCCESS) {
+            break;
+        }
+
+        /* then the shift register, at most a character time unless the UART has stalled */
+        TickType_t starting_timestamp = xTaskGetTickCount();
+        bool idle;
+        while (!(idle = (IORD_ALTERA_AVALON_UART_STATUS(config->uart_base) & ALTERA_AVALON_UART_STATUS_TMT_MSK)) &&
+                ((xTaskGetTickCount() - starting_timestamp) < pdMS_TO_TICKS(LIB_UART_BAUD_IDLE_TIMEOUT_MS))) {
+            taskYIELD();
+        }
+        if (!idle) {
+            break;
+        }
+
+        /* divisor = round(clock / baud) - 1 */
+        IOWR_ALTERA_AVALON_UART_DIVISOR(config->uart_base, ((config->uart_freq + (rate / 2)) / rate) - 1);
+        config->baud = rate;
+        res = LIB_UART_SUCCESS;
+    } while (0);
+
+    return res;
+}
+
+/**
+ * @brief get the current UART baud rate
+ *
+ * @param config UART config struct
+ * @return alt_u32
  */
-void lib_uart_set_baud(lib_uart_config_S* config, alt_u32 rate) {
-    printf("Setting %d\n", (CAMERA_FREQ / rate) - 1);
-    IOWR_ALTERA_AVALON_UART_DIVISOR(config->uart_base, (CAMERA_FREQ/rate) - 1);
-}
\ No newline at end of file
+alt_u32 lib_uart_get_baud(lib_uart_config_S* config) {
+    return config->baud;
+}
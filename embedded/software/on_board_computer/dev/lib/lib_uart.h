@@ -2,9 +2,9 @@
  * @file lib_uart.h
  * @author Emery Nagy
  * @brief UART firmware driver
- * @version 0.1
+ * @version 0.2
  * @date 2023-02-11
- * 
+ *
  */
 
 #ifndef LIB_UART_H_
@@ -13,34 +13,133 @@
 /* HAL includes */
 #include "alt_types.h"
 
+/* stdlib includes */
+#include "stdbool.h"
+
+/* FreeRTOS includes */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Public defines */
+#define LIB_UART_TX_RING_SIZE 256 // must be a power of 2
+#define LIB_UART_TX_NOTIFY_INDEX 1 // task notification index used to signal TX completion
+#define LIB_UART_RX_RING_SIZE 1024 // must be a power of 2
+#define LIB_UART_RX_NOTIFY_INDEX 2 // task notification index used to signal RX data
+#define LIB_UART_RX_NO_TERMINATOR (-1)
+#define LIB_UART_BAUD_IDLE_TIMEOUT_MS 100 // how long a baud change waits for the transmitter to go idle
+#define LIB_UART_MAX_PORTS 4 // ports registered for statistics reporting
+#define LIB_UART_STATS_ISR_CYCLES 1 // time every irq against the system tick timer, costs a few register accesses
+
 /* Public types */
 
 /**
- * @brief Generic uart rx irq function pointer, to recieve data, app layer must register its own callback of this type
- *        to the associated uart_config struct to receive uart data
+ * @brief Optional uart rx irq hook, called from the ISR for every byte after it has been queued in the RX ring.
+ *        Must be very lightweight, return true to wake the listening task.
  */
-typedef void (*lib_uart_generic_rx_irq)(alt_8 rxdata);
+typedef bool (*lib_uart_generic_rx_irq)(alt_u8 rxdata);
 
 /**
- * @brief Generic uart rx error function pointer
+ * @brief Optional uart rx error hook, called from the ISR on parity, framing or overrun errors
  *
  */
 typedef void (*lib_uart_rx_error)(void);
 
+/**
+ * @brief single producer/single consumer byte ring. head is only written by the producer and tail only by the
+ *        consumer, indices are free running and masked on access so no lock is needed between task and ISR
+ *
+ */
+typedef struct {
+    /* producer index */
+    volatile alt_u32 head;
+    /* consumer index */
+    volatile alt_u32 tail;
+    /* ring size - 1, ring size must be a power of 2 */
+    alt_u32 mask;
+    /* ring storage */
+    volatile alt_u8* buf;
+} lib_uart_ring_S;
+
+/**
+ * @brief one fragment of a scatter-gather transmission
+ *
+ */
+typedef struct {
+    /* fragment data */
+    const void* base;
+    /* fragment size in bytes */
+    alt_u32 len;
+} lib_uart_iovec_S;
+
+/**
+ * @brief per-port link statistics, counters are free running from lib_uart_init and only written by the irq
+ *
+ */
+typedef struct {
+    /* bytes received, including bytes dropped on a full ring */
+    alt_u32 rx_bytes;
+    /* bytes transmitted */
+    alt_u32 tx_bytes;
+    /* bytes dropped because the RX ring was full */
+    alt_u32 rx_dropped;
+    /* parity errors */
+    alt_u32 parity_errors;
+    /* framing errors */
+    alt_u32 framing_errors;
+    /* receive overrun errors */
+    alt_u32 overrun_errors;
+    /* irq invocations */
+    alt_u32 isr_count;
+    /* longest irq in CPU cycles, 0 if LIB_UART_STATS_ISR_CYCLES is off */
+    alt_u32 isr_max_cycles;
+    /* most bytes ever waiting in the TX ring */
+    alt_u32 tx_ring_high_water;
+    /* most bytes ever waiting in the RX ring */
+    alt_u32 rx_ring_high_water;
+} lib_uart_stats_S;
+
 /**
  * @brief configuration struct for UART hardware
  *
  */
 typedef struct {
 
+    /* short port name for reporting */
+    const char* name;
     /* UART base address */
     volatile unsigned int* uart_base;
     /* UART irq number */
     unsigned int uart_irq;
+    /* UART input clock in Hz, from system.h */
+    alt_u32 uart_freq;
+    /* true if the UART was generated without a divisor register and cannot change baud rate */
+    bool fixed_baud;
+    /* current baud rate, set to the system.h default before init */
+    alt_u32 baud;
     /* UART RX irq */
     lib_uart_generic_rx_irq uart_rx_irq;
     /* UART RX error callback */
     lib_uart_rx_error uart_rx_error;
+    /* UART TX ring, filled by tasks and drained by the TRDY interrupt */
+    lib_uart_ring_S tx_ring;
+    /* UART TX ring storage */
+    alt_u8 tx_storage[LIB_UART_TX_RING_SIZE];
+    /* task to notify once the TX ring drains, cleared by the ISR after notifying */
+    volatile TaskHandle_t tx_notify_task;
+    /* UART RX ring, filled by the RRDY interrupt and drained by the listening task */
+    lib_uart_ring_S rx_ring;
+    /* UART RX ring storage */
+    alt_u8 rx_storage[LIB_UART_RX_RING_SIZE];
+    /* task notified when RX data is ready, NULL when nobody is listening */
+    volatile TaskHandle_t rx_notify_task;
+    /* notify the listener once this many bytes are waiting */
+    volatile alt_u32 rx_threshold;
+    /* notify the listener when this byte arrives, LIB_UART_RX_NO_TERMINATOR to disable */
+    volatile alt_16 rx_terminator;
+    /* set by the ISR on a parity, framing or overrun error, cleared by lib_uart_rx_take_error */
+    volatile bool rx_error;
+    /* link statistics */
+    volatile lib_uart_stats_S stats;
 
 } lib_uart_config_S;
 
@@ -58,6 +157,21 @@ typedef enum {
 /* Public API */
 lib_uart_resp_E lib_uart_init(lib_uart_config_S* config);
 lib_uart_resp_E lib_uart_tx(lib_uart_config_S* config, void* tx_buf, alt_u32 tx_len, alt_32 timeout_ms);
-void lib_uart_set_baud(lib_uart_config_S* config, alt_u32 rate);
+lib_uart_resp_E lib_uart_txv(lib_uart_config_S* config, const lib_uart_iovec_S* iov, alt_u32 count, alt_32 timeout_ms);
+lib_uart_resp_E lib_uart_tx_async(lib_uart_config_S* config, const void* tx_buf, alt_u32 tx_len, TaskHandle_t notify_task);
+lib_uart_resp_E lib_uart_tx_stream(lib_uart_config_S* config, const void* tx_buf, alt_u32 tx_len, alt_32 timeout_ms);
+lib_uart_resp_E lib_uart_tx_drain(lib_uart_config_S* config, alt_32 timeout_ms);
+alt_u32 lib_uart_tx_pending(lib_uart_config_S* config);
+void lib_uart_rx_listen(lib_uart_config_S* config, TaskHandle_t task, alt_u32 threshold, alt_16 terminator);
+bool lib_uart_rx_wait(lib_uart_config_S* config, TickType_t block_ticks);
+alt_u32 lib_uart_rx_read(lib_uart_config_S* config, void* rx_buf, alt_u32 max_len);
+alt_u32 lib_uart_rx_pending(lib_uart_config_S* config);
+void lib_uart_rx_flush(lib_uart_config_S* config);
+bool lib_uart_rx_take_error(lib_uart_config_S* config);
+alt_u32 lib_uart_rx_error_count(lib_uart_config_S* config);
+void lib_uart_get_stats(lib_uart_config_S* config, lib_uart_stats_S* stats);
+lib_uart_config_S* lib_uart_get_port(alt_u32 index);
+lib_uart_resp_E lib_uart_set_baud(lib_uart_config_S* config, alt_u32 rate);
+alt_u32 lib_uart_get_baud(lib_uart_config_S* config);
 
 #endif /* LIB_UART_H_ */
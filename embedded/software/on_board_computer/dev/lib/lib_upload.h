@@ -0,0 +1,74 @@
+/**
+ * @file lib_upload.h
+ * @author Emery Nagy
+ * @brief Framed binary image upload protocol for raw TCP sockets
+ * @version 0.1
+ * @date 2023-04-17
+ *
+ */
+
+#ifndef LIB_UPLOAD_H_
+#define LIB_UPLOAD_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* stdlib includes */
+#include "stdbool.h"
+
+/* Public defines */
+#define LIB_UPLOAD_MAGIC 0x5652 // "VR", starts every frame and ack
+#define LIB_UPLOAD_VERSION 1
+#define LIB_UPLOAD_HEADER_SIZE 24 // frame header, the payload follows it
+#define LIB_UPLOAD_ACK_SIZE 16
+#define LIB_UPLOAD_FLAG_LAST 0x01 // frame ends the image, offset + length is the image size
+
+/**
+ * Frame header, every field big endian:
+ *   0 magic u16 | 2 version u8 | 3 flags u8 | 4 device id u32 | 8 image id u32 | 12 offset u32 | 16 length u16 |
+ *   18 reserved u16 | 20 crc u32
+ * The CRC-32 (zlib polynomial) covers the first 20 header bytes and then the payload.
+ *
+ * Ack, sent by the receiver once an image is complete or as soon as it sees a bad or missing frame:
+ *   0 magic u16 | 2 version u8 | 3 status u8 | 4 device id u32 | 8 image id u32 | 12 next offset u32
+ */
+
+/* Public types */
+
+/**
+ * @brief protocol result enum
+ *
+ */
+typedef enum {
+    LIB_UPLOAD_SUCCESS,
+    LIB_UPLOAD_ERROR
+} lib_upload_result_E;
+
+/**
+ * @brief ack status
+ *
+ */
+typedef enum {
+    LIB_UPLOAD_ACK_COMPLETE = 0, // every byte of the image arrived intact
+    LIB_UPLOAD_ACK_RESEND = 1 // a frame was bad or missing, send again from the next offset
+} lib_upload_ack_status_E;
+
+/**
+ * @brief decoded receiver ack
+ *
+ */
+typedef struct {
+    lib_upload_ack_status_E status;
+    alt_u32 device;
+    alt_u32 image;
+    /* bytes the receiver holds without a gap, ie where sending resumes */
+    alt_u32 next;
+} lib_upload_ack_S;
+
+/* Public API */
+alt_u32 lib_upload_crc32(alt_u32 crc, const alt_u8* data, alt_u32 len);
+void lib_upload_encode_header(alt_u8* header, alt_u32 device, alt_u32 image, alt_u32 offset, const alt_u8* data,
+                                                                                            alt_u16 len, bool last);
+lib_upload_result_E lib_upload_decode_ack(const alt_u8* buf, alt_u32 len, lib_upload_ack_S* ack);
+
+#endif /* LIB_UPLOAD_H_ */
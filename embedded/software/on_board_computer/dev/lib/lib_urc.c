@@ -0,0 +1,191 @@
+/**
+ * @file lib_urc.c
+ * @author Emery Nagy
+ * @brief Unsolicited result code dispatcher, assembles lines from the UART RX irq and routes them to handlers by prefix
+ * @version 0.1
+ * @date 2023-04-12
+ *
+ */
+
+/* stdlib includes */
+#include "string.h"
+
+/* lib includes */
+#include "lib_urc.h"
+
+
+/* Private API */
+
+/**
+ * @brief check a line against a prefix
+ *
+ * @param line line text
+ * @param len line length
+ * @param match prefix
+ * @return true if the line starts with the prefix
+ */
+static bool lib_urc_starts_with(const char* line, alt_u32 len, const lib_urc_prefix_S* match) {
+    return (len >= match->len) && (memcmp(line, match->prefix, match->len) == 0);
+}
+
+/**
+ * @brief decide what happens to a finished line, runs in the irq
+ *
+ * @param urc dispatcher
+ * @param line finished line
+ * @return true if the line was queued
+ */
+static bool lib_urc_commit(lib_urc_S* urc, lib_urc_line_S* line) {
+    alt_u32 len = urc->fill;
+
+    for (alt_u32 i = 0; i < urc->claim_count; i++) {
+        if (lib_urc_starts_with(line->text, len, &urc->claims[i])) {
+            return false;
+        }
+    }
+
+    for (alt_u32 i = 0; i < urc->handler_count; i++) {
+        if (lib_urc_starts_with(line->text, len, &urc->handlers[i].match)) {
+            line->text[len] = '\0';
+            line->len = len;
+            line->handler = i;
+            urc->head++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/* Public API */
+
+/**
+ * @brief reset a dispatcher, no handlers or claims
+ *
+ * @param urc dispatcher to initialize
+ */
+void lib_urc_init(lib_urc_S* urc) {
+    urc->head = 0;
+    urc->tail = 0;
+    urc->fill = 0;
+    urc->discard = false;
+    urc->handler_count = 0;
+    urc->claim_count = 0;
+    urc->overflows = 0;
+}
+
+/**
+ * @brief route lines starting with prefix to a handler, handlers are checked in registration order and the first
+ *        match wins. Handlers can not be removed.
+ *
+ * @param urc dispatcher
+ * @param prefix line prefix, must stay valid for the life of the dispatcher
+ * @param handler called from the dispatching task
+ * @param ctx passed to the handler
+ * @return lib_urc_result_E LIB_URC_ERROR if the handler table is full
+ */
+lib_urc_result_E lib_urc_register(lib_urc_S* urc, const char* prefix, lib_urc_handler handler, void* ctx) {
+    alt_u32 count = urc->handler_count;
+    if (count >= LIB_URC_MAX_HANDLERS) {
+        return LIB_URC_ERROR;
+    }
+
+    /* fill the entry in before the irq can see it */
+    urc->handlers[count].match.prefix = prefix;
+    urc->handlers[count].match.len = strlen(prefix);
+    urc->handlers[count].handler = handler;
+    urc->handlers[count].ctx = ctx;
+    urc->handler_count = count + 1;
+
+    return LIB_URC_SUCCESS;
+}
+
+/**
+ * @brief hold lines starting with prefix back from dispatch, the pending command reads them itself. Call with no
+ *        command listening or before the command is sent.
+ *
+ * @param urc dispatcher
+ * @param prefix line prefix, must stay valid until lib_urc_release
+ * @param len prefix length
+ * @return lib_urc_result_E LIB_URC_ERROR if too many prefixes are claimed
+ */
+lib_urc_result_E lib_urc_claim(lib_urc_S* urc, const char* prefix, alt_u32 len) {
+    alt_u32 count = urc->claim_count;
+    if (count >= LIB_URC_MAX_CLAIMS) {
+        return LIB_URC_ERROR;
+    }
+
+    urc->claims[count].prefix = prefix;
+    urc->claims[count].len = len;
+    urc->claim_count = count + 1;
+
+    return LIB_URC_SUCCESS;
+}
+
+/**
+ * @brief drop every claim once the pending command has completed
+ *
+ * @param urc dispatcher
+ */
+void lib_urc_release(lib_urc_S* urc) {
+    urc->claim_count = 0;
+}
+
+/**
+ * @brief feed one received byte, call from the UART RX irq. Carriage returns are dropped and a newline ends the line.
+ *
+ * @param urc dispatcher
+ * @param c received byte
+ * @return true if a line was queued and the dispatching task should be woken
+ */
+bool lib_urc_feed(lib_urc_S* urc, alt_u8 c) {
+    bool queued = false;
+
+    if (c == '\r') {
+        return false;
+    }
+
+    /* lines are built straight in the next free slot, a full queue drops the whole line */
+    if (urc->fill == 0) {
+        urc->discard = ((urc->head - urc->tail) >= LIB_URC_QUEUE_DEPTH);
+    }
+    lib_urc_line_S* line = &urc->lines[urc->head & (LIB_URC_QUEUE_DEPTH - 1)];
+
+    if (c == '\n') {
+        /* blank lines between responses are skipped */
+        if ((urc->fill != 0) && urc->discard) {
+            urc->overflows++;
+        } else if (urc->fill != 0) {
+            queued = lib_urc_commit(urc, line);
+        }
+        urc->fill = 0;
+    } else if (urc->fill < (LIB_URC_LINE_SIZE - 1)) {
+        if (!urc->discard) {
+            line->text[urc->fill] = c;
+        }
+        urc->fill++;
+    }
+
+    return queued;
+}
+
+/**
+ * @brief run the handlers for every queued line, call from the dispatching task
+ *
+ * @param urc dispatcher
+ * @return alt_u32 number of lines dispatched
+ */
+alt_u32 lib_urc_dispatch(lib_urc_S* urc) {
+    alt_u32 count = 0;
+
+    while (urc->tail != urc->head) {
+        lib_urc_line_S* line = &urc->lines[urc->tail & (LIB_URC_QUEUE_DEPTH - 1)];
+        lib_urc_entry_S* entry = &urc->handlers[line->handler];
+        entry->handler(line->text, line->len, entry->ctx);
+        urc->tail++;
+        count++;
+    }
+
+    return count;
+}
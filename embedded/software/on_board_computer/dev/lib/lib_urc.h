@@ -0,0 +1,108 @@
+/**
+ * @file lib_urc.h
+ * @author Emery Nagy
+ * @brief Unsolicited result code dispatcher, assembles lines from the UART RX irq and routes them to handlers by prefix
+ * @version 0.1
+ * @date 2023-04-12
+ *
+ */
+
+#ifndef LIB_URC_H_
+#define LIB_URC_H_
+
+/* HAL includes */
+#include "alt_types.h"
+
+/* stdlib includes */
+#include "stdbool.h"
+
+/* Public defines */
+#define LIB_URC_LINE_SIZE 96 // longest line kept including the null terminator, longer lines are truncated
+#define LIB_URC_QUEUE_DEPTH 8 // lines waiting for dispatch, must be a power of 2
+#define LIB_URC_MAX_HANDLERS 8
+#define LIB_URC_MAX_CLAIMS 4 // prefixes the pending command can hold back from dispatch
+
+/* Public types */
+
+/**
+ * @brief URC handler, called from task context with the line stripped of its line ending
+ *
+ * @param line null terminated line
+ * @param len line length
+ * @param ctx context given at registration
+ */
+typedef void (*lib_urc_handler)(const char* line, alt_u32 len, void* ctx);
+
+/**
+ * @brief URC dispatcher result enum
+ *
+ */
+typedef enum {
+    LIB_URC_SUCCESS,
+    LIB_URC_ERROR
+} lib_urc_result_E;
+
+/**
+ * @brief line prefix
+ *
+ */
+typedef struct {
+    const char* prefix;
+    alt_u32 len;
+} lib_urc_prefix_S;
+
+/**
+ * @brief registered handler
+ *
+ */
+typedef struct {
+    lib_urc_prefix_S match;
+    lib_urc_handler handler;
+    void* ctx;
+} lib_urc_entry_S;
+
+/**
+ * @brief one queued line
+ *
+ */
+typedef struct {
+    char text[LIB_URC_LINE_SIZE];
+    alt_u32 len;
+    /* handler the line matched when it was queued */
+    alt_u32 handler;
+} lib_urc_line_S;
+
+/**
+ * @brief line dispatcher. Lines are assembled in place in the queue by the UART RX irq, so nothing is copied. Only
+ *        lines that match a handler and are not claimed by the pending command are queued, the rest are dropped as
+ *        they end.
+ *
+ */
+typedef struct {
+    /* line queue, head is only written by the irq and tail only by the dispatching task */
+    lib_urc_line_S lines[LIB_URC_QUEUE_DEPTH];
+    volatile alt_u32 head;
+    volatile alt_u32 tail;
+    /* bytes in the line being assembled */
+    alt_u32 fill;
+    /* queue was full when the current line started, it is dropped */
+    bool discard;
+    /* handlers, only ever appended to so the irq can walk the table while one is being added */
+    lib_urc_entry_S handlers[LIB_URC_MAX_HANDLERS];
+    volatile alt_u32 handler_count;
+    /* prefixes that belong to the pending command */
+    lib_urc_prefix_S claims[LIB_URC_MAX_CLAIMS];
+    volatile alt_u32 claim_count;
+    /* lines dropped because the queue was full */
+    volatile alt_u32 overflows;
+} lib_urc_S;
+
+/* Public API */
+void lib_urc_init(lib_urc_S* urc);
+lib_urc_result_E lib_urc_register(lib_urc_S* urc, const char* prefix, lib_urc_handler handler, void* ctx);
+lib_urc_result_E lib_urc_claim(lib_urc_S* urc, const char* prefix, alt_u32 len);
+void lib_urc_release(lib_urc_S* urc);
+bool lib_urc_feed(lib_urc_S* urc, alt_u8 c);
+alt_u32 lib_urc_dispatch(lib_urc_S* urc);
+
+#endif /* LIB_URC_H_ */
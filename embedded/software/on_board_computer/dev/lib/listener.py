@@ -1,11 +1,107 @@
-#! /usr/bin/python
-# a simple tcp server
-import socket,os
-sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-sock.bind(('', 12000))
-sock.listen(1)
-while True:
-    connection,address = sock.accept()
-    buf = connection.recv(25000)
-    print(buf)
-    connection.close()
\ No newline at end of file
+#! /usr/bin/python3
+# reference receiver for the framed image upload (lib_upload), tcp port 12000
+#
+# frame: 24 byte big endian header then the payload
+#   magic u16 | version u8 | flags u8 | device u32 | image u32 | offset u32 | length u16 | reserved u16 | crc u32
+#   crc is zlib.crc32 over the first 20 header bytes and then the payload
+# ack: 16 bytes, only sent once an image is complete or a frame is bad or missing
+#   magic u16 | version u8 | status u8 | device u32 | image u32 | next offset u32
+import socketserver, struct, threading, zlib
+
+PORT = 12000
+MAGIC = 0x5652
+VERSION = 1
+FLAG_LAST = 0x01
+ACK_COMPLETE = 0
+ACK_RESEND = 1
+HEADER = struct.Struct('>HBBIIIHHI')
+ACK = struct.Struct('>HBBIII')
+
+# images being reassembled, kept across connections so a device can reconnect and carry on
+images = {}
+lock = threading.Lock()
+
+
+class Image:
+    def __init__(self):
+        self.data = bytearray()
+        self.next = 0  # bytes held without a gap
+        self.size = None  # known once the last frame arrived
+        self.nacked = False  # a resend was asked for, wait for the frame at next before asking again
+
+
+def recv_exact(conn, n):
+    buf = b''
+    while len(buf) < n:
+        part = conn.recv(n - len(buf))
+        if not part:
+            return None
+        buf += part
+    return buf
+
+
+class Handler(socketserver.BaseRequestHandler):
+    def ack(self, status, device, image, next):
+        self.request.sendall(ACK.pack(MAGIC, VERSION, status, device, image, next))
+
+    def handle(self):
+        while True:
+            header = recv_exact(self.request, HEADER.size)
+            if header is None:
+                return
+            magic, version, flags, device, image_id, offset, length, _, crc = HEADER.unpack(header)
+            if (magic != MAGIC) or (version != VERSION):
+                # out of step with the stream, drop the connection and let the device open a new one
+                print('bad frame header from', self.client_address)
+                return
+            payload = recv_exact(self.request, length)
+            if payload is None:
+                return
+
+            with lock:
+                key = (device, image_id)
+                # the first frame of an image starts it over, ie a device that restarted and reuses ids
+                if (offset == 0) or (key not in images):
+                    images[key] = Image()
+                img = images[key]
+
+                if zlib.crc32(payload, zlib.crc32(header[:20])) != crc:
+                    print('crc error', key, offset)
+                    if not img.nacked:
+                        img.nacked = True
+                        self.ack(ACK_RESEND, device, image_id, img.next)
+                    continue
+
+                if offset > img.next:
+                    # a frame went missing, ask once for everything from the gap on
+                    if not img.nacked:
+                        img.nacked = True
+                        self.ack(ACK_RESEND, device, image_id, img.next)
+                    continue
+
+                img.nacked = False
+                end = offset + length
+                if len(img.data) < end:
+                    img.data.extend(bytes(end - len(img.data)))
+                img.data[offset:end] = payload
+                img.next = max(img.next, end)
+                if flags & FLAG_LAST:
+                    img.size = end
+
+                if (img.size is not None) and (img.next >= img.size):
+                    name = 'image_%d_%d.jpg' % key
+                    with open(name, 'wb') as f:
+                        f.write(img.data[:img.size])
+                    print('received', name, img.size, 'bytes')
+                    self.ack(ACK_COMPLETE, device, image_id, img.size)
+                    del images[key]
+
+
+class Server(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+if __name__ == '__main__':
+    with Server(('', PORT), Handler) as server:
+        server.serve_forever()
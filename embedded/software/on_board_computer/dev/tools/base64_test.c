@@ -0,0 +1,308 @@
+/**
+ * @file base64_test.c
+ * @author Emery Nagy
+ * @brief Host fuzz test and micro-benchmark for lib_base64, built once for the table path and once with -mssse3
+ * @version 0.1
+ * @date 2023-04-18
+ *
+ * ./base64_test fuzz [iterations] [seed]   every encoder against a reference encoder on random inputs
+ * ./base64_test bench                      MB/s of the old encoder and of the path this binary was built with
+ *
+ * Only the table and SSSE3 paths exist. No AVX2 or SWAR kernel was written: the Nios II has no use for either and
+ * SSSE3 is on every host the offline tools run on, so there is nothing else to test here yet.
+ */
+
+/* stdlib includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* FreeRTOS includes, the host build maps the heap onto malloc */
+#include "FreeRTOS.h"
+
+/* lib includes */
+#include "lib_base64.h"
+
+/* defines */
+#define BASE64_TEST_MAX_INPUT 4096 // largest fuzz input
+#define BASE64_TEST_MAX_CHUNK 200 // largest streaming piece
+#define BASE64_TEST_ITERATIONS 20000
+#define BASE64_TEST_BENCH_SIZE (1024 * 1024)
+#define BASE64_TEST_BENCH_SECONDS 0.5
+
+#if defined(__SSSE3__)
+#define BASE64_TEST_PATH "ssse3"
+#else
+#define BASE64_TEST_PATH "table"
+#endif
+
+/* streaming output */
+typedef struct {
+    alt_u8* buf;
+    alt_u32 len;
+    alt_u32 size;
+} base64_test_sink_S;
+
+static const char base64_test_alphabet[] = {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+
+/**
+ * @brief reference encoder, one output character at a time straight from the bit positions
+ *
+ * @param in input
+ * @param len input length
+ * @param out LIB_BASE64_ENCODED_SIZE(len) characters
+ */
+static void base64_test_reference(const alt_u8* in, alt_u32 len, alt_u8* out) {
+    alt_u32 chars = LIB_BASE64_ENCODED_SIZE(len);
+    for (alt_u32 c = 0; c < chars; c++) {
+        alt_u32 bit = c * 6;
+        if (bit >= len * 8) {
+            out[c] = '=';
+            continue;
+        }
+        alt_u32 value = 0;
+        for (alt_u32 b = bit; b < bit + 6; b++) {
+            alt_u32 byte = b / 8;
+            alt_u32 set = (byte < len) ? ((in[byte] >> (7 - (b % 8))) & 1) : 0;
+            value = (value << 1) | set;
+        }
+        out[c] = base64_test_alphabet[value];
+    }
+}
+
+/**
+ * @brief the encoder lib_base64 used before the table kernel, kept as the benchmark baseline
+ *
+ * @param in input
+ * @param len input length
+ * @param out LIB_BASE64_ENCODED_SIZE(len) characters
+ */
+static void base64_test_old(const alt_u8* in, alt_u32 len, alt_u8* out) {
+    alt_u32 i = 0;
+    alt_u32 o = 0;
+
+    for (; (i + 3) <= len; i += 3) {
+        out[o++] = base64_test_alphabet[(in[i] & 0b11111100) >> 2];
+        out[o++] = base64_test_alphabet[((in[i] & 0b00000011) << 4) | ((in[i + 1] & 0b11110000) >> 4)];
+        out[o++] = base64_test_alphabet[((in[i + 1] & 0b00001111) << 2) | ((in[i + 2] & 0b11000000) >> 6)];
+        out[o++] = base64_test_alphabet[in[i + 2] & 0b00111111];
+    }
+
+    if ((len - i) == 1) {
+        out[o++] = base64_test_alphabet[(in[i] & 0b11111100) >> 2];
+        out[o++] = base64_test_alphabet[(in[i] & 0b00000011) << 4];
+        out[o++] = '=';
+        out[o++] = '=';
+    } else if ((len - i) == 2) {
+        out[o++] = base64_test_alphabet[(in[i] & 0b11111100) >> 2];
+        out[o++] = base64_test_alphabet[((in[i] & 0b00000011) << 4) | ((in[i + 1] & 0b11110000) >> 4)];
+        out[o++] = base64_test_alphabet[(in[i + 1] & 0b00001111) << 2];
+        out[o++] = '=';
+    }
+}
+
+/**
+ * @brief streaming sink collecting the encoded text
+ *
+ * @param data encoded text
+ * @param len number of characters
+ * @param sink_ctx base64_test_sink_S
+ * @return true if it fit
+ */
+static bool base64_test_sink(const alt_u8* data, alt_u32 len, void* sink_ctx) {
+    base64_test_sink_S* sink = (base64_test_sink_S*)sink_ctx;
+    if ((sink->len + len) > sink->size) {
+        return false;
+    }
+    memcpy(sink->buf + sink->len, data, len);
+    sink->len += len;
+    return true;
+}
+
+/**
+ * @brief encode with random sized pieces through the streaming encoder
+ *
+ * @param in input
+ * @param len input length
+ * @param sink output
+ * @param chunk_max largest piece, 0 for the whole input in one piece
+ * @return true unless the encoder failed
+ */
+static bool base64_test_stream(const alt_u8* in, alt_u32 len, base64_test_sink_S* sink, alt_u32 chunk_max) {
+    lib_base64_ctx_S ctx;
+    lib_base64_init(&ctx, base64_test_sink, sink);
+
+    alt_u32 i = 0;
+    while (i < len) {
+        alt_u32 piece = (chunk_max == 0) ? len : (alt_u32)(rand() % (chunk_max + 1));
+        if (piece > len - i) {
+            piece = len - i;
+        }
+        if (!lib_base64_update(&ctx, in + i, piece)) {
+            return false;
+        }
+        i += piece;
+    }
+
+    return lib_base64_final(&ctx) && (ctx.encoded == sink->len);
+}
+
+/**
+ * @brief report the first difference from the reference
+ *
+ * @param name encoder
+ * @param len input length
+ * @param expect reference output
+ * @param got encoder output
+ * @param got_len encoder output length
+ * @return true if they match
+ */
+static bool base64_test_check(const char* name, alt_u32 len, const alt_u8* expect, const alt_u8* got, alt_u32 got_len) {
+    alt_u32 want = LIB_BASE64_ENCODED_SIZE(len);
+    if ((got_len == want) && (memcmp(expect, got, want) == 0)) {
+        return true;
+    }
+    printf("FAIL %s, input %u bytes: got %u characters, expected %u\n", name, (unsigned int)len, (unsigned int)got_len,
+                                                                                                (unsigned int)want);
+    return false;
+}
+
+/**
+ * @brief compare every encoder with the reference on random inputs
+ *
+ * @param iterations number of inputs
+ * @param seed random seed
+ * @return int process exit code
+ */
+static int base64_test_fuzz(alt_u32 iterations, unsigned int seed) {
+    static alt_u8 in[BASE64_TEST_MAX_INPUT];
+    static alt_u8 expect[LIB_BASE64_ENCODED_SIZE(BASE64_TEST_MAX_INPUT) + 1];
+    static alt_u8 out[LIB_BASE64_ENCODED_SIZE(BASE64_TEST_MAX_INPUT) + 1];
+
+    srand(seed);
+    printf("fuzz %s: %u inputs, seed %u\n", BASE64_TEST_PATH, (unsigned int)iterations, seed);
+
+    for (alt_u32 n = 0; n < iterations; n++) {
+        /* mostly short inputs so every tail and carry case comes up often, sometimes long ones for the wide kernel */
+        alt_u32 len = (rand() % 4) ? (alt_u32)(rand() % 64) : (alt_u32)(rand() % (BASE64_TEST_MAX_INPUT + 1));
+        for (alt_u32 i = 0; i < len; i++) {
+            in[i] = (alt_u8)rand();
+        }
+        alt_u32 want = LIB_BASE64_ENCODED_SIZE(len);
+        base64_test_reference(in, len, expect);
+
+        /* heap */
+        alt_u32 heap_len = 0;
+        unsigned char* heap = lib_base64_encode(in, len, &heap_len);
+        bool ok = base64_test_check("heap", len, expect, heap, heap_len) && (heap[heap_len] == '\0');
+        vPortFree(heap);
+
+        /* static, exactly big enough and one byte short */
+        alt_u32 static_len = 0;
+        memset(out, 0xAA, sizeof(out));
+        ok = ok && lib_base64_encode_static(in, len, &static_len, out, want + 1) &&
+                    base64_test_check("static", len, expect, out, static_len) && (out[static_len] == '\0');
+        ok = ok && !lib_base64_encode_static(in, len, &static_len, out, want);
+
+        /* streaming, random pieces and the whole input at once */
+        base64_test_sink_S sink = {out, 0, want};
+        ok = ok && base64_test_stream(in, len, &sink, BASE64_TEST_MAX_CHUNK) &&
+                    base64_test_check("stream", len, expect, out, sink.len);
+        sink.len = 0;
+        ok = ok && base64_test_stream(in, len, &sink, 0) && base64_test_check("stream whole", len, expect, out, sink.len);
+
+        /* baseline */
+        base64_test_old(in, len, out);
+        ok = ok && base64_test_check("old", len, expect, out, want);
+
+        if (!ok) {
+            printf("FAIL at input %u\n", (unsigned int)n);
+            return 1;
+        }
+    }
+
+    printf("PASS\n");
+    return 0;
+}
+
+/**
+ * @brief seconds on the monotonic clock
+ *
+ * @return double seconds
+ */
+static double base64_test_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/**
+ * @brief time an encoder over the bench buffer until BASE64_TEST_BENCH_SECONDS have passed
+ *
+ * @param name encoder
+ * @param which 0 old, 1 static, 2 streaming
+ * @param in input
+ * @param out output
+ */
+static void base64_test_time(const char* name, int which, alt_u8* in, alt_u8* out) {
+    alt_u32 out_size = LIB_BASE64_ENCODED_SIZE(BASE64_TEST_BENCH_SIZE) + 1;
+    alt_u32 rounds = 0;
+    double start = base64_test_now();
+    double elapsed;
+
+    do {
+        alt_u32 out_len = 0;
+        if (which == 0) {
+            base64_test_old(in, BASE64_TEST_BENCH_SIZE, out);
+        } else if (which == 1) {
+            lib_base64_encode_static(in, BASE64_TEST_BENCH_SIZE, &out_len, out, out_size);
+        } else {
+            base64_test_sink_S sink = {out, 0, out_size};
+            base64_test_stream(in, BASE64_TEST_BENCH_SIZE, &sink, 0);
+        }
+        rounds++;
+    } while ((elapsed = base64_test_now() - start) < BASE64_TEST_BENCH_SECONDS);
+
+    printf("  %-16s %8.1f MB/s\n", name, (rounds * (double)BASE64_TEST_BENCH_SIZE) / (elapsed * 1e6));
+}
+
+/**
+ * @brief input MB/s of every encoder
+ *
+ * @return int process exit code
+ */
+static int base64_test_bench(void) {
+    alt_u8* in = malloc(BASE64_TEST_BENCH_SIZE);
+    alt_u8* out = malloc(LIB_BASE64_ENCODED_SIZE(BASE64_TEST_BENCH_SIZE) + 1);
+    if ((in == NULL) || (out == NULL)) {
+        return 1;
+    }
+    srand(1);
+    for (alt_u32 i = 0; i < BASE64_TEST_BENCH_SIZE; i++) {
+        in[i] = (alt_u8)rand();
+    }
+
+    printf("bench %s, %u byte input:\n", BASE64_TEST_PATH, (unsigned int)BASE64_TEST_BENCH_SIZE);
+    base64_test_time("old", 0, in, out);
+    base64_test_time(BASE64_TEST_PATH, 1, in, out);
+    base64_test_time(BASE64_TEST_PATH " stream", 2, in, out);
+
+    free(in);
+    free(out);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if ((argc >= 2) && (strcmp(argv[1], "fuzz") == 0)) {
+        alt_u32 iterations = (argc >= 3) ? (alt_u32)strtoul(argv[2], NULL, 10) : BASE64_TEST_ITERATIONS;
+        unsigned int seed = (argc >= 4) ? (unsigned int)strtoul(argv[3], NULL, 10) : (unsigned int)time(NULL);
+        return base64_test_fuzz(iterations, seed);
+    } else if ((argc >= 2) && (strcmp(argv[1], "bench") == 0)) {
+        return base64_test_bench();
+    }
+
+    printf("usage: %s fuzz [iterations] [seed] | bench\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file FreeRTOS.h
+ * @author Emery Nagy
+ * @brief Host stand-in for the FreeRTOS heap, lets the offline tools build lib files that allocate
+ * @version 0.1
+ * @date 2023-04-18
+ *
+ */
+
+#ifndef HOST_FREERTOS_H_
+#define HOST_FREERTOS_H_
+
+#include <stdlib.h>
+
+#define pvPortMalloc(size) malloc(size)
+#define vPortFree(ptr) free(ptr)
+
+#endif /* HOST_FREERTOS_H_ */
@@ -17,11 +17,14 @@
 #include "app_demo.h"
 #include "lib_lte.h"
 #include "lib_lte_cmd.h"
+#include "lib_uart.h"
 #include "string.h"
 
 
 /* defines */
 #define SYS_HEARTBEAT_PRINT_THREAD_STATUS 1
+#define SYS_HEARTBEAT_PRINT_UART_STATS 1
+#define SYS_HEARTBEAT_UART_STATS_PERIOD 10 // heartbeats between UART link reports
 
 /* private functions for bit manipulations */
 
@@ -61,12 +64,35 @@ static inline int toggle_bit(int n, int k)
     return (n ^ (1 << (k - 1)));
 }
 
+/**
+ * @brief print one compact line of link statistics per UART port, used to tune baud rates and chunk sizes, followed
+ *        by memory pool occupancy
+ *
+ */
+static void sys_report_uart_stats(void) {
+	lib_uart_config_S* port;
+	for (alt_u32 i = 0; (port = lib_uart_get_port(i)) != NULL; i++) {
+		lib_uart_stats_S stats;
+		lib_uart_get_stats(port, &stats);
+		printf("UART %s %lu -> RX:%lu TX:%lu DROP:%lu PE:%lu FE:%lu ROE:%lu IRQ:%lu MAXCYC:%lu HWM:%lu/%lu\n",
+				port->name, lib_uart_get_baud(port), stats.rx_bytes, stats.tx_bytes, stats.rx_dropped,
+				stats.parity_errors, stats.framing_errors, stats.overrun_errors, stats.isr_count,
+				stats.isr_max_cycles, stats.rx_ring_high_water, stats.tx_ring_high_water);
+	}
+
+	lib_pool_stats_S pool;
+	app_camera_get_stream_pool_stats(&pool);
+	printf("POOL camera_stream -> USED:%lu/%lu HWM:%lu FAIL:%lu\n", pool.used, pool.block_count, pool.high_water,
+			pool.failures);
+}
+
 /**
  * @brief system heartbeat task, responsible for lighting indications and also
  *
  * @param p
  */
 void sys_heartbeat(void *p) {
+	alt_u32 beats = 0;
 	while (1) {
 		volatile unsigned int c_led = *((volatile unsigned int *)LEDS_BASE);
 		c_led = toggle_bit(c_led, 1);
@@ -106,6 +132,13 @@ void sys_heartbeat(void *p) {
 	printf("DEVICE MASTER STATE %d\n\n", state);
 #endif
 
+	/* UART link statistics */
+#if (SYS_HEARTBEAT_PRINT_UART_STATS == 1)
+	if ((++beats % SYS_HEARTBEAT_UART_STATS_PERIOD) == 0) {
+		sys_report_uart_stats();
+	}
+#endif
+
 	vTaskDelay(pdMS_TO_TICKS(1000));
 	}
 
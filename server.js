@@ -22,11 +22,16 @@ const client = new MongoClient(uri);
 
 const app = express();
 const port = 8081;
+// scooters keep their http connection open between check ins, idle sockets must outlive the check in period
+const keepAliveTimeoutMs = 65000;
+// largest frame the scooter camera can hold (APP_CAMERA_FRAME_STORE_SIZE), no upload can announce more
+const maxImageSize = 128 * 1024;
 const host = '20.238.80.71';
 //const host = '127.0.0.1';
 
 var jsonParser = bodyParser.json();
 var urlParser = bodyParser.urlencoded({ extended: true });
+var rawParser = bodyParser.raw({ type: 'application/octet-stream', limit: '64kb' });
 
 
 app.use(jsonParser);
@@ -261,6 +266,62 @@ app.post("/update_user_location", async (req, res) =>{
 
 
 
+// Raw JPEG bytes from scooters in binary upload mode, one Buffer per scooter
+var binaryImages = new Map();
+
+// Binary variant of /checkFace: every chunk is an application/octet-stream body and the headers say where it goes,
+// anything else falls through to the urlencoded base64 handler below
+app.post("/checkFace", rawParser, async (req, res, next)=>{
+	if(!req.is('application/octet-stream'))
+		return next();
+
+	try{
+		let currentScooter = req.get('X-Scooter-Id');
+		let imageSize = parseInt(req.get('X-Image-Size'));
+		let offset = parseInt(req.get('X-Image-Offset'));
+		let chunk = req.body;
+
+		if(currentScooter === undefined || isNaN(imageSize) || isNaN(offset) || !Buffer.isBuffer(chunk)){
+			res.status(400).send("Invalid chunk*");
+			return;
+		}
+
+		// The announced size is allocated up front, so it has to fit a frame before anything is allocated
+		if(imageSize <= 0 || imageSize > maxImageSize){
+			res.status(400).send("Invalid image size*");
+			return;
+		}
+
+		// The first chunk starts a new image sized to what the scooter announced
+		let image = binaryImages.get(currentScooter);
+		if(offset === 0 || image === undefined){
+			image = { data: Buffer.alloc(imageSize), end: 0 };
+			binaryImages.set(currentScooter, image);
+		}
+
+		// Chunks are written in place so a repeated one is harmless, but they can't leave a gap or overrun
+		if(offset > image.end || offset + chunk.length > image.data.length){
+			res.status(400).send("Invalid chunk*");
+			return;
+		}
+		chunk.copy(image.data, offset);
+		image.end = Math.max(image.end, offset + chunk.length);
+
+		// The final chunk reports the real image size, it can be smaller than the one announced
+		if(offset + chunk.length === imageSize){
+			console.log("final chunk!");
+			binaryImages.delete(currentScooter);
+			processScooterFace(currentScooter, image.data.subarray(0, imageSize), null);
+			res.status(200).send("Final Chunk*");
+		} else {
+			res.status(200).send("Chunk " + offset + " recieved*");
+		}
+	}catch(err){
+		console.log(err)
+		res.status(400).send("An error occured*");
+	}
+});
+
 var size = new Map();	
 var oldKey = new Map(); 
 
@@ -325,38 +386,9 @@ app.post("/checkFace", urlParser, async (req, res)=>{
 								if(err) console.log(err);
 
 								// Write the image using the base64 string 
-								fs.writeFile("./scooterFacesJPG/" + currentScooter + "/checkFace.jpg", data, {encoding: 'base64'}, function(err){
-									if(err)
-										console.log(err);
-									else{
-										console.log("file created!!");
-
-										fs.writeFileSync("./testImages" + "/checkFace" + currentScooter + ".jpg", data, {encoding: 'base64'});
-
-			
-										//clear the base64 contents of the text file	
-										fs.writeFile('./scooterFaces64/' + currentScooter + ".txt", '', () =>{console.log('done');});
-											
-
-										// Upscale the image by 200%
-										sharp("./scooterFacesJPG/" + currentScooter + "/checkFace.jpg")
-										.rotate()
-										.resize(720, 480) //200%
-										.toFile("./scooterFacesJPG/" + currentScooter + "/checkFace_upscaled.jpg", (err) => {
-											if(err) console.log(err);
-											else{
-												console.log("image upscaled");
-			
-												// delete the old image
-												fs.unlink("./scooterFacesJPG/" + currentScooter + "/checkFace.jpg", async(err)=>{if(err) throw err;
-													
-													// run facial recognition 
-													await checkFace("./scooterFacesJPG/" + currentScooter, currentScooter);
-												});
-											}
-												
-										});
-									}
+								processScooterFace(currentScooter, data, 'base64', () => {
+									//clear the base64 contents of the text file	
+									fs.writeFile('./scooterFaces64/' + currentScooter + ".txt", '', () =>{console.log('done');});
 								});
 
 							} );
@@ -476,7 +508,7 @@ app.post("/free_scooter", async (req,res) =>{
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
-app.listen(port,  () => {
+const server = app.listen(port,  () => {
 	initiate_folders();
 	initiate_scooter_users();
 	console.log(`${new Date()}  App Started. Listening on ${host}:${port}`);
@@ -488,6 +520,8 @@ app.listen(port,  () => {
 	//removeUsers();
 	//removeScooters();
 });
+server.keepAliveTimeout = keepAliveTimeoutMs;
+server.headersTimeout = keepAliveTimeoutMs + 1000;
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -678,6 +712,41 @@ async function checkFace(face_to_check, scooterId){
 	}
 };
 
+// Save the finished image from a scooter, upscale it and run facial recognition on it
+function processScooterFace(currentScooter, data, encoding, written){
+	fs.writeFile("./scooterFacesJPG/" + currentScooter + "/checkFace.jpg", data, {encoding: encoding}, function(err){
+		if(err)
+			console.log(err);
+		else{
+			console.log("file created!!");
+
+			fs.writeFileSync("./testImages" + "/checkFace" + currentScooter + ".jpg", data, {encoding: encoding});
+
+			if(written !== undefined)
+				written();
+
+			// Upscale the image by 200%
+			sharp("./scooterFacesJPG/" + currentScooter + "/checkFace.jpg")
+			.rotate()
+			.resize(720, 480) //200%
+			.toFile("./scooterFacesJPG/" + currentScooter + "/checkFace_upscaled.jpg", (err) => {
+				if(err) console.log(err);
+				else{
+					console.log("image upscaled");
+
+					// delete the old image
+					fs.unlink("./scooterFacesJPG/" + currentScooter + "/checkFace.jpg", async(err)=>{if(err) throw err;
+						
+						// run facial recognition 
+						await checkFace("./scooterFacesJPG/" + currentScooter, currentScooter);
+					});
+				}
+					
+			});
+		}
+	});
+}
+
 function isValid(username){
 	if (/\s/.test(username) || username.length > 30 || username.length < 6 || username.includes(".") || username === "unknown_person" || username === "no_persons_found"){
 		console.log("invalid");